@@ -18,6 +18,8 @@ const cors = require('cors');
 var app = express();
 
 app.set('trust proxy', 1);
+// ETags let the Qt client revalidate balance/transaction pages (304 Not Modified)
+app.set('etag', 'strong');
 app.use(logger('dev'));
 app.use(express.json());
 app.use(express.urlencoded({ extended: false }));
@@ -0,0 +1,94 @@
+const db = require('./db');
+
+// Page size of the first transactions page included in a bootstrap (matches the Qt client)
+const BOOTSTRAP_PAGE_SIZE = 10;
+
+/**
+ * Cursor for transaction pagination: "<epochMs>|<id>" (same format as /accounts/:id/transactions)
+ * @param {{created_at: Date|string, id: number}} row
+ * @returns {string}
+ */
+function makeCursor(row) {
+  const ms = row.created_at instanceof Date
+    ? row.created_at.getTime()
+    : Date.parse(String(row.created_at));
+
+  return `${ms}|${row.id}`;
+}
+
+/**
+ * First (newest) transactions page in the same shape as GET /accounts/:id/transactions.
+ * @param {number} accountId
+ * @param {number} limit
+ */
+async function loadFirstTransactionsPage(accountId, limit) {
+  const [rows] = await db.execute(
+    `SELECT t.id, t.tx_type, t.amount, t.created_at
+     FROM transactions t
+     WHERE t.account_id = ?
+     ORDER BY t.created_at DESC, t.id DESC
+     LIMIT ${limit + 1}`,
+    [accountId]
+  );
+
+  const hasMore = rows.length > limit;
+  const items = hasMore ? rows.slice(0, limit) : rows;
+
+  return {
+    items,
+    nextCursor: hasMore ? makeCursor(items[items.length - 1]) : null,
+    prevCursor: null,
+  };
+}
+
+/**
+ * Everything the client needs to render a session in one response:
+ * balances and first transactions page for every linked account, plus the customer image.
+ * @param {{role: string, accountId: number}[]} links
+ * @returns {Promise<{accounts: object[], customer: {id: number, image_filename: string|null}|null}>}
+ */
+async function loadBootstrap(links) {
+  if (links.length === 0) return { accounts: [], customer: null };
+
+  const ids = links.map(l => l.accountId);
+  const placeholders = ids.map(() => '?').join(',');
+
+  // Balances + owning customer in one query (replaces /crud/accounts -> /crud/customers)
+  const [accRows] = await db.execute(
+    `SELECT a.id, a.account_type, a.balance, a.credit_limit,
+            c.id AS customer_id, c.image_filename
+     FROM accounts a
+     JOIN customers c ON c.id = a.customer_id
+     WHERE a.id IN (${placeholders})`,
+    ids
+  );
+  const byId = new Map(accRows.map(r => [r.id, r]));
+
+  const pages = await Promise.all(ids.map(id => loadFirstTransactionsPage(id, BOOTSTRAP_PAGE_SIZE)));
+
+  const accounts = [];
+  links.forEach((l, i) => {
+    const acc = byId.get(l.accountId);
+    if (!acc) return;
+    accounts.push({
+      role: l.role,
+      accountId: l.accountId,
+      balance: {
+        id: acc.id,
+        account_type: acc.account_type,
+        balance: acc.balance,
+        credit_limit: acc.credit_limit,
+      },
+      transactions: pages[i],
+    });
+  });
+
+  const owner = accRows[0];
+  const customer = owner
+    ? { id: owner.customer_id, image_filename: owner.image_filename ?? null }
+    : null;
+
+  return { accounts, customer };
+}
+
+module.exports = { loadBootstrap, makeCursor, BOOTSTRAP_PAGE_SIZE };
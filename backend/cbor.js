@@ -0,0 +1,204 @@
+/**
+ * Minimal CBOR (RFC 8949) encoder for API responses.
+ *
+ * Covers exactly what the routes send: null, booleans, numbers, strings,
+ * Buffers, Dates, arrays and plain objects. Output follows JSON.stringify
+ * semantics (toJSON is honoured, undefined/function properties are skipped,
+ * non-finite numbers become null) with two typed extensions:
+ *   - Date              -> tag 1 (epoch seconds), instead of a 24 char ISO string
+ *   - DECIMAL strings   -> tag 4 decimal fraction [exponent, mantissa]
+ *     for the keys listed in options.decimalKeys (mysql2 returns DECIMAL as string)
+ */
+
+const CBOR_CONTENT_TYPE = 'application/cbor';
+
+const TAG_EPOCH_DATETIME = 1;
+const TAG_DECIMAL_FRACTION = 4;
+
+const DECIMAL_RE = /^(-?)(\d+)(?:\.(\d+))?$/;
+
+const MIN_SAFE = BigInt(Number.MIN_SAFE_INTEGER);
+const MAX_SAFE = BigInt(Number.MAX_SAFE_INTEGER);
+
+class Writer {
+  constructor(size = 512) {
+    this.buf = Buffer.allocUnsafe(size);
+    this.pos = 0;
+  }
+
+  reserve(n) {
+    if (this.pos + n <= this.buf.length) return;
+    let size = this.buf.length * 2;
+    while (size < this.pos + n) size *= 2;
+    const next = Buffer.allocUnsafe(size);
+    this.buf.copy(next, 0, 0, this.pos);
+    this.buf = next;
+  }
+
+  /**
+   * Initial byte + argument of a data item.
+   * @param {number} major 0..7
+   * @param {number|bigint} n non-negative
+   */
+  head(major, n) {
+    const m = major << 5;
+    this.reserve(9);
+    if (typeof n === 'bigint') {
+      this.buf[this.pos++] = m | 27;
+      this.buf.writeBigUInt64BE(n, this.pos);
+      this.pos += 8;
+    } else if (n < 24) {
+      this.buf[this.pos++] = m | n;
+    } else if (n < 0x100) {
+      this.buf[this.pos++] = m | 24;
+      this.buf[this.pos++] = n;
+    } else if (n < 0x10000) {
+      this.buf[this.pos++] = m | 25;
+      this.buf.writeUInt16BE(n, this.pos);
+      this.pos += 2;
+    } else if (n < 0x100000000) {
+      this.buf[this.pos++] = m | 26;
+      this.buf.writeUInt32BE(n, this.pos);
+      this.pos += 4;
+    } else {
+      this.buf[this.pos++] = m | 27;
+      this.buf.writeBigUInt64BE(BigInt(n), this.pos);
+      this.pos += 8;
+    }
+  }
+
+  simple(byte) {
+    this.reserve(1);
+    this.buf[this.pos++] = byte;
+  }
+
+  float64(v) {
+    this.reserve(9);
+    this.buf[this.pos++] = 0xfb;
+    this.buf.writeDoubleBE(v, this.pos);
+    this.pos += 8;
+  }
+
+  integer(v) {
+    if (typeof v === 'bigint' && v >= MIN_SAFE && v <= MAX_SAFE) v = Number(v);
+    if (v >= 0) this.head(0, v);
+    else this.head(1, typeof v === 'bigint' ? -1n - v : -1 - v);
+  }
+
+  text(s) {
+    const len = Buffer.byteLength(s, 'utf8');
+    this.head(3, len);
+    this.reserve(len);
+    this.buf.write(s, this.pos, len, 'utf8');
+    this.pos += len;
+  }
+
+  bytes(b) {
+    this.head(2, b.length);
+    this.reserve(b.length);
+    b.copy(this.buf, this.pos);
+    this.pos += b.length;
+  }
+}
+
+const UINT64_MAX = (1n << 64n) - 1n;
+
+/**
+ * "123.45" -> tag 4 [-2, 12345]. Falls back to a text string if it does not fit.
+ * @param {Writer} w
+ * @param {string} s
+ */
+function writeDecimal(w, s) {
+  const m = DECIMAL_RE.exec(s);
+  if (!m) return w.text(s);
+
+  const frac = m[3] ?? '';
+  const mantissa = BigInt(m[2] + frac);
+  if (mantissa > UINT64_MAX) return w.text(s);
+
+  w.head(6, TAG_DECIMAL_FRACTION);
+  w.head(4, 2);
+  w.integer(-frac.length);
+  w.integer(m[1] === '-' ? -mantissa : mantissa);
+}
+
+/**
+ * @param {Writer} w
+ * @param {unknown} value
+ * @param {Set<string>} decimalKeys
+ * @param {string|null} key map key the value belongs to
+ */
+function writeValue(w, value, decimalKeys, key) {
+  if (value === null || value === undefined) return w.simple(0xf6);
+
+  switch (typeof value) {
+    case 'boolean':
+      return w.simple(value ? 0xf5 : 0xf4);
+    case 'number':
+      if (Number.isSafeInteger(value)) return w.integer(value);
+      if (!Number.isFinite(value)) return w.simple(0xf6);
+      return w.float64(value);
+    case 'bigint':
+      return w.integer(value);
+    case 'string':
+      if (key !== null && decimalKeys.has(key)) return writeDecimal(w, value);
+      return w.text(value);
+    case 'function':
+    case 'symbol':
+      return w.simple(0xf6);
+    default:
+      break;
+  }
+
+  if (value instanceof Date) {
+    const ms = value.getTime();
+    if (!Number.isFinite(ms)) return w.simple(0xf6);
+    w.head(6, TAG_EPOCH_DATETIME);
+    return ms % 1000 === 0 ? w.integer(ms / 1000) : w.float64(ms / 1000);
+  }
+
+  if (Buffer.isBuffer(value)) return w.bytes(value);
+
+  if (Array.isArray(value)) {
+    w.head(4, value.length);
+    for (const item of value) writeValue(w, item, decimalKeys, null);
+    return;
+  }
+
+  if (typeof value.toJSON === 'function') {
+    return writeValue(w, value.toJSON(key ?? ''), decimalKeys, key);
+  }
+
+  const keys = Object.keys(value).filter(k => {
+    const t = typeof value[k];
+    return value[k] !== undefined && t !== 'function' && t !== 'symbol';
+  });
+  w.head(5, keys.length);
+  for (const k of keys) {
+    w.text(k);
+    writeValue(w, value[k], decimalKeys, k);
+  }
+}
+
+/**
+ * @param {unknown} value
+ * @param {{decimalKeys?: Iterable<string>}} [options]
+ * @returns {Buffer}
+ */
+function encode(value, options = {}) {
+  const decimalKeys = new Set(options.decimalKeys ?? []);
+  const w = new Writer();
+  writeValue(w, value, decimalKeys, null);
+  return w.buf.subarray(0, w.pos);
+}
+
+/**
+ * True if the client prefers CBOR over JSON (Accept: application/cbor, application/json;q=0.9).
+ * Clients without an Accept header (curl, browsers with *\/*) keep getting JSON.
+ * @param {import('express').Request} req
+ */
+function prefersCbor(req) {
+  return req.accepts(['application/json', CBOR_CONTENT_TYPE]) === CBOR_CONTENT_TYPE;
+}
+
+module.exports = { encode, prefersCbor, CBOR_CONTENT_TYPE };
@@ -0,0 +1,92 @@
+/**
+ * Note mix for a withdrawal: the fewest notes that pay the amount exactly.
+ *
+ * Same algorithm as bank-automat/DispensePlanner.h (the kiosk plans against its
+ * own cassette counts; the bank only checks that a mix exists): bounded
+ * change-making as a DP over the amount in steps of the denominations' gcd,
+ * with one row per cassette recording how many of its notes the best mix uses.
+ */
+
+/** Notes the kiosk's cassettes are fitted for, largest first. */
+const DENOMINATIONS = [50, 20];
+
+/** DP size in gcd steps: 10 000 € with 20 € / 50 € notes (DispensePlanner::MAX_STEPS). */
+const MAX_STEPS = 1000;
+
+function gcd(a, b) {
+  while (b) [a, b] = [b, a % b];
+  return a;
+}
+
+/**
+ * gcd of the fitted denominations, 0 without any.
+ * @param {{denomination:number}[]} cassettes
+ */
+function stepOf(cassettes) {
+  let step = 0;
+  for (const c of cassettes) {
+    if (c.denomination > 0) step = gcd(step, c.denomination);
+  }
+  return step;
+}
+
+/**
+ * Largest amount planDispense() looks at (DispensePlanner::maxAmount).
+ * @param {{denomination:number}[]} cassettes
+ */
+function maxAmount(cassettes) {
+  return stepOf(cassettes) * MAX_STEPS;
+}
+
+/**
+ * @param {number} amount whole euros
+ * @param {{denomination:number, count:number}[]} cassettes count Infinity = no limit
+ * @returns {{ok:true, noteCount:number, notes:number[]} | {ok:false}} notes per cassette
+ */
+function planDispense(amount, cassettes) {
+  const step = stepOf(cassettes);
+  if (!Number.isInteger(amount) || amount <= 0 || step === 0 || amount % step !== 0) return { ok: false };
+  const target = amount / step;
+  if (target > MAX_STEPS) return { ok: false };
+
+  // best[a]: fewest notes for a * step from the cassettes seen so far
+  const best = new Array(target + 1).fill(Infinity);
+  best[0] = 0;
+  // take[i][a]: notes from cassette i in that mix
+  const take = cassettes.map(() => new Uint16Array(target + 1));
+
+  cassettes.forEach((c, i) => {
+    const d = c.denomination / step;
+    if (!(d > 0) || !(c.count > 0)) return;
+    // Downwards, so best[a - k * d] is still the mix without cassette i
+    for (let a = target; a >= d; a--) {
+      const most = Math.min(c.count, Math.floor(a / d));
+      for (let k = 1; k <= most; k++) {
+        const rest = best[a - k * d];
+        if (rest + k < best[a]) {
+          best[a] = rest + k;
+          take[i][a] = k;
+        }
+      }
+    }
+  });
+  if (best[target] === Infinity) return { ok: false };
+
+  const notes = new Array(cassettes.length).fill(0);
+  let a = target;
+  for (let i = cassettes.length - 1; i >= 0; i--) {
+    notes[i] = take[i][a];
+    a -= notes[i] * (cassettes[i].denomination / step);
+  }
+  return { ok: true, noteCount: best[target], notes };
+}
+
+/**
+ * The denominations with no count limit (the bank does not know the cassettes).
+ * @returns {{denomination:number, count:number}[]}
+ */
+function unlimited(denominations = DENOMINATIONS) {
+  return denominations.map((denomination) => ({ denomination, count: Infinity }));
+}
+
+module.exports = { DENOMINATIONS, MAX_STEPS, maxAmount, planDispense, unlimited };
@@ -0,0 +1,35 @@
+/**
+ * Housekeeping for withdraw_requests.
+ *
+ * An idempotency key is only needed while a kiosk may still retry or reconcile the
+ * withdrawal. Kiosks keep unsettled withdrawals in their outbox across restarts, so
+ * the retention allows for one that stays offline for a while.
+ */
+const db = require('./db');
+
+const RETENTION_DAYS = Number(process.env.WITHDRAW_KEY_RETENTION_DAYS) || 30;
+const PRUNE_INTERVAL_MS = 6 * 60 * 60 * 1000;
+
+/**
+ * Delete keys older than `days`.
+ * @param {number} [days]
+ * @returns {Promise<number>} rows deleted
+ */
+async function pruneWithdrawRequests(days = RETENTION_DAYS) {
+  const [result] = await db.execute(
+    `DELETE FROM withdraw_requests WHERE created_at < NOW() - INTERVAL ? DAY`,
+    [days]
+  );
+  return result.affectedRows;
+}
+
+/** Prune now and then every PRUNE_INTERVAL_MS (the timer does not keep the process alive). */
+function startPruning() {
+  const run = () => {
+    pruneWithdrawRequests().catch((err) => console.error('withdraw_requests prune failed:', err));
+  };
+  run();
+  setInterval(run, PRUNE_INTERVAL_MS).unref();
+}
+
+module.exports = { RETENTION_DAYS, pruneWithdrawRequests, startPruning };
@@ -1,30 +1,185 @@
 const express = require('express');
 const router = express.Router();
 const db = require('../db');
+const { loadBootstrap, makeCursor } = require('../bootstrap');
+const cbor = require('../cbor');
+const { DENOMINATIONS, maxAmount, planDispense, unlimited } = require('../dispense');
+
+// DECIMAL columns (strings from mysql2) sent as CBOR decimal fractions
+const DECIMAL_KEYS = ['amount', 'balance', 'credit_limit'];
+
+const BANK_CASSETTES = unlimited(DENOMINATIONS);
+// Largest withdrawal the plan check takes on (10 000 €)
+const MAX_WITHDRAW_AMOUNT = maxAmount(BANK_CASSETTES);
 
 /**
- * Compute ATM bill breakdown using only 20€ and 50€ bills.
- * Prefer more 50€ bills (typical ATM behavior).
+ * Compute ATM bill breakdown using only 20€ and 50€ bills: the fewest notes,
+ * same plan as the kiosk's DispensePlanner (see ../dispense.js).
  * @param {number} amount
  * @returns {{ok:true, bills: {"50": number, "20": number}} | {ok:false}}
  */
 function computeBills(amount) {
-  // returns { ok: true, bills: { "50": x, "20": y } } or { ok:false }
-  if (!Number.isInteger(amount) || amount <= 0) return { ok: false };
-  if (amount % 10 !== 0) return { ok: false }; // quick reject
-
-  // Prefer more 50s (typical ATM behavior), but any valid combo is fine.
-  for (let fifties = Math.floor(amount / 50); fifties >= 0; fifties--) {
-    const rest = amount - 50 * fifties;
-    if (rest >= 0 && rest % 20 === 0) {
-      const twenties = rest / 20;
-      return { ok: true, bills: { "50": fifties, "20": twenties } };
-    }
+  const plan = planDispense(amount, BANK_CASSETTES);
+  if (!plan.ok) return { ok: false };
+  const bills = {};
+  DENOMINATIONS.forEach((d, i) => { bills[String(d)] = plan.notes[i]; });
+  return { ok: true, bills };
+}
+
+/**
+ * Send a body as CBOR when the client asks for it (Accept), JSON otherwise.
+ * Errors stay JSON; clients pick the decoder from Content-Type.
+ * @param {import('express').Request} req
+ * @param {import('express').Response} res
+ * @param {object} body
+ */
+function sendBody(req, res, body) {
+  res.vary('Accept');
+  if (cbor.prefersCbor(req)) {
+    res.type(cbor.CBOR_CONTENT_TYPE);
+    res.send(cbor.encode(body, { decimalKeys: DECIMAL_KEYS }));
+    return;
   }
-  return { ok: false };
+  res.json(body);
+}
+
+/**
+ * Send a body that clients may cache but must revalidate.
+ * Express derives the ETag from the body and answers If-None-Match
+ * with 304 Not Modified, so an unchanged balance/page costs no payload.
+ * @param {import('express').Request} req
+ * @param {import('express').Response} res
+ * @param {object} body
+ */
+function sendRevalidatable(req, res, body) {
+  res.set('Cache-Control', 'private, no-cache');
+  sendBody(req, res, body);
+}
+
+/**
+ * Cursor for transaction pagination: "<epochMs>|<id>"
+ * @param {string} cur
+ * @returns {{ms: number, id: number} | null}
+ */
+function parseCursor(cur) {
+  const parts = String(cur).split('|');
+  if (parts.length !== 2) return null;
+
+  const ms = Number(parts[0]);
+  const id = Number(parts[1]);
+
+  if (!Number.isFinite(ms) || ms <= 0) return null;
+  if (!Number.isInteger(id) || id <= 0) return null;
+
+  return { ms, id };
+}
+
+// Upper bound for one streamed statement (?stream=1); normal pages stay at 100
+const STREAM_MAX_ROWS = 5000;
+
+/**
+ * Stream transactions newest -> oldest, one record per row, without buffering the result.
+ * Body is a CBOR sequence (application/cbor-seq, RFC 8742) or NDJSON (application/x-ndjson):
+ * one item per row, then a trailer { end: true, count, nextCursor, prevCursor }.
+ * MySQL rows are pulled only as fast as the client reads (backpressure via 'drain').
+ * @param {import('express').Request} req
+ * @param {import('express').Response} res
+ * @param {number} accountId
+ * @param {number} limit
+ * @param {{ms: number, id: number} | null} before
+ */
+async function streamTransactions(req, res, accountId, limit, before) {
+  const useCbor = req.accepts(['application/x-ndjson', 'application/cbor-seq']) === 'application/cbor-seq';
+  const encodeItem = useCbor
+    ? (obj) => cbor.encode(obj, { decimalKeys: DECIMAL_KEYS })
+    : (obj) => JSON.stringify(obj) + '\n';
+
+  let sql = `
+    SELECT t.id, t.tx_type, t.amount, t.created_at
+    FROM transactions t
+    WHERE t.account_id = ?`;
+  const params = [accountId];
+  if (before) {
+    sql += `
+      AND (
+        t.created_at < FROM_UNIXTIME(?/1000)
+        OR (t.created_at = FROM_UNIXTIME(?/1000) AND t.id < ?)
+      )`;
+    params.push(before.ms, before.ms, before.id);
+  }
+  // One extra row tells whether there is more
+  sql += `
+    ORDER BY t.created_at DESC, t.id DESC
+    LIMIT ${limit + 1}`;
+
+  let conn;
+  try {
+    conn = await db.getConnection();
+  } catch (err) {
+    console.error('DB error in /accounts/:id/transactions (stream):', err);
+    return res.status(500).json({ error: 'Database error' });
+  }
+
+  res.vary('Accept');
+  res.set('Cache-Control', 'no-store');
+  res.type(useCbor ? 'application/cbor-seq' : 'application/x-ndjson');
+
+  // Underlying callback connection: only it can stream rows
+  const rows = conn.connection.query(sql, params).stream();
+
+  let count = 0;
+  let last = null;
+  let hasMore = false;
+  let clientGone = false;
+  let released = false;
+  const release = () => {
+    if (released) return;
+    released = true;
+    conn.release();
+  };
+
+  res.on('close', () => {
+    // Client went away: let the query drain without writing
+    if (res.writableFinished) return;
+    clientGone = true;
+    rows.resume();
+  });
+
+  rows.on('data', (row) => {
+    if (clientGone) return;
+    if (count === limit) {
+      hasMore = true;
+      return;
+    }
+    count++;
+    last = row;
+    if (!res.write(encodeItem(row))) {
+      rows.pause();
+      res.once('drain', () => rows.resume());
+    }
+  });
+
+  rows.on('error', (err) => {
+    release();
+    console.error('DB error in /accounts/:id/transactions (stream):', err);
+    // Headers are out already: cut the body so the client sees a truncated response
+    res.destroy(err);
+  });
+
+  rows.on('end', () => {
+    release();
+    if (clientGone || res.destroyed) return;
+    res.end(encodeItem({
+      end: true,
+      count,
+      nextCursor: hasMore && last ? makeCursor(last) : null,
+      prevCursor: null,
+    }));
+  });
 }
 
 // GET /accounts/:id/transactions?limit=10&before=<created_at>|<id>&after=<created_at>|<id>
+// Add &stream=1 for a streamed full statement (limit up to STREAM_MAX_ROWS)
 router.get('/:id/transactions', async (req, res) => {
   const accountId = Number(req.params.id);
   const limit = Number(req.query.limit ?? 10);
@@ -42,27 +197,14 @@ router.get('/:id/transactions', async (req, res) => {
     return res.status(400).json({ error: 'Use only one: before or after' });
   }
 
-  function parseCursor(cur) {
-    // format: "<epochMs>|<id>"
-    const parts = String(cur).split('|');
-    if (parts.length !== 2) return null;
-
-    const ms = Number(parts[0]);
-    const id = Number(parts[1]);
-
-    if (!Number.isFinite(ms) || ms <= 0) return null;
-    if (!Number.isInteger(id) || id <= 0) return null;
-
-    return { ms, id };
-  }
-
-  function makeCursor(row) {
-    // row.created_at can be Date or string
-    const ms = row.created_at instanceof Date
-      ? row.created_at.getTime()
-      : Date.parse(String(row.created_at));
+  // Full statement: rows are streamed as they come from MySQL
+  if (req.query.stream === '1') {
+    if (after) return res.status(400).json({ error: 'Streaming supports only before' });
+    const c = before ? parseCursor(before) : null;
+    if (before && !c) return res.status(400).json({ error: 'Invalid before cursor' });
 
-    return `${ms}|${row.id}`;
+    const streamLimit = Number.isInteger(limit) ? Math.min(Math.max(limit, 1), STREAM_MAX_ROWS) : STREAM_MAX_ROWS;
+    return streamTransactions(req, res, accountId, streamLimit, c);
   }
 
   try {
@@ -105,7 +247,7 @@ router.get('/:id/transactions', async (req, res) => {
       rows = r;
     } else {
       // Prev page (newer): created_at/id strictly greater than cursor
-      // We fetch ASC (oldest->newest) then reverse to keep response DESC.
+      // We fetch ASC (oldest->newest): the rows closest to the cursor, reversed below.
       const c = parseCursor(after);
       if (!c) return res.status(400).json({ error: 'Invalid after cursor' });
 
@@ -119,12 +261,14 @@ router.get('/:id/transactions', async (req, res) => {
       LIMIT ${pageSizePlusOne}
     `;
     const [r] = await db.execute(sql, [accountId, c.ms, c.ms, c.id]);
-    rows = r.reverse();
+    rows = r;
     }
 
-    // Determine hasMore in the requested direction
+    // Determine hasMore in the requested direction. For after= the extra row is the newest
+    // one, so drop it before reversing: a delta must join the cursor without a gap.
     const hasMore = rows.length > safeLimit;
     if (hasMore) rows = rows.slice(0, safeLimit);
+    if (after) rows.reverse();
 
     const items = rows;
 
@@ -139,7 +283,7 @@ router.get('/:id/transactions', async (req, res) => {
       ? makeCursor(items[0])
       : null;
 
-    res.json({
+    sendRevalidatable(req, res, {
       items,
       nextCursor, // pass as before=nextCursor
       prevCursor, // pass as after=prevCursor
@@ -150,6 +294,41 @@ router.get('/:id/transactions', async (req, res) => {
   }
 });
 
+// GET /accounts/:id/bootstrap
+// One round trip for a new session: linked accounts (via the card(s) of this account)
+// with balances and first transactions page, plus the customer image filename.
+router.get('/:id/bootstrap', async (req, res) => {
+  const accountId = Number(req.params.id);
+  if (!Number.isInteger(accountId) || accountId <= 0) {
+    return res.status(400).json({ error: 'Invalid account id' });
+  }
+
+  try {
+    const [links] = await db.execute(
+      `SELECT DISTINCT ca2.account_id, ca2.role
+       FROM card_accounts ca
+       JOIN card_accounts ca2 ON ca2.card_id = ca.card_id
+       WHERE ca.account_id = ?
+       ORDER BY FIELD(ca2.role, 'debit', 'credit')`,
+      [accountId]
+    );
+
+    let accounts = links.map(l => ({ role: l.role, accountId: l.account_id }));
+    if (accounts.length === 0) {
+      // Account not linked to any card: bootstrap just this account
+      const [rows] = await db.execute(`SELECT account_type FROM accounts WHERE id = ?`, [accountId]);
+      if (rows.length === 0) return res.status(404).json({ error: 'Account not found' });
+      accounts = [{ role: rows[0].account_type, accountId }];
+    }
+
+    res.set('Cache-Control', 'no-store');
+    sendBody(req, res, await loadBootstrap(accounts));
+  } catch (err) {
+    console.error('Bootstrap error:', err);
+    res.status(500).json({ error: 'Database error' });
+  }
+});
+
 // GET /accounts/:id/balance
 router.get('/:id/balance', async (req, res) => {
   const accountId = Number(req.params.id);
@@ -164,28 +343,101 @@ router.get('/:id/balance', async (req, res) => {
     );
     if (rows.length === 0) return res.status(404).json({ error: 'Account not found' });
 
-    res.json(rows[0]);
+    sendRevalidatable(req, res, rows[0]);
   } catch (err) {
     console.error('Balance error:', err);
     res.status(500).json({ error: 'Database error' });
   }
 });
 
+// Client-generated key of one withdrawal (Idempotency-Key header), e.g. a UUID
+const IDEMPOTENCY_KEY_RE = /^[A-Za-z0-9_-]{8,64}$/;
+
+/**
+ * Idempotency-Key header of a withdraw request.
+ * @param {import('express').Request} req
+ * @returns {{key: string|null, valid: boolean}}
+ */
+function idempotencyKeyOf(req) {
+  const key = req.get('Idempotency-Key');
+  if (key === undefined) return { key: null, valid: true };
+  return { key, valid: IDEMPOTENCY_KEY_RE.test(key) };
+}
+
+/**
+ * Stored outcome of a withdrawal key, read inside the transaction that holds the
+ * account row lock (so a concurrent request with the same key waits for it).
+ * @param {import('mysql2/promise').PoolConnection} conn
+ * @param {number} accountId
+ * @param {string} key
+ * @returns {Promise<{amount: number|null, status: number, body: object, reversed: boolean}|null>}
+ */
+async function findWithdrawOutcome(conn, accountId, key) {
+  const [rows] = await conn.execute(
+    `SELECT amount, status_code, response_body, reversed_at
+     FROM withdraw_requests
+     WHERE account_id = ? AND idempotency_key = ?`,
+    [accountId, key]
+  );
+  if (rows.length === 0) return null;
+  return {
+    amount: rows[0].amount === null ? null : Number(rows[0].amount),
+    status: rows[0].status_code,
+    body: JSON.parse(rows[0].response_body),
+    reversed: rows[0].reversed_at !== null,
+  };
+}
+
+/**
+ * Reconciliation state of a stored outcome.
+ * @returns {'completed'|'reversed'|'refused'|'cancelled'}
+ */
+function withdrawState(outcome) {
+  if (outcome.status === 200) return outcome.reversed ? 'reversed' : 'completed';
+  return outcome.status === CANCELLED_STATUS ? 'cancelled' : 'refused';
+}
+
+/**
+ * Record the answer to a withdrawal key in the same transaction as its effects.
+ * amount null = key cancelled before any withdrawal used it.
+ */
+async function saveWithdrawOutcome(conn, accountId, key, amount, status, body) {
+  await conn.execute(
+    `INSERT INTO withdraw_requests (account_id, idempotency_key, amount, status_code, response_body)
+     VALUES (?, ?, ?, ?, ?)`,
+    [accountId, key, amount, status, JSON.stringify(body)]
+  );
+}
+
+// Cancelled keys answer this to any withdrawal that arrives later
+const CANCELLED_STATUS = 410;
+const CANCELLED_BODY = { error: 'Withdrawal cancelled' };
+
 // POST /accounts/:id/withdraw
 // body: { "amount": 50 }
+// Idempotency-Key: <key>  (optional) the same key again returns the first answer
+//                         (Idempotent-Replayed: true) without withdrawing twice
 router.post('/:id/withdraw', async (req, res) => {
   const accountId = Number(req.params.id);
   const amount = Number(req.body.amount);
+  const { key, valid: keyValid } = idempotencyKeyOf(req);
 
   if (!Number.isInteger(accountId) || accountId <= 0) {
     return res.status(400).json({ error: 'Invalid account id' });
   }
+  if (!keyValid) {
+    return res.status(400).json({ error: 'Invalid Idempotency-Key' });
+  }
 
   // Basic validation: positive whole number
   if (!Number.isFinite(amount) || !Number.isInteger(amount) || amount <= 0) {
     return res.status(400).json({ error: 'Invalid amount' });
   }
 
+  if (amount > MAX_WITHDRAW_AMOUNT) {
+    return res.status(400).json({ error: `Amount above limit (max ${MAX_WITHDRAW_AMOUNT}€ per withdrawal)` });
+  }
+
   // Bill feasibility validation (20€ / 50€ only) + breakdown
   const billResult = computeBills(amount);
   if (!billResult.ok) {
@@ -208,6 +460,31 @@ router.post('/:id/withdraw', async (req, res) => {
       return res.status(404).json({ error: 'Account not found' });
     }
 
+    // Same key seen before: answer as the first time, change nothing
+    if (key) {
+      const previous = await findWithdrawOutcome(conn, accountId, key);
+      if (previous) {
+        await conn.rollback();
+        if (previous.amount !== null && previous.amount !== amount) {
+          return res.status(422).json({ error: 'Idempotency-Key already used for another amount' });
+        }
+        res.set('Idempotent-Replayed', 'true');
+        if (previous.status === 200) return sendBody(req, res, previous.body);
+        return res.status(previous.status).json(previous.body);
+      }
+    }
+
+    // Business refusals are outcomes too: a replay must not succeed later
+    const refuse = async (status, body) => {
+      if (key) {
+        await saveWithdrawOutcome(conn, accountId, key, amount, status, body);
+        await conn.commit();
+      } else {
+        await conn.rollback();
+      }
+      return res.status(status).json(body);
+    };
+
     const balance = Number(rows[0].balance);
     const accountType = String(rows[0].account_type ?? 'debit');
     const creditLimit = Number(rows[0].credit_limit ?? 0);
@@ -216,14 +493,12 @@ router.post('/:id/withdraw', async (req, res) => {
 
     if (accountType === 'debit') {
       if (balance < amount) {
-        await conn.rollback();
-        return res.status(400).json({ error: 'Insufficient funds' });
+        return refuse(400, { error: 'Insufficient funds' });
       }
     } else if (accountType === 'credit') {
       // allow negative down to -creditLimit
       if (newBalance < -creditLimit) {
-        await conn.rollback();
-        return res.status(400).json({ error: 'Credit limit exceeded' });
+        return refuse(400, { error: 'Credit limit exceeded' });
       }
     } else {
       await conn.rollback();
@@ -240,15 +515,18 @@ router.post('/:id/withdraw', async (req, res) => {
       [accountId, amount]
     );
 
-    await conn.commit();
-
-    res.json({
+    const body = {
       ok: true,
       accountId,
       withdrawn: amount,
       balance: newBalance,
       bills: billResult.bills
-    });
+    };
+    if (key) await saveWithdrawOutcome(conn, accountId, key, amount, 200, body);
+
+    await conn.commit();
+
+    sendBody(req, res, body);
   } catch (err) {
     await conn.rollback();
     console.error('Withdraw error:', err);
@@ -258,4 +536,111 @@ router.post('/:id/withdraw', async (req, res) => {
   }
 });
 
+// POST /accounts/:id/withdrawals/:key/cancel
+// Reconciliation after a lost reply: returns the outcome stored for the key, or, if no
+// withdrawal with that key was processed, cancels the key so one still on its way is
+// refused (410). Either way the answer is final.
+// -> { state: 'completed'|'reversed'|'refused'|'cancelled', status, response }
+router.post('/:id/withdrawals/:key/cancel', async (req, res) => {
+  const accountId = Number(req.params.id);
+  const key = String(req.params.key);
+
+  if (!Number.isInteger(accountId) || accountId <= 0) {
+    return res.status(400).json({ error: 'Invalid account id' });
+  }
+  if (!IDEMPOTENCY_KEY_RE.test(key)) {
+    return res.status(400).json({ error: 'Invalid Idempotency-Key' });
+  }
+
+  const conn = await db.getConnection();
+  try {
+    await conn.beginTransaction();
+
+    // Same lock as withdraw: a request with this key is either done or not started
+    const [rows] = await conn.execute(`SELECT id FROM accounts WHERE id = ? FOR UPDATE`, [accountId]);
+    if (rows.length === 0) {
+      await conn.rollback();
+      return res.status(404).json({ error: 'Account not found' });
+    }
+
+    let outcome = await findWithdrawOutcome(conn, accountId, key);
+    if (outcome) {
+      await conn.rollback();
+    } else {
+      await saveWithdrawOutcome(conn, accountId, key, null, CANCELLED_STATUS, CANCELLED_BODY);
+      await conn.commit();
+      outcome = { amount: null, status: CANCELLED_STATUS, body: CANCELLED_BODY };
+    }
+
+    sendBody(req, res, { state: withdrawState(outcome), status: outcome.status, response: outcome.body });
+  } catch (err) {
+    await conn.rollback();
+    console.error('Withdraw cancel error:', err);
+    res.status(500).json({ error: 'Database error' });
+  } finally {
+    conn.release();
+  }
+});
+
+// POST /accounts/:id/withdrawals/:key/reverse
+// Compensation for a completed withdrawal whose notes were never paid out (the kiosk
+// learned the outcome only after the customer had gone): the amount is credited back
+// once, as a deposit. Other keys are answered as they stand; repeating changes nothing.
+// -> { state: 'reversed'|'refused'|'cancelled', status, balance }
+router.post('/:id/withdrawals/:key/reverse', async (req, res) => {
+  const accountId = Number(req.params.id);
+  const key = String(req.params.key);
+
+  if (!Number.isInteger(accountId) || accountId <= 0) {
+    return res.status(400).json({ error: 'Invalid account id' });
+  }
+  if (!IDEMPOTENCY_KEY_RE.test(key)) {
+    return res.status(400).json({ error: 'Invalid Idempotency-Key' });
+  }
+
+  const conn = await db.getConnection();
+  try {
+    await conn.beginTransaction();
+
+    const [rows] = await conn.execute(`SELECT balance FROM accounts WHERE id = ? FOR UPDATE`, [accountId]);
+    if (rows.length === 0) {
+      await conn.rollback();
+      return res.status(404).json({ error: 'Account not found' });
+    }
+
+    const outcome = await findWithdrawOutcome(conn, accountId, key);
+    if (!outcome) {
+      await conn.rollback();
+      return res.status(404).json({ error: 'Unknown withdrawal' });
+    }
+
+    let balance = Number(rows[0].balance);
+    if (outcome.status === 200 && !outcome.reversed) {
+      balance += outcome.amount;
+      await conn.execute(`UPDATE accounts SET balance = ? WHERE id = ?`, [balance, accountId]);
+      await conn.execute(
+        `INSERT INTO transactions (account_id, amount, tx_type) VALUES (?, ?, 'deposit')`,
+        [accountId, outcome.amount]
+      );
+      await conn.execute(
+        `UPDATE withdraw_requests SET reversed_at = CURRENT_TIMESTAMP
+         WHERE account_id = ? AND idempotency_key = ?`,
+        [accountId, key]
+      );
+      await conn.commit();
+      outcome.reversed = true;
+    } else {
+      await conn.rollback();
+    }
+
+    sendBody(req, res, { state: withdrawState(outcome), status: outcome.status, balance });
+  } catch (err) {
+    await conn.rollback();
+    console.error('Withdraw reverse error:', err);
+    res.status(500).json({ error: 'Database error' });
+  } finally {
+    conn.release();
+  }
+});
+
 module.exports = router;
\ No newline at end of file
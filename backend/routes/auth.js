@@ -2,14 +2,18 @@ const express = require('express');
 const bcrypt = require('bcrypt');
 const router = express.Router();
 const db = require('../db');
+const { loadBootstrap } = require('../bootstrap');
 // For security, we lock the card after 3 failed PIN attempts. This is a common practice to prevent brute-force attacks.
 const MAX_PIN_ATTEMPTS = 3;
 
 // POST /auth/login
-// body: { "cardNumber": "12345678", "pin": "1234" }
+// body: { "cardNumber": "12345678", "pin": "1234", "bootstrap": true }
+// With bootstrap:true a successful reply also carries the session bootstrap
+// (balances, first transactions pages, customer image) -> see ../bootstrap.js
 router.post('/login', async (req, res) => {
   const cardNumber = String(req.body.cardNumber ?? '').trim();
   const pin = String(req.body.pin ?? '');
+  const wantBootstrap = req.body.bootstrap === true;
 
   if (!cardNumber || !pin) {
     return res.status(400).json({ error: 'cardNumber and pin required' });
@@ -103,10 +107,19 @@ router.post('/login', async (req, res) => {
     await conn.commit();
 
     // response: always accounts[{role, accountId}]
-    return res.json({
-      ok: true,
-      accounts: links.map(l => ({ role: l.role, accountId: l.account_id })),
-    });
+    const accounts = links.map(l => ({ role: l.role, accountId: l.account_id }));
+    const body = { ok: true, accounts };
+
+    if (wantBootstrap) {
+      // Optional: a failure here must not fail the login, the client falls back to separate calls
+      try {
+        body.bootstrap = await loadBootstrap(accounts);
+      } catch (err) {
+        console.error('Login bootstrap error:', err);
+      }
+    }
+
+    return res.json(body);
 
   } catch (err) {
     await conn.rollback();
@@ -2,6 +2,11 @@ const express = require('express');
 const router = express.Router();
 const db = require('../db');
 
+// Connection keep-alive for idle kiosks (HEAD every 20 s): no database round trip
+router.get('/ping', (req, res) => {
+  res.status(204).end();
+});
+
 router.get('/', async (req, res) => {
   try {
     const [rows] = await db.execute('SELECT 1 AS ok');
@@ -0,0 +1,134 @@
+#include "ActivityMonitor.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QVector>
+#include <algorithm>
+#include <limits>
+
+ActivityMonitor::ActivityMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::CoarseTimer); // within 5%: a 30 s timeout may end ~1 s late
+    connect(&m_timer, &QTimer::timeout, this, &ActivityMonitor::check);
+}
+
+ActivityMonitor::~ActivityMonitor()
+{
+    setFiltering(false);
+}
+
+ActivityMonitor::WatchId ActivityMonitor::watch(int timeoutMs, QObject *context, std::function<void()> onIdle)
+{
+    const WatchId id = m_nextId++;
+
+    Watch w;
+    w.timeoutMs = timeoutMs;
+    w.armedMs = m_clock.elapsed();
+    w.armed = true;
+    w.onIdle = std::move(onIdle);
+    m_watches.insert(id, w);
+
+    if (context) connect(context, &QObject::destroyed, this, [this, id]() { unwatch(id); });
+
+    reschedule();
+    return id;
+}
+
+void ActivityMonitor::unwatch(WatchId id)
+{
+    if (m_watches.remove(id)) reschedule();
+}
+
+void ActivityMonitor::arm(WatchId id)
+{
+    const auto it = m_watches.find(id);
+    if (it == m_watches.end()) return;
+    it->armedMs = m_clock.elapsed();
+    it->armed = true;
+    reschedule();
+}
+
+void ActivityMonitor::disarm(WatchId id)
+{
+    const auto it = m_watches.find(id);
+    if (it == m_watches.end() || !it->armed) return;
+    it->armed = false;
+    reschedule();
+}
+
+bool ActivityMonitor::eventFilter(QObject *obj, QEvent *event)
+{
+    Q_UNUSED(obj);
+
+    switch (event->type()) {
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::InputMethod:
+    case QEvent::FocusIn:
+        m_lastActivityMs = m_clock.elapsed();
+        break;
+    default:
+        break;
+    }
+    return false; // don't swallow events
+}
+
+void ActivityMonitor::check()
+{
+    const qint64 now = m_clock.elapsed();
+
+    QVector<WatchId> due;
+    for (auto it = m_watches.begin(); it != m_watches.end(); ++it) {
+        if (!it->armed) continue;
+        if (now - std::max(m_lastActivityMs, it->armedMs) < it->timeoutMs) continue;
+        it->armed = false;
+        due.append(it.key());
+    }
+    reschedule();
+
+    // A callback may close windows and so drop or re-arm other watches
+    for (const WatchId id : due) {
+        const auto it = m_watches.constFind(id);
+        if (it == m_watches.constEnd() || it->armed) continue;
+        const std::function<void()> onIdle = it->onIdle;
+        onIdle();
+    }
+}
+
+void ActivityMonitor::reschedule()
+{
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (const Watch &w : m_watches) {
+        if (w.armed) next = std::min(next, std::max(m_lastActivityMs, w.armedMs) + w.timeoutMs);
+    }
+
+    const bool anyArmed = next != std::numeric_limits<qint64>::max();
+    setFiltering(anyArmed);
+    if (!anyArmed) {
+        m_timer.stop();
+        return;
+    }
+
+    // Activity only moves deadlines later: a timer already due earlier stays, fires
+    // and re-arms itself for what is left
+    const int delay = int(std::clamp<qint64>(next - m_clock.elapsed(), 0, std::numeric_limits<int>::max()));
+    if (!m_timer.isActive() || m_timer.remainingTime() > delay) m_timer.start(delay);
+}
+
+void ActivityMonitor::setFiltering(bool on)
+{
+    if (on == m_filtering || !QCoreApplication::instance()) return;
+    m_filtering = on;
+    if (on) QCoreApplication::instance()->installEventFilter(this);
+    else QCoreApplication::instance()->removeEventFilter(this);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+// Inactivity timeouts for the whole app from one place.
+// An application event filter stores the time of the last input event (mouse, touch,
+// key, wheel, focus) and nothing else, so a stream of touch moves costs one clock read
+// each. One coarse single-shot timer is armed for the earliest deadline of all watches;
+// when it fires, watches whose user was active meanwhile are simply pushed back. Without
+// armed watches (attract screen) the filter is removed and the timer stopped.
+class ActivityMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    using WatchId = quint64;
+
+    explicit ActivityMonitor(QObject* parent = nullptr);
+    ~ActivityMonitor() override;
+
+    // onIdle runs once when there was no input for timeoutMs since the later of the last
+    // input event and arm(); dropped with `context`. Armed on creation.
+    WatchId watch(int timeoutMs, QObject* context, std::function<void()> onIdle);
+    void unwatch(WatchId id);
+    // Restart the countdown from now (also re-arms a watch that fired or was disarmed)
+    void arm(WatchId id);
+    // Stop counting until arm() (e.g. while waiting for the bank)
+    void disarm(WatchId id);
+
+    qint64 msSinceActivity() const { return m_clock.elapsed() - m_lastActivityMs; }
+
+protected:
+    bool eventFilter(QObject* obj, QEvent* event) override;
+
+private:
+    struct Watch {
+        int timeoutMs = 0;
+        qint64 armedMs = 0;
+        bool armed = false;
+        std::function<void()> onIdle;
+    };
+    QHash<WatchId, Watch> m_watches;
+    WatchId m_nextId = 1;
+
+    QElapsedTimer m_clock;
+    qint64 m_lastActivityMs = 0;
+    QTimer m_timer;
+    bool m_filtering = false;
+
+    void check();
+    // Timer for the earliest armed deadline; event filter only while something is armed
+    void reschedule();
+    void setFiltering(bool on);
+};
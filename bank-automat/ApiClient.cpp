@@ -1,14 +1,142 @@
 #include "ApiClient.h"
 
+#include "CborDecoder.h"
+#include "ReplyDecoder.h"
+
+#include <QCborStreamReader>
+#include <QDateTime>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QRandomGenerator>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QUuid>
+#include <algorithm>
+#include <memory>
+
+// Servers that know CBOR answer with it; everything else keeps sending JSON
+static const QByteArray ACCEPT_CBOR_FIRST = QByteArrayLiteral("application/cbor, application/json;q=0.9");
+static const QByteArray ACCEPT_CBOR_SEQ_FIRST = QByteArrayLiteral("application/cbor-seq, application/x-ndjson;q=0.9");
+
+static constexpr int STREAM_MAX_ROWS = 5000;
+// Bytes QNetworkReply may hold before we read them; the socket is throttled beyond this
+static constexpr qint64 STREAM_READ_BUFFER = 64 * 1024;
+// Withdraw attempts: short per-attempt timeout, safe to repeat thanks to the idempotency key
+static constexpr int WITHDRAW_ATTEMPT_TIMEOUT_MS = 8 * 1000;
+static constexpr int WITHDRAW_MAX_ATTEMPTS = 3;
+static constexpr int WITHDRAW_RETRY_BACKOFF_MS = 500;
+// Pending withdrawals are looked up again after this while any remain unsettled
+static constexpr int RECONCILE_RETRY_MS = 30 * 1000;
+
+// Replies an endpoint needs before its latency quantile is trusted as a hedge delay
+static constexpr quint64 HEDGE_MIN_SAMPLES = 20;
+
+// Failures where another attempt can succeed and a GET is safe to repeat
+static bool isRetryable(QNetworkReply *reply, int status)
+{
+    if (status == 502 || status == 503 || status == 504) return true;
+
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
 
 ApiClient::ApiClient(QObject *parent)
     : QObject(parent),
       m_baseUrl("http://localhost:3000")
 {
+    m_keepAliveTimer.setSingleShot(false);
+    m_keepAliveTimer.setTimerType(Qt::VeryCoarseTimer); // whole seconds: lets idle wakeups coalesce
+    connect(&m_keepAliveTimer, &QTimer::timeout, this, &ApiClient::sendKeepAlive);
+    m_sinceLastRequest.start();
+
+    m_reconcileTimer.setSingleShot(true);
+    m_reconcileTimer.setInterval(RECONCILE_RETRY_MS);
+    connect(&m_reconcileTimer, &QTimer::timeout, this, &ApiClient::reconcileWithdrawals);
+}
+
+void ApiClient::prewarm()
+{
+    const QUrl url(m_baseUrl);
+    if (!url.isValid() || url.host().isEmpty()) return;
+
+#if QT_CONFIG(ssl)
+    if (url.scheme() == QLatin1String("https")) {
+        m_net.connectToHostEncrypted(url.host(), quint16(url.port(443)));
+        return;
+    }
+#endif
+    m_net.connectToHost(url.host(), quint16(url.port(80)));
+}
+
+void ApiClient::setKeepAliveInterval(int ms)
+{
+    if (ms <= 0) {
+        m_keepAliveTimer.stop();
+        return;
+    }
+    m_keepAliveTimer.start(ms);
+}
+
+void ApiClient::setHttp2Direct(bool enabled)
+{
+    m_http2Direct = enabled;
+}
+
+void ApiClient::setRetryPolicy(const QString &endpoint, const RetryPolicy &policy)
+{
+    RetryPolicy p = policy;
+    p.maxAttempts = qMax(1, p.maxAttempts);
+    p.baseBackoffMs = qMax(1, p.baseBackoffMs);
+    p.maxBackoffMs = qMax(p.baseBackoffMs, p.maxBackoffMs);
+    p.hedgeMaxDelayMs = qMax(p.hedgeMinDelayMs, p.hedgeMaxDelayMs);
+    m_retryPolicies.insert(endpoint, p);
+}
+
+ApiClient::RetryPolicy ApiClient::retryPolicy(const QString &endpoint) const
+{
+    return m_retryPolicies.value(endpoint, RetryPolicy());
+}
+
+void ApiClient::setRetryBudget(double ratio, int burst)
+{
+    m_retryBudgetRatio = qMax(0.0, ratio);
+    m_retryBudgetBurst = qMax(0, burst);
+    m_retryTokens = qMin(m_retryTokens, m_retryBudgetBurst);
+}
+
+void ApiClient::earnRetryToken()
+{
+    m_retryTokens = qMin(m_retryBudgetBurst, m_retryTokens + m_retryBudgetRatio);
+}
+
+void ApiClient::sendKeepAlive()
+{
+    // Real traffic keeps the connection open by itself
+    if (m_sinceLastRequest.elapsed() < m_keepAliveTimer.interval()) return;
+
+    QNetworkReply *reply = m_net.head(makeRequest("/health/ping"));
+    connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+}
+
+QNetworkRequest ApiClient::makeRequest(const QString &path)
+{
+    m_sinceLastRequest.restart();
+
+    QNetworkRequest req(QUrl(joinUrl(m_baseUrl, path)));
+    // Multiplex over one connection where the proxy speaks HTTP/2 (ALPN on https)
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    if (m_http2Direct) req.setAttribute(QNetworkRequest::Http2DirectAttribute, true);
+    return req;
 }
 
 void ApiClient::setBaseUrl(const QString &baseUrl)
@@ -32,22 +160,183 @@ QString ApiClient::joinUrl(const QString &baseUrl, const QString &path)
     return b + p;
 }
 
-void ApiClient::fetchImageByFilename(const QString& filename,
-                                    std::function<void(const QByteArray& data)> onSuccess,
-                                    std::function<void(const QString& error)> onError)
+// -------- Timing --------
+
+void ApiClient::trackReply(QNetworkReply *reply)
+{
+    ReplyTiming &t = m_replyTimings[reply];
+    t.endpoint = RequestMetrics::endpointFor(reply->url());
+    t.clock.start();
+
+    // Connected before the caller's finished handler, so "total" excludes decoding
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, reply]() {
+        auto it = m_replyTimings.find(reply);
+        if (it != m_replyTimings.end()) it->connectingNs = it->clock.nsecsElapsed();
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [this, reply]() {
+        auto it = m_replyTimings.find(reply);
+        if (it != m_replyTimings.end()) it->sentNs = it->clock.nsecsElapsed();
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        auto it = m_replyTimings.find(reply);
+        if (it != m_replyTimings.end() && it->headersNs < 0) it->headersNs = it->clock.nsecsElapsed();
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { recordReplyTiming(reply); });
+    connect(reply, &QObject::destroyed, this, [this, reply]() { m_replyTimings.remove(reply); });
+}
+
+void ApiClient::recordReplyTiming(QNetworkReply *reply)
+{
+    const auto it = m_replyTimings.constFind(reply);
+    if (it == m_replyTimings.constEnd()) return;
+
+    // Cancelled requests say nothing about the server or the network
+    if (reply->error() == QNetworkReply::OperationCanceledError) return;
+
+    const ReplyTiming &t = *it;
+    const qint64 nowNs = t.clock.nsecsElapsed();
+
+    if (t.sentNs >= 0) {
+        m_metrics.record(t.endpoint, RequestMetrics::Queue, t.connectingNs >= 0 ? t.connectingNs : t.sentNs);
+        if (t.connectingNs >= 0) m_metrics.record(t.endpoint, RequestMetrics::Connect, t.sentNs - t.connectingNs);
+        if (t.headersNs >= 0) m_metrics.record(t.endpoint, RequestMetrics::Ttfb, t.headersNs - t.sentNs);
+    }
+    if (t.headersNs >= 0) m_metrics.record(t.endpoint, RequestMetrics::Download, nowNs - t.headersNs);
+    m_metrics.record(t.endpoint, RequestMetrics::Total, nowNs);
+}
+
+// -------- Request bookkeeping --------
+
+ApiClient::RequestId ApiClient::beginRequest(QObject *context)
+{
+    const RequestId id = m_nextRequestId++;
+
+    Pending p;
+    p.context = context;
+    p.contextKey = context;
+    m_pending.insert(id, p);
+
+    if (context) {
+        m_contextRequests[context].insert(id);
+        connect(context, &QObject::destroyed,
+                this, &ApiClient::onContextDestroyed, Qt::UniqueConnection);
+    }
+    return id;
+}
+
+bool ApiClient::isActive(RequestId id) const
+{
+    const auto it = m_pending.constFind(id);
+    if (it == m_pending.constEnd() || it->detached) return false;
+    return !it->contextKey || !it->context.isNull();
+}
+
+void ApiClient::untrackContext(RequestId id, QObject* contextKey)
+{
+    if (!contextKey) return;
+    const auto ctx = m_contextRequests.find(contextKey);
+    if (ctx != m_contextRequests.end()) {
+        ctx->remove(id);
+        if (ctx->isEmpty()) m_contextRequests.erase(ctx);
+    }
+}
+
+bool ApiClient::finishRequest(RequestId id)
+{
+    const bool active = isActive(id);
+
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end()) return false;
+
+    untrackContext(id, it->contextKey);
+    m_pending.erase(it);
+    return active;
+}
+
+void ApiClient::cancel(RequestId id)
+{
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end() || it->detached) return;
+    ++m_cancelledRequests;
+
+    // The bank may commit a withdrawal whatever happens here: only the callback is
+    // dropped, the attempts run on so postWithdraw() records the actual outcome
+    if (!it->withdrawKey.isEmpty()) {
+        it->detached = true;
+        untrackContext(id, it->contextKey);
+        return;
+    }
+
+    const Pending p = *it;
+    finishRequest(id);
+
+    // Shared GET: drop only this waiter, abort once nobody is waiting any more
+    if (!p.inflightKey.isEmpty()) {
+        const auto inflight = m_inflight.find(p.inflightKey);
+        if (inflight != m_inflight.end()
+            && inflight->waiters.removeIf([id](const auto &w) { return w.first == id; }) > 0
+            && inflight->waiters.isEmpty()) {
+            const QVector<QNetworkReply*> replies = inflight->replies;
+            m_inflight.erase(inflight);
+            for (QNetworkReply *reply : replies) reply->abort();
+        }
+    }
+
+    if (p.reply) p.reply->abort();
+}
+
+void ApiClient::cancelAll(QObject *context)
+{
+    const QSet<RequestId> ids = m_contextRequests.take(context);
+    for (const RequestId id : ids) cancel(id);
+}
+
+int ApiClient::orphanReplies() const
+{
+    QSet<const QNetworkReply*> owned;
+    for (const Pending &p : m_pending) {
+        if (p.reply) owned.insert(p.reply);
+    }
+    for (const InflightGet &g : m_inflight) {
+        for (const QNetworkReply *reply : g.replies) owned.insert(reply);
+    }
+
+    int orphans = 0;
+    for (auto it = m_replyTimings.constBegin(); it != m_replyTimings.constEnd(); ++it) {
+        if (!owned.contains(it.key())) ++orphans;
+    }
+    return orphans;
+}
+
+void ApiClient::onContextDestroyed(QObject *context)
+{
+    // The owner is gone (e.g. a MainWindow after session timeout): stop its traffic
+    cancelAll(context);
+}
+
+ApiClient::RequestId ApiClient::fetchImageByFilename(const QString& filename, QObject* context,
+                                                    std::function<void(const QByteArray& data)> onSuccess,
+                                                    std::function<void(const QString& error)> onError)
 {
     const QString fn = filename.trimmed();
     if (fn.isEmpty()) {
         onError(QStringLiteral("No filename"));
-        return;
+        return 0;
     }
 
-    const QUrl url(joinUrl(m_baseUrl, "/images/uploads/" + fn));
-    QNetworkRequest req(url);
+    QNetworkRequest req = makeRequest("/images/uploads/" + fn);
     req.setRawHeader("Accept", "image/*");
 
+    const RequestId id = beginRequest(context);
     QNetworkReply* reply = m_net.get(req);
-    connect(reply, &QNetworkReply::finished, this, [reply, onSuccess, onError]() {
+    trackReply(reply);
+    m_pending[id].reply = reply;
+
+    connect(reply, &QNetworkReply::finished, this, [this, id, reply, onSuccess, onError]() {
+        if (!finishRequest(id)) {
+            reply->deleteLater();
+            return;
+        }
         if (reply->error() != QNetworkReply::NoError) {
             const QString err = reply->errorString();
             reply->deleteLater();
@@ -58,24 +347,70 @@ void ApiClient::fetchImageByFilename(const QString& filename,
         reply->deleteLater();
         onSuccess(data);
     });
+    return id;
+}
+
+ApiClient::RequestId ApiClient::getSessionBootstrap(int accountId, QObject* context, BootstrapCallback cb)
+{
+    // Login reply already had it -> no round trip at all (used once; later calls go to the server)
+    if (!m_loginBootstrap.raw.isEmpty()) {
+        bool parsed = false;
+        const QJsonObject bootstrap = decodeDocument(m_loginBootstrap, &parsed).object();
+        const QJsonArray loginAccounts = bootstrap.value("accounts").toArray();
+        for (const auto &v : loginAccounts) {
+            if (v.toObject().value("accountId").toInt(-1) == accountId) {
+                m_loginBootstrap = Body();
+                cb(true, bootstrap, QString());
+                return 0;
+            }
+        }
+    }
+
+    const RequestId id = beginRequest(context);
+    getJson(id, QString("/accounts/%1/bootstrap").arg(accountId),
+            [this, id, cb](bool ok, int /*status*/, QJsonDocument json, QString error) {
+        if (!finishRequest(id)) return;
+        if (!ok) {
+            cb(false, QJsonObject(), error.isEmpty() ? "Failed to load session" : error);
+            return;
+        }
+        if (!json.isObject()) {
+            cb(false, QJsonObject(), "Invalid response from server");
+            return;
+        }
+        cb(true, json.object(), QString());
+    });
+    return id;
 }
 
-void ApiClient::getCustomerImageFilenameForAccount(
-    int accountId,
+ApiClient::RequestId ApiClient::getCustomerImageFilenameForAccount(
+    int accountId, QObject* context,
     std::function<void(bool ok, const QString& filename, const QString& error)> cb)
 {
+    const RequestId id = beginRequest(context);
+
     // /crud/accounts/:id -> customer_id
     const QString accountPath = QString("/crud/accounts/%1").arg(accountId);
-    getJson(accountPath, [this, cb](bool ok, int httpStatus, QJsonDocument json, QString error) {
+    getJson(id, accountPath, [this, id, cb](bool ok, int httpStatus, QJsonDocument json, QString error) {
+        // First leg: the request stays open until the customer lookup answers
+        if (!isActive(id)) {
+            finishRequest(id);
+            return;
+        }
+        const auto fail = [this, id, cb](const QString &msg) {
+            finishRequest(id);
+            cb(false, QString(), msg);
+        };
+
         if (!ok) {
             const QString msg = error.isEmpty()
                 ? QString("Failed to fetch account (HTTP %1)").arg(httpStatus)
                 : error;
-            cb(false, QString(), msg);
+            fail(msg);
             return;
         }
         if (!json.isObject()) {
-            cb(false, QString(), QStringLiteral("Invalid account response"));
+            fail(QStringLiteral("Invalid account response"));
             return;
         }
 
@@ -87,13 +422,14 @@ void ApiClient::getCustomerImageFilenameForAccount(
         if (customerId < 0 && acc.contains("customerId")) customerId = acc.value("customerId").toInt(-1);
 
         if (customerId < 0) {
-            cb(false, QString(), QStringLiteral("Account does not contain customer_id"));
+            fail(QStringLiteral("Account does not contain customer_id"));
             return;
         }
 
-        // /crud/customers/:id -> image_filename
+        // /crud/customers/:id -> image_filename (same request id)
         const QString custPath = QString("/crud/customers/%1").arg(customerId);
-        getJson(custPath, [cb](bool ok2, int http2, QJsonDocument json2, QString error2) {
+        getJson(id, custPath, [this, id, cb](bool ok2, int http2, QJsonDocument json2, QString error2) {
+            if (!finishRequest(id)) return;
             if (!ok2) {
                 const QString msg = error2.isEmpty()
                     ? QString("Failed to fetch customer (HTTP %1)").arg(http2)
@@ -116,6 +452,7 @@ void ApiClient::getCustomerImageFilenameForAccount(
             cb(true, filename, QString());
         });
     });
+    return id;
 }
 
 QString ApiClient::extractErrorMessage(const QJsonDocument &json, const QString &fallback)
@@ -132,91 +469,365 @@ QString ApiClient::extractErrorMessage(const QJsonDocument &json, const QString
     return fallback;
 }
 
-void ApiClient::postJson(const QString &path,
+void ApiClient::postBody(RequestId id,
+                         const QString &path,
                          const QJsonObject &body,
-                         std::function<void(bool, int, QJsonDocument, QString)> cb)
+                         BodyCallback cb,
+                         const QByteArray &idempotencyKey,
+                         int timeoutMs)
 {
-    const QUrl url(joinUrl(m_baseUrl, path));
-    QNetworkRequest req(url);
+    QNetworkRequest req = makeRequest(path);
     req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (m_preferCbor) req.setRawHeader("Accept", ACCEPT_CBOR_FIRST);
+    if (!idempotencyKey.isEmpty()) req.setRawHeader("Idempotency-Key", idempotencyKey);
 
     const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
     QNetworkReply *reply = m_net.post(req, payload);
+    trackReply(reply);
+    m_pending[id].reply = reply;
 
-    QObject::connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        const QByteArray raw = reply->readAll();
+    // Timed out: the reply is aborted and answered below as "no answer"
+    auto timedOut = std::make_shared<bool>(false);
+    if (timeoutMs > 0) {
+        QTimer::singleShot(timeoutMs, reply, [reply, timedOut]() {
+            if (reply->isFinished()) return;
+            *timedOut = true;
+            reply->abort();
+        });
+    }
 
-        QJsonParseError parseErr;
-        const QJsonDocument json = QJsonDocument::fromJson(raw, &parseErr);
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, id, reply, cb, timedOut]() {
+        // Cancelled (reply aborted): nothing to parse or dispatch
+        if (!m_pending.contains(id)) {
+            reply->deleteLater();
+            return;
+        }
+        m_pending[id].reply = nullptr;
+
+        if (*timedOut) {
+            reply->deleteLater();
+            cb(false, 0, Body(), QStringLiteral("No answer from the bank"));
+            return;
+        }
+
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const Body body = takeBody(reply);
 
         // Network-level error
         if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-
-        if (parseErr.error == QJsonParseError::NoError) {
             // If backend returned { error: "..." }, show that instead of "Bad Request"
-            err = ApiClient::extractErrorMessage(json, err);
+            const QString err = errorMessage(body, reply->errorString());
+            reply->deleteLater();
+            cb(false, status, body, err);
+            return;
         }
 
-        reply->deleteLater();
-        cb(false, status, json, err);
-        return;
-    }
-
         // HTTP error
         if (status < 200 || status >= 300) {
-            const QString err = (parseErr.error == QJsonParseError::NoError)
-                                    ? ApiClient::extractErrorMessage(json, QString("HTTP %1").arg(status))
-                                    : QString("HTTP %1").arg(status);
+            const QString err = errorMessage(body, QString("HTTP %1").arg(status));
             reply->deleteLater();
-            cb(false, status, json, err);
+            cb(false, status, body, err);
             return;
         }
 
         reply->deleteLater();
-        cb(true, status, json, QString());
+        cb(true, status, body, QString());
     });
 }
 
-void ApiClient::getJson(const QString &path,
-                        std::function<void(bool, int, QJsonDocument, QString)> cb)
+void ApiClient::postJson(RequestId id,
+                         const QString &path,
+                         const QJsonObject &body,
+                         JsonCallback cb,
+                         const QByteArray &idempotencyKey,
+                         int timeoutMs)
 {
-    const QUrl url(joinUrl(m_baseUrl, path));
-    QNetworkRequest req(url);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    postBody(id, path, body, [this, cb](bool ok, int status, const Body &reply, QString error) {
+        bool parsed = false;
+        cb(ok, status, decodeDocument(reply, &parsed), error);
+    }, idempotencyKey, timeoutMs);
+}
 
-    QNetworkReply *reply = m_net.get(req);
+void ApiClient::setPreferCbor(bool enabled)
+{
+    m_preferCbor = enabled;
+}
 
-    QObject::connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        const QByteArray raw = reply->readAll();
+ApiClient::Body ApiClient::takeBody(QNetworkReply *reply)
+{
+    // Decoder follows what the server actually sent (errors are always JSON)
+    const QByteArray contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+
+    Body body;
+    body.raw = reply->readAll();
+    body.format = contentType.startsWith("application/cbor") ? ReplyDecoder::Format::Cbor
+                                                             : ReplyDecoder::Format::Json;
+    const auto timing = m_replyTimings.constFind(reply);
+    if (timing != m_replyTimings.constEnd()) body.endpoint = timing->endpoint;
 
+    WireStats &stats = body.format == ReplyDecoder::Format::Cbor ? m_cborStats : m_jsonStats;
+    ++stats.responses;
+    stats.bytes += quint64(body.raw.size());
+    return body;
+}
+
+QJsonDocument ApiClient::decodeDocument(const Body &body, bool *parsed)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonDocument json;
+    if (body.format == ReplyDecoder::Format::Cbor) {
+        json = CborDecoder::decode(body.raw, parsed);
+    } else {
         QJsonParseError parseErr;
-        const QJsonDocument json = QJsonDocument::fromJson(raw, &parseErr);
+        json = QJsonDocument::fromJson(body.raw, &parseErr);
+        *parsed = (parseErr.error == QJsonParseError::NoError);
+    }
 
-        if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-        if (parseErr.error == QJsonParseError::NoError) {
-            err = ApiClient::extractErrorMessage(json, err);
+    recordDecode(body, timer.nsecsElapsed());
+    return json;
+}
+
+template <typename T>
+bool ApiClient::decodeTyped(const Body &body, bool (*decode)(const QByteArray&, ReplyDecoder::Format, T*), T *out)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = decode(body.raw, body.format, out);
+    recordDecode(body, timer.nsecsElapsed());
+    return ok;
+}
+
+void ApiClient::recordDecode(const Body &body, qint64 decodeNs)
+{
+    WireStats &stats = body.format == ReplyDecoder::Format::Cbor ? m_cborStats : m_jsonStats;
+    stats.decodeNs += decodeNs;
+    if (!body.endpoint.isEmpty()) m_metrics.record(body.endpoint, RequestMetrics::Decode, decodeNs);
+}
+
+QString ApiClient::errorMessage(const Body &body, const QString &fallback)
+{
+    if (body.raw.isEmpty()) return fallback;
+    bool parsed = false;
+    const QJsonDocument json = decodeDocument(body, &parsed);
+    return parsed ? ApiClient::extractErrorMessage(json, fallback) : fallback;
+}
+
+void ApiClient::clearResponseCache()
+{
+    m_responseCache.clear();
+}
+
+void ApiClient::getJson(RequestId id, const QString &path, JsonCallback cb)
+{
+    getBody(id, path, [this, cb](bool ok, int status, const Body &body, QString error) {
+        bool parsed = false;
+        cb(ok, status, decodeDocument(body, &parsed), error);
+    });
+}
+
+void ApiClient::getBody(RequestId id, const QString &path, BodyCallback cb)
+{
+    const auto pending = m_pending.find(id);
+    if (pending == m_pending.end()) return;
+
+    QNetworkRequest req = makeRequest(path);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (m_preferCbor) req.setRawHeader("Accept", ACCEPT_CBOR_FIRST);
+    const QString cacheKey = req.url().toString();
+    pending->inflightKey = cacheKey;
+
+    // Identical GET already on the wire -> wait for that reply instead of sending another
+    const auto inflight = m_inflight.find(cacheKey);
+    if (inflight != m_inflight.end()) {
+        ++m_coalescedHits;
+        inflight->waiters.append({ id, std::move(cb) });
+        return;
+    }
+
+    // Revalidate instead of re-downloading if we already hold this resource
+    if (const CachedResponse *cached = m_responseCache.object(cacheKey)) {
+        req.setRawHeader("If-None-Match", cached->etag);
+    }
+
+    InflightGet entry;
+    entry.request = req;
+    entry.endpoint = RequestMetrics::endpointFor(req.url());
+    entry.serial = m_nextInflightSerial++;
+    entry.waiters.append({ id, std::move(cb) });
+    m_inflight.insert(cacheKey, entry);
+
+    sendGet(cacheKey);
+    scheduleHedge(cacheKey);
+}
+
+void ApiClient::sendGet(const QString &cacheKey)
+{
+    const auto it = m_inflight.find(cacheKey);
+    if (it == m_inflight.end()) return;
+
+    m_sinceLastRequest.restart();
+    QNetworkReply *reply = m_net.get(it->request);
+    trackReply(reply);
+    it->replies.append(reply);
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, cacheKey]() {
+        onGetFinished(cacheKey, reply);
+    });
+}
+
+void ApiClient::scheduleHedge(const QString &cacheKey)
+{
+    const auto it = m_inflight.constFind(cacheKey);
+    if (it == m_inflight.constEnd()) return;
+
+    const RetryPolicy policy = retryPolicy(it->endpoint);
+    if (!policy.hedge) return;
+
+    // No hedging on a guess: wait until the endpoint has a latency distribution
+    const LatencyHistogram *total = m_metrics.histogram(it->endpoint, RequestMetrics::Total);
+    if (!total || total->count() < HEDGE_MIN_SAMPLES) return;
+
+    const int delayMs = qBound(policy.hedgeMinDelayMs,
+                               int(total->quantileMicros(policy.hedgeQuantile) / 1000),
+                               policy.hedgeMaxDelayMs);
+    const quint64 serial = it->serial;
+    QTimer::singleShot(delayMs, this, [this, cacheKey, serial]() {
+        const auto it = m_inflight.find(cacheKey);
+        // Answered, cancelled, or already past the first attempt
+        if (it == m_inflight.end() || it->serial != serial) return;
+        if (it->replies.size() != 1 || it->retries > 0 || it->hedgeReply) return;
+        if (!takeRetryToken(it->endpoint)) return;
+
+        m_metrics.count(it->endpoint, RequestMetrics::Hedges);
+        sendGet(cacheKey);
+        const auto sent = m_inflight.find(cacheKey);
+        if (sent != m_inflight.end()) sent->hedgeReply = sent->replies.last();
+    });
+}
+
+bool ApiClient::takeRetryToken(const QString &endpoint)
+{
+    if (m_retryTokens < 1.0) {
+        m_metrics.count(endpoint, RequestMetrics::BudgetDenied);
+        return false;
+    }
+    m_retryTokens -= 1.0;
+    return true;
+}
+
+void ApiClient::onGetFinished(const QString &cacheKey, QNetworkReply *reply)
+{
+    auto it = m_inflight.find(cacheKey);
+    if (it == m_inflight.end() || !it->replies.contains(reply)) {
+        // Every waiter was cancelled, or the other attempt already answered
+        reply->deleteLater();
+        return;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (isRetryable(reply, status)) {
+        it->replies.removeOne(reply);
+        if (it->hedgeReply == reply) it->hedgeReply = nullptr;
+
+        // The other attempt is still running: let it answer
+        if (!it->replies.isEmpty()) {
+            reply->deleteLater();
+            return;
+        }
+
+        const RetryPolicy policy = retryPolicy(it->endpoint);
+        if (it->retries + 1 < policy.maxAttempts && takeRetryToken(it->endpoint)) {
+            ++it->retries;
+            m_metrics.count(it->endpoint, RequestMetrics::Retries);
+
+            const int cap = qMin(policy.maxBackoffMs, policy.baseBackoffMs << qMin(it->retries - 1, 16));
+            const int delayMs = cap / 2 + int(QRandomGenerator::global()->bounded(cap / 2 + 1));
+            const quint64 serial = it->serial;
+            QTimer::singleShot(delayMs, this, [this, cacheKey, serial]() {
+                const auto it = m_inflight.constFind(cacheKey);
+                if (it != m_inflight.constEnd() && it->serial == serial) sendGet(cacheKey);
+            });
+            reply->deleteLater();
+            return;
         }
+        // Out of attempts or budget: this failure is the answer
+        it->replies.append(reply);
+    }
+
+    // 304 for an entry evicted since the request went out: nothing to answer it from,
+    // so ask again without If-None-Match (once the other attempt has had its say)
+    if (status == 304 && reply->error() == QNetworkReply::NoError
+        && !m_responseCache.contains(cacheKey) && reply->request().hasRawHeader("If-None-Match")) {
+        it->replies.removeOne(reply);
+        if (it->hedgeReply == reply) it->hedgeReply = nullptr;
+        it->request.setRawHeader("If-None-Match", QByteArray());
         reply->deleteLater();
-        cb(false, status, json, err);
+        if (it->replies.isEmpty()) sendGet(cacheKey);
         return;
     }
 
-        if (status < 200 || status >= 300) {
-            const QString err = (parseErr.error == QJsonParseError::NoError)
-                                    ? ApiClient::extractErrorMessage(json, QString("HTTP %1").arg(status))
-                                    : QString("HTTP %1").arg(status);
+    if (reply == it->hedgeReply) m_metrics.count(it->endpoint, RequestMetrics::HedgeWins);
+
+    // Everyone who asked for this url gets the same (implicitly shared) result
+    const QVector<QPair<RequestId, BodyCallback>> waiters = it->waiters;
+    QVector<QNetworkReply*> losers = it->replies;
+    losers.removeOne(reply);
+    m_inflight.erase(it);
+    for (QNetworkReply *loser : losers) loser->abort();
+
+    const auto cb = [this, &waiters](bool ok, int status, const Body &body, const QString &error) {
+        for (const auto &waiter : waiters) {
+            // Cancelled by an earlier callback of this same reply
+            const auto pending = m_pending.find(waiter.first);
+            if (pending == m_pending.end()) continue;
+            pending->inflightKey.clear();
+            waiter.second(ok, status, body, error);
+        }
+    };
+
+    // 304 Not Modified: body is empty, serve the one received last time
+    if (status == 304 && reply->error() == QNetworkReply::NoError) {
+        if (const CachedResponse *cached = m_responseCache.object(cacheKey)) {
+            ++m_cacheHits;
+            earnRetryToken();
+            const Body body = cached->body;
             reply->deleteLater();
-            cb(false, status, json, err);
+            cb(true, 200, body, QString());
             return;
         }
+    }
+
+    ++m_cacheMisses;
+    const Body body = takeBody(reply);
 
+    if (reply->error() != QNetworkReply::NoError) {
+        const QString err = errorMessage(body, reply->errorString());
         reply->deleteLater();
-        cb(true, status, json, QString());
-    });
+        cb(false, status, body, err);
+        return;
+    }
+
+    if (status < 200 || status >= 300) {
+        const QString err = errorMessage(body, QString("HTTP %1").arg(status));
+        reply->deleteLater();
+        cb(false, status, body, err);
+        return;
+    }
+
+    earnRetryToken();
+
+    const QByteArray etag = reply->rawHeader("ETag");
+    if (!etag.isEmpty()) {
+        m_responseCache.insert(cacheKey, new CachedResponse{ etag, body });
+    } else {
+        m_responseCache.remove(cacheKey);
+    }
+
+    reply->deleteLater();
+    cb(true, status, body, QString());
 }
 
 // -------- Public API methods --------
@@ -226,27 +837,32 @@ void ApiClient::login(const QString &cardNumber, const QString &pin)
     QJsonObject body;
     body["cardNumber"] = cardNumber.trimmed();
     body["pin"] = pin;
+    body["bootstrap"] = true; // ask for balances/first pages/image in the same reply
+
+    m_loginBootstrap = Body();
 
-    postJson("/auth/login", body,
-    [this](bool ok, int httpStatus, QJsonDocument json, QString error)
+    const RequestId id = beginRequest(nullptr);
+    postBody(id, "/auth/login", body,
+    [this, id](bool ok, int httpStatus, const Body &reply, QString error)
     {
+        if (!finishRequest(id)) return;
+
+        // One pass over the reply; the bootstrap member is only located, not decoded
+        LoginResult result;
+        const bool decoded = decodeTyped(reply, &ReplyDecoder::decodeLogin, &result);
 
         // -------------------------
         // Error handling
         // -------------------------
         if (!ok) {
             // 401: wrong PIN (or unknown cardNumber). Backend may include attemptsLeft.
-            if (httpStatus == 401 && json.isObject()) {
-                const QJsonObject obj = json.object();
-                if (obj.contains("attemptsLeft")) {
-                    const int left = obj.value("attemptsLeft").toInt(-1);
-                    if (left >= 0) {
-                        const int used = 3 - left;
-                        const QString msg = QString("Incorrect PIN (%1/3)").arg(used);
-                        emit loginAccountsResult(false, QJsonArray(), msg);
-                        emit loginResult(false, -1, msg);
-                        return;
-                    }
+            if (httpStatus == 401 && decoded) {
+                if (result.attemptsLeft >= 0) {
+                    const int used = 3 - result.attemptsLeft;
+                    const QString msg = QString("Incorrect PIN (%1/3)").arg(used);
+                    emit loginAccountsResult(false, QJsonArray(), msg);
+                    emit loginResult(false, -1, msg);
+                    return;
                 }
 
                 const QString msg = QStringLiteral("Incorrect card number or PIN");
@@ -275,115 +891,263 @@ void ApiClient::login(const QString &cardNumber, const QString &pin)
         // -------------------------
         // Success handling
         // -------------------------
-        if (!json.isObject()) {
+        if (!decoded) {
             const QString msg = QStringLiteral("Invalid response from server");
             emit loginAccountsResult(false, QJsonArray(), msg);
             emit loginResult(false, -1, msg);
             return;
         }
 
-        const QJsonObject obj = json.object();
-        const bool loginOk = obj.value("ok").toBool(false);
-
-        if (!loginOk) {
+        if (!result.ok) {
             const QString msg = QStringLiteral("Incorrect card number or PIN");
             emit loginAccountsResult(false, QJsonArray(), msg);
             emit loginResult(false, -1, msg);
             return;
         }
 
-        // New format: { ok:true, accounts:[{role, accountId}, ...] }
-        if (obj.contains("accounts") && obj.value("accounts").isArray()) {
-            const QJsonArray accounts = obj.value("accounts").toArray();
-            if (accounts.isEmpty()) {
-                const QString msg = QStringLiteral("The card has no linked accounts");
-                emit loginAccountsResult(false, QJsonArray(), msg);
-                emit loginResult(false, -1, msg);
-                return;
-            }
-
-            emit loginAccountsResult(true, accounts, QString());
-
-            // Backward-compatible: pick one accountId (prefer debit)
-            int preferredId = -1;
-            for (const auto &v : accounts) {
-                const QJsonObject o = v.toObject();
-                if (o.value("role").toString() == "debit") {
-                    preferredId = o.value("accountId").toInt(-1);
-                    break;
-                }
-            }
-            if (preferredId <= 0) {
-                preferredId = accounts.at(0).toObject().value("accountId").toInt(-1);
-            }
-            emit loginResult(true, preferredId, QString());
-            return;
-        }
-
-        // Backward-compatible fallback: { ok:true, accountId:<int> }
-        const int accountId = obj.value("accountId").toInt(-1);
-        if (accountId <= 0) {
-            const QString msg = QStringLiteral("Invalid response from server");
+        // { ok:true, accounts:[{role, accountId}, ...] }, or the old { ok:true, accountId:<int> }
+        // as one debit account
+        if (result.accounts.isEmpty()) {
+            const QString msg = QStringLiteral("The card has no linked accounts");
             emit loginAccountsResult(false, QJsonArray(), msg);
             emit loginResult(false, -1, msg);
             return;
         }
 
         QJsonArray accounts;
-        QJsonObject a;
-        a["role"] = "debit";
-        a["accountId"] = accountId;
-        accounts.append(a);
+        for (const LoginResult::Account &account : result.accounts) {
+            QJsonObject a;
+            a["role"] = account.debit ? QStringLiteral("debit") : QStringLiteral("credit");
+            a["accountId"] = account.accountId;
+            accounts.append(a);
+        }
 
+        if (result.bootstrapEnd > result.bootstrapBegin) {
+            m_loginBootstrap = reply;
+            m_loginBootstrap.raw = reply.raw.mid(result.bootstrapBegin, result.bootstrapEnd - result.bootstrapBegin);
+        }
         emit loginAccountsResult(true, accounts, QString());
-        emit loginResult(true, accountId, QString());
+
+        // Backward-compatible: pick one accountId (prefer debit)
+        emit loginResult(true, result.preferredAccountId(), QString());
     });
 }
 
-void ApiClient::getBalance(int accountId)
+ApiClient::RequestId ApiClient::getBalance(int accountId, QObject* context, BalanceCallback cb)
 {
-    getJson(QString("/accounts/%1/balance").arg(accountId),
-            [this](bool ok, int /*status*/, QJsonDocument json, QString error) {
+    const RequestId id = beginRequest(context);
+    getBody(id, QString("/accounts/%1/balance").arg(accountId),
+            [this, id, cb](bool ok, int /*status*/, const Body &body, QString error) {
+        if (!finishRequest(id)) return;
         if (!ok) {
-            emit balanceResult(false, QJsonObject(), error.isEmpty() ? "Failed to load balance" : error);
+            cb(false, Balance(), error.isEmpty() ? "Failed to load balance" : error);
             return;
         }
-        if (!json.isObject()) {
-            emit balanceResult(false, QJsonObject(), "Invalid response from server");
+        Balance balance;
+        if (!decodeTyped(body, &ReplyDecoder::decodeBalance, &balance)) {
+            cb(false, Balance(), "Invalid response from server");
             return;
         }
-        emit balanceResult(true, json.object(), QString());
+        cb(true, balance, QString());
     });
+    return id;
+}
+
+void ApiClient::setWithdrawOutbox(WithdrawOutbox *outbox)
+{
+    m_outbox = outbox;
+}
+
+ApiClient::RequestId ApiClient::withdraw(int accountId, int amount, QObject* context, JsonObjectCallback cb)
+{
+    WithdrawOutbox::Entry intent;
+    intent.key = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    intent.accountId = accountId;
+    intent.amount = amount;
+    intent.createdMs = QDateTime::currentMSecsSinceEpoch();
+
+    // On disk before the request leaves: from here on a crash is settled by key
+    if (m_outbox && !m_outbox->recordIntent(intent)) {
+        qWarning("Withdraw outbox not written (%s)", qPrintable(m_outbox->path()));
+    }
+
+    const RequestId id = beginRequest(context);
+    m_pending[id].withdrawKey = intent.key;
+    postWithdraw(id, intent, 1, std::move(cb));
+    return id;
 }
 
-void ApiClient::withdraw(int accountId, int amount)
+void ApiClient::postWithdraw(RequestId id, const WithdrawOutbox::Entry &intent, int attempt, JsonObjectCallback cb)
 {
     QJsonObject body;
-    body["amount"] = amount;
+    body["amount"] = intent.amount;
+
+    postJson(id, QString("/accounts/%1/withdraw").arg(intent.accountId), body,
+             [this, id, intent, attempt, cb](bool ok, int status, QJsonDocument json, QString error) {
+        // No answer (or the proxy lost the backend): the same key again cannot withdraw twice
+        const bool noAnswer = !ok && (status == 0 || status == 502 || status == 503 || status == 504);
+
+        // Also when the caller has cancelled meanwhile: the outcome is needed either way
+        if (noAnswer && attempt < WITHDRAW_MAX_ATTEMPTS) {
+            QTimer::singleShot(WITHDRAW_RETRY_BACKOFF_MS * attempt, this, [this, id, intent, attempt, cb]() {
+                if (m_pending.contains(id)) postWithdraw(id, intent, attempt + 1, cb);
+            });
+            return;
+        }
+
+        // Settled with the bank right away, while the customer is still at the kiosk
+        if (noAnswer) {
+            resolveWithdraw(id, intent, cb);
+            return;
+        }
+
+        // Debited, but nobody is left to pay the notes out: credited back
+        if (ok && !isActive(id)) {
+            finishRequest(id);
+            reverseWithdraw(intent);
+            return;
+        }
 
-    postJson(QString("/accounts/%1/withdraw").arg(accountId), body,
-             [this](bool ok, int /*status*/, QJsonDocument json, QString error) {
+        // Any answer from the bank itself is final (a 500 there is rolled back)
+        settleWithdraw(intent.key, ok ? QStringLiteral("completed")
+                                      : status >= 500 ? QStringLiteral("failed") : QStringLiteral("refused"),
+                       status);
+
+        if (!finishRequest(id)) return;
         if (!ok) {
-            emit withdrawResult(false, QJsonObject(), error.isEmpty() ? "Withdraw failed" : error);
+            cb(false, QJsonObject(), error.isEmpty() ? QStringLiteral("Withdraw failed") : error);
             return;
         }
         if (!json.isObject()) {
-            emit withdrawResult(false, QJsonObject(), "Invalid response from server");
+            cb(false, QJsonObject(), "Invalid response from server");
             return;
         }
-        emit withdrawResult(true, json.object(), QString());
-    });
+        cb(true, json.object(), QString());
+    }, intent.key.toLatin1(), WITHDRAW_ATTEMPT_TIMEOUT_MS);
+}
+
+void ApiClient::resolveWithdraw(RequestId id, const WithdrawOutbox::Entry &intent, JsonObjectCallback cb)
+{
+    postJson(id, QString("/accounts/%1/withdrawals/%2/cancel").arg(intent.accountId).arg(intent.key), QJsonObject(),
+             [this, id, intent, cb](bool ok, int /*status*/, QJsonDocument json, QString /*error*/) {
+        const QJsonObject obj = json.object();
+        const QString state = ok ? obj.value("state").toString() : QString();
+
+        // Still unknown: reconcileWithdrawals() finishes it, crediting back if it went through
+        if (state.isEmpty()) {
+            if (m_outbox) m_reconcileTimer.start();
+            if (!finishRequest(id)) return;
+            cb(false, QJsonObject(), m_outbox
+                   ? QStringLiteral("No answer from the bank. If your account was charged, it will be credited back automatically.")
+                   : QStringLiteral("No answer from the bank. The withdrawal is not confirmed."));
+            return;
+        }
+
+        if (state == QLatin1String("completed") && !isActive(id)) {
+            finishRequest(id);
+            reverseWithdraw(intent);
+            return;
+        }
+
+        settleWithdraw(intent.key, state, obj.value("status").toInt());
+        if (!finishRequest(id)) return;
+
+        if (state == QLatin1String("completed")) {
+            cb(true, obj.value("response").toObject(), QString());
+        } else if (state == QLatin1String("refused")) {
+            cb(false, QJsonObject(), extractErrorMessage(QJsonDocument(obj.value("response").toObject()),
+                                                         QStringLiteral("Withdraw failed")));
+        } else {
+            cb(false, QJsonObject(), QStringLiteral("No answer from the bank. The withdrawal was cancelled and your account was not charged."));
+        }
+    }, QByteArray(), WITHDRAW_ATTEMPT_TIMEOUT_MS);
+}
+
+void ApiClient::reverseWithdraw(WithdrawOutbox::Entry entry)
+{
+    entry.reverse = true;
+    // Marked first: a crash from here on still ends in the credit
+    if (m_outbox && !m_outbox->recordReversal(entry.key)) {
+        qWarning("Withdraw outbox not written (%s)", qPrintable(m_outbox->path()));
+    }
+    if (m_reconcilingKeys.contains(entry.key)) return;
+
+    m_reconcilingKeys.insert(entry.key);
+    const RequestId id = beginRequest(nullptr);
+    postJson(id, QString("/accounts/%1/withdrawals/%2/reverse").arg(entry.accountId).arg(entry.key), QJsonObject(),
+             [this, id, entry](bool ok, int status, QJsonDocument json, QString /*error*/) {
+        finishRequest(id);
+        m_reconcilingKeys.remove(entry.key);
+
+        if (ok && json.isObject()) {
+            const QJsonObject obj = json.object();
+            const QString state = obj.value("state").toString();
+            settleWithdraw(entry.key, state, obj.value("status").toInt());
+            emit withdrawalReconciled(entry, state);
+            return;
+        }
+        if (status == 0 || status >= 500) {
+            m_reconcileTimer.start();
+            return;
+        }
+        // Refused by the bank: stays in the outbox, tried again on the next start
+        emit withdrawalReconciled(entry, QStringLiteral("unresolved"));
+    }, QByteArray(), WITHDRAW_ATTEMPT_TIMEOUT_MS);
+}
+
+void ApiClient::settleWithdraw(const QString &key, const QString &outcome, int httpStatus)
+{
+    if (m_outbox && !m_outbox->recordOutcome(key, outcome, httpStatus)) {
+        qWarning("Withdraw outbox not written (%s)", qPrintable(m_outbox->path()));
+    }
 }
 
-void ApiClient::getTransactions(int accountId, int limit)
+void ApiClient::reconcileWithdrawals()
 {
-    // Backward-compatible: first page
-    getTransactionsPage(accountId, limit, QString(), QString());
+    if (!m_outbox) return;
+
+    for (const WithdrawOutbox::Entry &entry : m_outbox->pending()) {
+        if (m_reconcilingKeys.contains(entry.key)) continue;
+        // Still being sent by a live withdraw() (its own answer settles it)
+        const bool live = std::any_of(m_pending.cbegin(), m_pending.cend(),
+                                      [&entry](const Pending &p) { return p.withdrawKey == entry.key; });
+        if (live) continue;
+        if (entry.reverse) {
+            reverseWithdraw(entry);
+            continue;
+        }
+
+        m_reconcilingKeys.insert(entry.key);
+        const RequestId id = beginRequest(nullptr);
+        postJson(id, QString("/accounts/%1/withdrawals/%2/cancel").arg(entry.accountId).arg(entry.key), QJsonObject(),
+                 [this, id, entry](bool ok, int status, QJsonDocument json, QString /*error*/) {
+            finishRequest(id);
+            m_reconcilingKeys.remove(entry.key);
+
+            if (ok && json.isObject()) {
+                const QJsonObject obj = json.object();
+                const QString state = obj.value("state").toString();
+                // Went through after the customer had given up: nothing was paid out
+                if (state == QLatin1String("completed")) {
+                    reverseWithdraw(entry);
+                    return;
+                }
+                settleWithdraw(entry.key, state, obj.value("status").toInt());
+                emit withdrawalReconciled(entry, state);
+                return;
+            }
+            // Bank not reachable yet: try again later. Anything else (e.g. an older
+            // backend without the route) stays pending until the next start.
+            if (status == 0 || status >= 500) m_reconcileTimer.start();
+        });
+    }
 }
 
-void ApiClient::getTransactionsPage(int accountId, int limit,
-                                    const QString& before,
-                                    const QString& after)
+ApiClient::RequestId ApiClient::fetchTransactionsPage(int accountId, int limit,
+                                                     const QString& before,
+                                                     const QString& after,
+                                                     QObject* context,
+                                                     TransactionsPageCallback cb)
 {
     const int safeLimit = (limit <= 0) ? 10 : (limit > 100 ? 100 : limit);
 
@@ -398,35 +1162,185 @@ void ApiClient::getTransactionsPage(int accountId, int limit,
         path += QString("&after=%1").arg(QString(QUrl::toPercentEncoding(after)));
     }
 
-    getJson(path, [this](bool ok, int /*status*/, QJsonDocument json, QString error) {
+    const RequestId id = beginRequest(context);
+    getBody(id, path, [this, id, cb](bool ok, int /*status*/, const Body &body, QString error) {
+        if (!finishRequest(id)) return;
         if (!ok) {
             const QString msg = error.isEmpty() ? "Failed to load transactions" : error;
-            emit transactionsPageResult(false, QJsonArray(), QString(), QString(), msg);
-            emit transactionsResult(false, QJsonArray(), msg);
+            cb(false, TransactionsPage(), msg);
             return;
         }
 
-        // Accept both old (array) and new (object) response shapes
-        if (json.isArray()) {
-            const QJsonArray arr = json.array();
-            emit transactionsPageResult(true, arr, QString(), QString(), QString());
-            emit transactionsResult(true, arr, QString());
+        // Accepts both old (array) and new (object) response shapes
+        TransactionsPage page;
+        if (!decodeTyped(body, &ReplyDecoder::decodeTransactionsPage, &page)) {
+            cb(false, TransactionsPage(), "Invalid response from server");
             return;
         }
+        cb(true, page, QString());
+    });
+    return id;
+}
 
-        if (!json.isObject()) {
-            const QString msg = "Invalid response from server";
-            emit transactionsPageResult(false, QJsonArray(), QString(), QString(), msg);
-            emit transactionsResult(false, QJsonArray(), msg);
+ApiClient::RequestId ApiClient::streamTransactions(int accountId, int limit, const QString& before,
+                                                  QObject* context, RowsCallback onRows,
+                                                  StreamDoneCallback onDone)
+{
+    const int safeLimit = (limit <= 0) ? STREAM_MAX_ROWS : qMin(limit, STREAM_MAX_ROWS);
+
+    QString path = QString("/accounts/%1/transactions?limit=%2&stream=1")
+                       .arg(accountId)
+                       .arg(safeLimit);
+    if (!before.isEmpty()) {
+        path += QString("&before=%1").arg(QString(QUrl::toPercentEncoding(before)));
+    }
+
+    QNetworkRequest req = makeRequest(path);
+    req.setRawHeader("Accept", m_preferCbor ? ACCEPT_CBOR_SEQ_FIRST : QByteArrayLiteral("application/x-ndjson"));
+
+    const RequestId id = beginRequest(context);
+    QNetworkReply *reply = m_net.get(req);
+    trackReply(reply);
+    reply->setReadBufferSize(STREAM_READ_BUFFER);
+    m_pending[id].reply = reply;
+
+    // Undecoded tail of the body + what the trailer said
+    struct StreamState {
+        QByteArray buffer;
+        bool cbor = false;
+        bool formatKnown = false;
+        bool ended = false;
+        bool corrupt = false;
+        int count = 0;
+        QString nextCursor;
+        qint64 decodeNs = 0;
+    };
+    auto state = std::make_shared<StreamState>();
+
+    // Decodes every complete item in the buffer; returns the rows among them
+    const auto decodeAvailable = [this, reply, state]() -> QVector<Transaction> {
+        QVector<Transaction> rows;
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status < 200 || status >= 300) return rows; // error body is parsed in finished
+
+        if (!state->formatKnown) {
+            const QByteArray contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+            state->cbor = contentType.startsWith("application/cbor-seq");
+            state->formatKnown = true;
+        }
+
+        const QByteArray chunk = reply->readAll();
+        if (chunk.isEmpty() || state->ended || state->corrupt) return rows;
+        state->buffer.append(chunk);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const auto takeRecord = [&rows, state](const StatementRecord &record) {
+            if (record.end) {
+                state->ended = true;
+                state->nextCursor = record.nextCursor;
+                return;
+            }
+            rows.append(record.row);
+            ++state->count;
+        };
+
+        qsizetype consumed = 0;
+        StatementRecord record;
+        if (state->cbor) {
+            while (consumed < state->buffer.size() && !state->ended) {
+                // Reader over the unconsumed bytes only (no copy)
+                QCborStreamReader reader(state->buffer.constData() + consumed,
+                                         state->buffer.size() - consumed);
+                if (!ReplyDecoder::readStatementRecord(reader, &record)) {
+                    if (reader.lastError() != QCborError::EndOfFile) state->corrupt = true;
+                    break; // incomplete: wait for the next chunk
+                }
+                consumed += reader.currentOffset();
+                takeRecord(record);
+            }
+        } else {
+            while (!state->ended) {
+                const qsizetype eol = state->buffer.indexOf('\n', consumed);
+                if (eol < 0) break;
+                const bool ok = ReplyDecoder::decodeStatementRecord(
+                    QByteArray::fromRawData(state->buffer.constData() + consumed, eol - consumed), &record);
+                consumed = eol + 1;
+                if (!ok) {
+                    state->corrupt = true;
+                    break;
+                }
+                takeRecord(record);
+            }
+        }
+        state->buffer.remove(0, consumed);
+
+        const qint64 decodeNs = timer.nsecsElapsed();
+        WireStats &stats = state->cbor ? m_cborStats : m_jsonStats;
+        stats.bytes += quint64(chunk.size());
+        stats.decodeNs += decodeNs;
+        state->decodeNs += decodeNs;
+        return rows;
+    };
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, id, reply, state, decodeAvailable, onRows]() {
+        if (!isActive(id)) return;
+        const QVector<Transaction> rows = decodeAvailable();
+        // Garbage in the body: no point downloading the rest
+        if (state->corrupt) {
+            reply->abort();
             return;
         }
+        if (!rows.isEmpty()) onRows(rows);
+    });
 
-        const QJsonObject obj = json.object();
-        const QJsonArray items = obj.value("items").toArray();
-        const QString nextCursor = obj.value("nextCursor").toString();
-        const QString prevCursor = obj.value("prevCursor").toString();
+    connect(reply, &QNetworkReply::finished, this, [this, id, reply, state, decodeAvailable, onRows, onDone]() {
+        if (!isActive(id)) {
+            finishRequest(id);
+            reply->deleteLater();
+            return;
+        }
+
+        if (state->corrupt) {
+            finishRequest(id);
+            reply->deleteLater();
+            onDone(false, state->count, QString(), QStringLiteral("Invalid statement data from server"));
+            return;
+        }
 
-        emit transactionsPageResult(true, items, nextCursor, prevCursor, QString());
-        emit transactionsResult(true, items, QString());
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (reply->error() != QNetworkReply::NoError || status < 200 || status >= 300) {
+            const QString err = errorMessage(takeBody(reply),
+                                             reply->error() != QNetworkReply::NoError ? reply->errorString()
+                                                                                      : QString("HTTP %1").arg(status));
+            finishRequest(id);
+            reply->deleteLater();
+            onDone(false, state->count, QString(), err);
+            return;
+        }
+
+        // Whatever arrived together with the end of the body
+        const QVector<Transaction> rows = decodeAvailable();
+        if (!rows.isEmpty()) onRows(rows);
+        if (!finishRequest(id)) {
+            reply->deleteLater();
+            return;
+        }
+        reply->deleteLater();
+
+        WireStats &stats = state->cbor ? m_cborStats : m_jsonStats;
+        ++stats.responses;
+        const auto timing = m_replyTimings.constFind(reply);
+        if (timing != m_replyTimings.constEnd()) {
+            m_metrics.record(timing->endpoint, RequestMetrics::Decode, state->decodeNs);
+        }
+        if (state->corrupt || !state->ended) {
+            onDone(false, state->count, QString(), QStringLiteral("Incomplete statement from server"));
+            return;
+        }
+        onDone(true, state->count, state->nextCursor, QString());
     });
-}
\ No newline at end of file
+
+    return id;
+}
@@ -7,6 +7,21 @@
 #include <QJsonDocument>
 #include <functional>
 #include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QPair>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QNetworkRequest>
+#include <QTimer>
+
+#include "ReplyDecoder.h"
+#include "RequestMetrics.h"
+#include "WithdrawOutbox.h"
+
+class QNetworkReply;
 
 class ApiClient : public QObject
 {
@@ -17,53 +32,275 @@ public:
     void setBaseUrl(const QString& baseUrl);
     QString baseUrl() const;
 
+    // Connection management
+    // Open the TCP (and TLS for https) connection ahead of the first request.
+    // Cheap to call repeatedly: an already open connection is reused.
+    void prewarm();
+    // Periodic HEAD /health/ping (no database work) while idle so the pooled connection stays
+    // open between customers. The server's idle timeout must be longer (backend/bin/www).
+    // 0 disables. Skipped whenever a real request went out within the interval.
+    void setKeepAliveInterval(int ms);
+    // Use HTTP/2 without negotiation on cleartext http:// (h2c prior knowledge).
+    // https:// always offers HTTP/2 via ALPN.
+    void setHttp2Direct(bool enabled);
+
+    // Wire format
+    // Ask for CBOR first (Accept: application/cbor, application/json;q=0.9). Replies are decoded
+    // by their Content-Type, so a JSON-only server keeps working. On by default.
+    void setPreferCbor(bool enabled);
+
+    // Received body bytes and client-side decode time per format (304 replies have no body)
+    struct WireStats {
+        quint64 responses = 0;
+        quint64 bytes = 0;
+        qint64 decodeNs = 0;
+    };
+    WireStats jsonStats() const { return m_jsonStats; }
+    WireStats cborStats() const { return m_cborStats; }
+
+    // Retries and hedging for GETs, per endpoint (RequestMetrics::endpointFor label,
+    // e.g. "/accounts/:id/balance"). Only connection-level failures and 502/503/504 are
+    // retried; one answer still reaches every waiter of a coalesced GET.
+    struct RetryPolicy {
+        int maxAttempts = 1;        // including the first; 1 = no retries
+        int baseBackoffMs = 100;    // attempt n waits in [d/2, d], d = min(max, base * 2^(n-1))
+        int maxBackoffMs = 2000;
+        bool hedge = false;         // second request once the first is slower than the quantile below
+        double hedgeQuantile = 0.95;
+        int hedgeMinDelayMs = 20;
+        int hedgeMaxDelayMs = 2000;
+    };
+    void setRetryPolicy(const QString& endpoint, const RetryPolicy& policy);
+    RetryPolicy retryPolicy(const QString& endpoint) const;
+    // Token bucket shared by every retry and hedge: each answered GET earns `ratio` tokens
+    // (up to `burst`), each extra attempt spends one. Bounds the extra load to ~ratio of
+    // the traffic when the backend is failing. Defaults: 0.1, 10.
+    void setRetryBudget(double ratio, int burst);
+
+    // Per-endpoint latency histograms (queue, connect, ttfb, download, decode, total)
+    // and retry/hedge counters
+    RequestMetrics& metrics() { return m_metrics; }
+    const RequestMetrics& metrics() const { return m_metrics; }
+
     // API calls
+    // Every call below except login() answers only its own callback and returns the id of
+    // the request. The callback runs at most once, on the GUI thread, and is dropped if
+    // `context` has been destroyed or the request was cancelled. Destroying `context`
+    // cancels everything issued for it. Id 0 means the call was answered synchronously.
+    // A cancelled withdraw() is the exception on the wire: its reply is not aborted (the
+    // bank may commit anyway), only the callback is dropped, and the outcome is recorded.
+    using RequestId = quint64;
+    void cancel(RequestId id);
+    void cancelAll(QObject* context);
+    // Requests issued but not yet answered/cancelled (for leak checks)
+    int pendingRequests() const { return m_pending.size(); }
+    int pendingRequests(QObject* context) const { return m_contextRequests.value(context).size(); }
+    // Replies still alive that no request or coalesced GET owns (aborted ones until
+    // deleteLater has run; anything that stays is a leak)
+    int orphanReplies() const;
+    quint64 cancelledRequests() const { return m_cancelledRequests; }
+
+    // Login result goes to the signals below (one login dialog at a time)
     void login(const QString& cardNumber, const QString& pin);
-    void getBalance(int accountId);
-    void withdraw(int accountId, int amount);
+
+    using JsonObjectCallback = std::function<void(bool ok, QJsonObject data, QString error)>;
+    using BalanceCallback = std::function<void(bool ok, Balance balance, QString error)>;
+    RequestId getBalance(int accountId, QObject* context, BalanceCallback cb);
+    // Every withdrawal carries a fresh Idempotency-Key. Attempts time out quickly and are
+    // repeated with the same key when no answer came back (the bank replays a processed
+    // one instead of withdrawing twice). When no attempt is answered the key is cancelled
+    // at the bank right away: the callback gets the withdrawal if it went through after all,
+    // otherwise an error (not charged). With an outbox the intent is on disk before the POST
+    // leaves; an outcome still unknown at the end is settled by reconcileWithdrawals().
+    // A withdrawal that completes with nobody left to pay it out is credited back.
+    RequestId withdraw(int accountId, int amount, QObject* context, JsonObjectCallback cb);
+    void setWithdrawOutbox(WithdrawOutbox* outbox);
+    // For every pending intent: the bank's stored outcome, or the key is cancelled there
+    // (POST /accounts/:id/withdrawals/:key/cancel). One completed there was never paid out,
+    // so it is credited back (.../reverse). Runs again later while any stay open.
+    void reconcileWithdrawals();
+
     // Transactions
     // First page: call with empty before/after
     // Next (older): before=<nextCursor>
     // Prev (newer): after=<prevCursor>
-    void getTransactionsPage(int accountId, int limit = 10,
-                             const QString& before = QString(),
-                             const QString& after  = QString());
+    using TransactionsPageCallback = std::function<void(bool ok, TransactionsPage page, QString error)>;
+    RequestId fetchTransactionsPage(int accountId, int limit,
+                                    const QString& before, const QString& after,
+                                    QObject* context, TransactionsPageCallback cb);
 
-    // Backward-compatible helper (first page only)
-    void getTransactions(int accountId, int limit = 10);
+    // Full statement: up to `limit` (max 5000) rows older than `before` (empty = newest),
+    // decoded while the body is still arriving (?stream=1, CBOR sequence or NDJSON), each
+    // record straight into a Transaction. onRows gets the rows of each received chunk in
+    // order, newest first; only the undecoded tail of the body is buffered. onDone runs once at the end; nextCursor
+    // continues after the last row (empty = no more).
+    using RowsCallback = std::function<void(const QVector<Transaction>& rows)>;
+    using StreamDoneCallback = std::function<void(bool ok, int count, QString nextCursor, QString error)>;
+    RequestId streamTransactions(int accountId, int limit, const QString& before,
+                                 QObject* context, RowsCallback onRows, StreamDoneCallback onDone);
 
     // Images
-    void fetchImageByFilename(const QString& filename,
-                             std::function<void(const QByteArray& data)> onSuccess,
-                             std::function<void(const QString& error)> onError);
+    RequestId fetchImageByFilename(const QString& filename, QObject* context,
+                                   std::function<void(const QByteArray& data)> onSuccess,
+                                   std::function<void(const QString& error)> onError);
 
     // Helper: get image filename for the customer owning this account (uses /crud/accounts and /crud/customers)
-    void getCustomerImageFilenameForAccount(int accountId,
-                                            std::function<void(bool ok, const QString& filename, const QString& error)> cb);
+    // Both legs run under the same request id.
+    RequestId getCustomerImageFilenameForAccount(int accountId, QObject* context,
+                                                 std::function<void(bool ok, const QString& filename, const QString& error)> cb);
+
+    // Session bootstrap: every linked account with its balance and first transactions page,
+    // plus the customer image filename, in one response:
+    // { accounts:[{role, accountId, balance:{...}, transactions:{items,nextCursor,prevCursor}}],
+    //   customer:{id, image_filename} }
+    // Answered from the login reply when it carried one, otherwise GET /accounts/:id/bootstrap.
+    using BootstrapCallback = std::function<void(bool ok, QJsonObject bootstrap, QString error)>;
+    RequestId getSessionBootstrap(int accountId, QObject* context, BootstrapCallback cb);
+
+    // Conditional-GET cache statistics (hit = server answered 304 Not Modified)
+    quint64 cacheHits() const { return m_cacheHits; }
+    quint64 cacheMisses() const { return m_cacheMisses; }
+    void clearResponseCache();
+
+    // Number of GETs that joined an identical request already in flight
+    quint64 coalescedHits() const { return m_coalescedHits; }
 signals:
     // Backward-compatible: if backend returns multiple accounts, this will pick one (prefer debit).
     void loginResult(bool ok, int accountId, QString error);
     // On success returns linked accounts: [{"role":"debit"|"credit", "accountId": <int>}]
     void loginAccountsResult(bool ok, QJsonArray accounts, QString error);
-    void balanceResult(bool ok, QJsonObject data, QString error);
-    void withdrawResult(bool ok, QJsonObject data, QString error);
-    void transactionsResult(bool ok, QJsonArray data, QString error);
+    // A pending withdrawal was settled: state = refused | cancelled | reversed, or
+    // unresolved when the bank refused the credit back (kept for the next start)
+    void withdrawalReconciled(const WithdrawOutbox::Entry& entry, const QString& state);
 
-    // New: paginated response { items: [...], nextCursor, prevCursor }
-    void transactionsPageResult(bool ok, QJsonArray items,
-                                QString nextCursor, QString prevCursor,
-                                QString error);
+private slots:
+    void onContextDestroyed(QObject* context);
 
 private:
     QNetworkAccessManager m_net;
     QString m_baseUrl;
 
-    void postJson(const QString& path,
-                  const QJsonObject& body,
-                  std::function<void(bool ok, int httpStatus, QJsonDocument json, QString error)> cb);
+    QTimer m_keepAliveTimer;
+    QElapsedTimer m_sinceLastRequest;
+    bool m_http2Direct = false;
+    bool m_preferCbor = true;
+    WireStats m_jsonStats;
+    WireStats m_cborStats;
+
+    // Phase timestamps of one reply (ns since it was handed to QNAM, -1 = not seen)
+    struct ReplyTiming {
+        QString endpoint;
+        QElapsedTimer clock;
+        qint64 connectingNs = -1;
+        qint64 sentNs = -1;
+        qint64 headersNs = -1;
+    };
+    RequestMetrics m_metrics;
+    QHash<QNetworkReply*, ReplyTiming> m_replyTimings;
+    void trackReply(QNetworkReply* reply);
+    void recordReplyTiming(QNetworkReply* reply);
+
+    QNetworkRequest makeRequest(const QString& path);
+    void sendKeepAlive();
+
+    // Reply body as received. Balances, transaction pages and login replies are read
+    // straight into their structs (ReplyDecoder); the rest is decoded into a document.
+    struct Body {
+        QByteArray raw;
+        ReplyDecoder::Format format = ReplyDecoder::Format::Json;
+        QString endpoint; // RequestMetrics label, for the decode time
+    };
+
+    // Bootstrap slice of the last successful login reply, decoded only when
+    // getSessionBootstrap consumes it
+    Body m_loginBootstrap;
+
+    // Last validated response per GET url. The body is kept as received, so a 304
+    // reply is answered without re-downloading it and each caller decodes it into
+    // what it needs.
+    struct CachedResponse {
+        QByteArray etag;
+        Body body;
+    };
+    QCache<QString, CachedResponse> m_responseCache{64}; // LRU, 64 urls
+    quint64 m_cacheHits = 0;
+    quint64 m_cacheMisses = 0;
+
+    // One entry per request id until it is answered or cancelled
+    struct Pending {
+        QPointer<QObject> context;
+        QObject* contextKey = nullptr;  // identity only (context may already be gone)
+        QNetworkReply* reply = nullptr; // reply owned by this request alone (POST, image)
+        QString inflightKey;            // coalesced GET this request is waiting on
+        QString withdrawKey;            // withdrawal (see cancel())
+        bool detached = false;          // withdrawal cancelled by its caller: runs on, answers nobody
+    };
+    QHash<RequestId, Pending> m_pending;
+    QHash<QObject*, QSet<RequestId>> m_contextRequests;
+    RequestId m_nextRequestId = 1;
+    quint64 m_cancelledRequests = 0;
+
+    RequestId beginRequest(QObject* context);
+    // Still worth working on: not cancelled and context alive
+    bool isActive(RequestId id) const;
+    // Ends the request; false means its callback must not run
+    bool finishRequest(RequestId id);
+    void untrackContext(RequestId id, QObject* contextKey);
+
+    using JsonCallback = std::function<void(bool ok, int httpStatus, QJsonDocument json, QString error)>;
+    using BodyCallback = std::function<void(bool ok, int httpStatus, const Body& body, QString error)>;
+    // timeoutMs > 0: no answer by then -> error with status 0
+    void postBody(RequestId id, const QString& path, const QJsonObject& body, BodyCallback cb,
+                  const QByteArray& idempotencyKey = QByteArray(), int timeoutMs = 0);
+    void postJson(RequestId id, const QString& path, const QJsonObject& body, JsonCallback cb,
+                  const QByteArray& idempotencyKey = QByteArray(), int timeoutMs = 0);
+    void getBody(RequestId id, const QString& path, BodyCallback cb);
+    void getJson(RequestId id, const QString& path, JsonCallback cb);
+
+    // GETs in flight per url; later identical requests just add themselves as waiters.
+    // The replies are aborted once the last waiter is cancelled.
+    struct InflightGet {
+        QVector<QNetworkReply*> replies; // current attempt, plus the hedge while both run
+        QNetworkReply* hedgeReply = nullptr;
+        QVector<QPair<RequestId, BodyCallback>> waiters;
+        QNetworkRequest request;
+        QString endpoint;
+        int retries = 0;
+        quint64 serial = 0;              // tells timers apart from a later GET of the same url
+    };
+    QHash<QString, InflightGet> m_inflight;
+    quint64 m_nextInflightSerial = 1;
+    quint64 m_coalescedHits = 0;
+
+    QHash<QString, RetryPolicy> m_retryPolicies;
+    double m_retryBudgetRatio = 0.1;
+    double m_retryBudgetBurst = 10;
+    double m_retryTokens = 10;
+
+    void sendGet(const QString& cacheKey);
+    void scheduleHedge(const QString& cacheKey);
+    void onGetFinished(const QString& cacheKey, QNetworkReply* reply);
+    bool takeRetryToken(const QString& endpoint);
+    void earnRetryToken();
+
+    // Withdrawals
+    WithdrawOutbox* m_outbox = nullptr;
+    QTimer m_reconcileTimer;
+    QSet<QString> m_reconcilingKeys;
+    void postWithdraw(RequestId id, const WithdrawOutbox::Entry& intent, int attempt, JsonObjectCallback cb);
+    void resolveWithdraw(RequestId id, const WithdrawOutbox::Entry& intent, JsonObjectCallback cb);
+    void reverseWithdraw(WithdrawOutbox::Entry entry);
+    void settleWithdraw(const QString& key, const QString& outcome, int httpStatus);
 
-    void getJson(const QString& path,
-                 std::function<void(bool ok, int httpStatus, QJsonDocument json, QString error)> cb);
+    // Reads the body and its format (Content-Type); counts it in the wire stats
+    Body takeBody(QNetworkReply* reply);
+    // Decoders below add their time to the wire stats and the endpoint's decode histogram
+    QJsonDocument decodeDocument(const Body& body, bool* parsed);
+    template <typename T>
+    bool decodeTyped(const Body& body, bool (*decode)(const QByteArray&, ReplyDecoder::Format, T*), T* out);
+    void recordDecode(const Body& body, qint64 decodeNs);
+    // The server's { error } / { message } text, else fallback
+    QString errorMessage(const Body& body, const QString& fallback);
 
     static QString joinUrl(const QString& baseUrl, const QString& path);
     static QString extractErrorMessage(const QJsonDocument& json, const QString& fallback);
@@ -0,0 +1,159 @@
+#include "CassetteInventory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+
+CassetteInventory::CassetteInventory(const QString &path, int notesPerCassette)
+    : m_path(path)
+{
+    if (m_path.isEmpty()) {
+        m_path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                 + QStringLiteral("/cassettes.json");
+    }
+    for (std::size_t i = 0; i < DispensePlanner::KIOSK_DENOMINATIONS.size(); ++i) {
+        m_cassettes[i] = { DispensePlanner::KIOSK_DENOMINATIONS[i], notesPerCassette };
+    }
+}
+
+bool CassetteInventory::open(QString *error)
+{
+    m_persistent = true;
+
+    QFile f(m_path);
+    if (!f.exists()) return true;
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+
+    // { "spec": "50:400,20:800", "cassettes": [{ "denomination": 50, "count": 398 }, ...] }
+    const QJsonObject root = QJsonDocument::fromJson(f.readAll()).object();
+    const QJsonArray saved = root.value("cassettes").toArray();
+    DispensePlanner::Cassettes cassettes{};
+    if (saved.isEmpty() || saved.size() > DispensePlanner::MAX_CASSETTES) {
+        if (error) *error = QStringLiteral("%1: no cassettes").arg(m_path);
+        return false;
+    }
+    for (int i = 0; i < saved.size(); ++i) {
+        const QJsonObject c = saved.at(i).toObject();
+        const int denomination = c.value("denomination").toInt(-1);
+        const int count = c.value("count").toInt(-1);
+        if (denomination <= 0 || count < 0) {
+            if (error) *error = QStringLiteral("%1: bad cassette %2").arg(m_path).arg(i + 1);
+            return false;
+        }
+        cassettes[i] = { denomination, count };
+    }
+
+    m_cassettes = cassettes;
+    m_spec = root.value("spec").toString();
+    return true;
+}
+
+void CassetteInventory::save() const
+{
+    if (!m_persistent) return;
+
+    QJsonArray cassettes;
+    for (const DispensePlanner::Cassette &c : m_cassettes) {
+        if (c.denomination > 0) cassettes.append(QJsonObject{ { "denomination", c.denomination }, { "count", c.count } });
+    }
+    const QJsonObject root{ { "spec", m_spec }, { "cassettes", cassettes } };
+
+    // Atomic: a crash leaves the previous counts, never a torn file
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile f(m_path);
+    if (!f.open(QIODevice::WriteOnly)
+        || f.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+        || !f.commit()) {
+        qWarning("Cassette counts not saved (%s): %s", qPrintable(m_path), qPrintable(f.errorString()));
+    }
+}
+
+bool CassetteInventory::load(const QString &spec, QString *error)
+{
+    DispensePlanner::Cassettes cassettes{};
+    const QStringList parts = spec.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    if (parts.isEmpty() || parts.size() > DispensePlanner::MAX_CASSETTES) {
+        if (error) *error = QStringLiteral("expected 1-%1 denomination:count pairs").arg(DispensePlanner::MAX_CASSETTES);
+        return false;
+    }
+
+    for (int i = 0; i < parts.size(); ++i) {
+        const QStringList pair = parts.at(i).trimmed().split(QLatin1Char(':'));
+        bool okDenomination = false;
+        bool okCount = false;
+        const int denomination = pair.value(0).toInt(&okDenomination);
+        const int count = pair.value(1).toInt(&okCount);
+        if (pair.size() != 2 || !okDenomination || !okCount || denomination <= 0 || count < 0) {
+            if (error) *error = QStringLiteral("bad cassette \"%1\"").arg(parts.at(i).trimmed());
+            return false;
+        }
+        cassettes[i] = { denomination, count };
+    }
+
+    m_cassettes = cassettes;
+    m_spec = spec;
+    save();
+    return true;
+}
+
+CassetteInventory::Check CassetteInventory::check(int amount, DispensePlanner::Plan *plan) const
+{
+    if (amount > maxAmount()) {
+        if (plan) *plan = DispensePlanner::Plan();
+        return Check::AboveLimit;
+    }
+
+    const DispensePlanner::Plan p = DispensePlanner::plan(amount, m_cassettes);
+    if (plan) *plan = p;
+    if (p.ok) return Check::Ok;
+
+    // Tell "never payable" from "ran out": the same denominations without count limits
+    DispensePlanner::Cassettes unlimited = m_cassettes;
+    for (DispensePlanner::Cassette &c : unlimited) c.count = DispensePlanner::UNLIMITED;
+    return DispensePlanner::plan(amount, unlimited).ok ? Check::OutOfNotes : Check::NotPayable;
+}
+
+void CassetteInventory::take(const DispensePlanner::Plan &plan)
+{
+    if (!plan.ok) return;
+    for (int i = 0; i < DispensePlanner::MAX_CASSETTES; ++i) {
+        m_cassettes[i].count = std::max(0, m_cassettes[i].count - plan.notes[i]);
+    }
+    save();
+}
+
+QString CassetteInventory::denominationsText() const
+{
+    QVector<int> denominations;
+    for (const DispensePlanner::Cassette &c : m_cassettes) {
+        if (c.denomination > 0 && !denominations.contains(c.denomination)) denominations.append(c.denomination);
+    }
+    std::sort(denominations.begin(), denominations.end());
+
+    QStringList names;
+    for (int d : denominations) names.append(QStringLiteral("%1€").arg(d));
+    if (names.size() < 2) return names.value(0);
+    const QString last = names.takeLast();
+    return names.join(QStringLiteral(", ")) + QStringLiteral(" and ") + last;
+}
+
+QString CassetteInventory::planText(const DispensePlanner::Plan &plan) const
+{
+    QStringList parts;
+    for (int i = 0; i < DispensePlanner::MAX_CASSETTES; ++i) {
+        if (plan.notes[i] > 0) parts.append(QStringLiteral("%1€ x %2").arg(m_cassettes[i].denomination).arg(plan.notes[i]));
+    }
+    return parts.join(QStringLiteral(", "));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+
+#include "DispensePlanner.h"
+
+// Notes left in the kiosk's cassettes, as far as the client knows: the counts loaded at
+// replenishment (BANK_AUTOMAT_CASSETTES) minus every withdrawal paid out since.
+// Used to refuse an amount the machine cannot pay before asking the bank, and to switch
+// off the quick amounts that have run out.
+//
+// After open() the counts live in a JSON file (default AppLocalDataLocation/cassettes.json),
+// rewritten atomically after every load() and take(), so a restart does not refill the
+// cassettes. The file also keeps the spec the counts were loaded from: a replenishment with
+// exactly the same spec has to remove the file.
+class CassetteInventory
+{
+public:
+    enum class Check {
+        Ok,
+        NotPayable,  // no mix of the fitted denominations pays it
+        OutOfNotes,  // payable in principle, not with the notes that are left
+        AboveLimit,  // more than the planner takes on (maxAmount())
+    };
+
+    // Every fitted denomination with `notesPerCassette` notes, in memory until open()
+    explicit CassetteInventory(const QString& path = QString(),
+                               int notesPerCassette = DEFAULT_NOTES_PER_CASSETTE);
+
+    // Restores the saved counts if there are any; from here on every change is saved.
+    // false = file unreadable (the counts stay as they were and are saved over it)
+    bool open(QString* error = nullptr);
+    QString path() const { return m_path; }
+
+    // "50:400,20:800" (denomination:count, at most MAX_CASSETTES); false leaves it unchanged
+    bool load(const QString& spec, QString* error = nullptr);
+    // Spec the current counts were loaded from (empty = built-in defaults)
+    QString spec() const { return m_spec; }
+
+    Check check(int amount, DispensePlanner::Plan* plan = nullptr) const;
+    // The notes of `plan` were paid out
+    void take(const DispensePlanner::Plan& plan);
+
+    const DispensePlanner::Cassettes& cassettes() const { return m_cassettes; }
+    int maxAmount() const { return DispensePlanner::maxAmount(m_cassettes); }
+    // "20€ and 50€", smallest first
+    QString denominationsText() const;
+    // "50€ x 1, 20€ x 2" for the notes of a plan
+    QString planText(const DispensePlanner::Plan& plan) const;
+
+    static constexpr int DEFAULT_NOTES_PER_CASSETTE = 2000;
+
+private:
+    DispensePlanner::Cassettes m_cassettes{};
+    QString m_spec;
+    QString m_path;
+    bool m_persistent = false;
+
+    void save() const;
+};
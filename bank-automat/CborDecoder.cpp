@@ -0,0 +1,195 @@
+#include "CborDecoder.h"
+
+#include <QCborStreamReader>
+#include <QJsonArray>
+#include <QJsonObject>
+
+// Hostile or corrupt input must not be able to recurse the stack away
+static constexpr int MAX_DEPTH = 32;
+// Decimal fractions of a money column never need more than this
+static constexpr qint64 MAX_DECIMAL_EXPONENT = 18;
+
+static constexpr quint64 TAG_EPOCH_DATETIME = 1;
+static constexpr quint64 TAG_DECIMAL_FRACTION = 4;
+
+QJsonDocument CborDecoder::decode(const QByteArray &data, bool *ok, QString *error)
+{
+    QCborStreamReader reader(data);
+    QJsonValue root;
+
+    const bool valid = (reader.isArray() || reader.isMap())
+                       && readValue(reader, &root, 0)
+                       && reader.lastError() == QCborError::NoError;
+
+    if (ok) *ok = valid;
+    if (!valid) {
+        if (error) {
+            *error = reader.lastError() != QCborError::NoError
+                         ? reader.lastError().toString()
+                         : QStringLiteral("Invalid CBOR document");
+        }
+        return QJsonDocument();
+    }
+
+    return root.isArray() ? QJsonDocument(root.toArray()) : QJsonDocument(root.toObject());
+}
+
+QString CborDecoder::decimalToString(qint64 mantissa, qint64 exponent)
+{
+    const bool negative = mantissa < 0;
+    QString digits = QString::number(negative ? quint64(0) - quint64(mantissa) : quint64(mantissa));
+
+    if (exponent > 0) {
+        digits.append(QString(int(exponent), QLatin1Char('0')));
+    } else if (exponent < 0) {
+        const int scale = int(-exponent);
+        if (digits.size() <= scale) digits.prepend(QString(scale - digits.size() + 1, QLatin1Char('0')));
+        digits.insert(digits.size() - scale, QLatin1Char('.'));
+    }
+
+    if (negative) digits.prepend(QLatin1Char('-'));
+    return digits;
+}
+
+bool CborDecoder::readInteger(QCborStreamReader &reader, qint64 *out)
+{
+    if (!reader.isInteger()) return false;
+    *out = reader.toInteger();
+    return reader.next();
+}
+
+bool CborDecoder::readText(QCborStreamReader &reader, QString *out)
+{
+    // Definite strings arrive in one chunk, indefinite ones in several
+    auto chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        out->append(chunk.data);
+        chunk = reader.readString();
+    }
+    return chunk.status == QCborStreamReader::EndOfString;
+}
+
+bool CborDecoder::readValue(QCborStreamReader &reader, QJsonValue *out, int depth)
+{
+    if (depth > MAX_DEPTH) return false;
+
+    switch (reader.type()) {
+    case QCborStreamReader::UnsignedInteger:
+        *out = double(reader.toUnsignedInteger());
+        return reader.next();
+
+    case QCborStreamReader::NegativeInteger: {
+        // Stored as its absolute value; 0 stands for -2^64
+        const quint64 magnitude = quint64(reader.toNegativeInteger());
+        *out = magnitude ? -double(magnitude) : -18446744073709551616.0;
+        return reader.next();
+    }
+
+    case QCborStreamReader::Float16:
+        *out = double(reader.toFloat16());
+        return reader.next();
+
+    case QCborStreamReader::Float:
+        *out = double(reader.toFloat());
+        return reader.next();
+
+    case QCborStreamReader::Double:
+        *out = reader.toDouble();
+        return reader.next();
+
+    case QCborStreamReader::String: {
+        QString s;
+        if (!readText(reader, &s)) return false;
+        *out = s;
+        return true;
+    }
+
+    case QCborStreamReader::ByteArray: {
+        QByteArray bytes;
+        auto chunk = reader.readByteArray();
+        while (chunk.status == QCborStreamReader::Ok) {
+            bytes.append(chunk.data);
+            chunk = reader.readByteArray();
+        }
+        if (chunk.status != QCborStreamReader::EndOfString) return false;
+        *out = QString::fromLatin1(bytes.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals));
+        return true;
+    }
+
+    case QCborStreamReader::Array: {
+        QJsonArray array;
+        if (!reader.enterContainer()) return false;
+        while (reader.hasNext()) {
+            QJsonValue item;
+            if (!readValue(reader, &item, depth + 1)) return false;
+            array.append(item);
+        }
+        if (!reader.leaveContainer()) return false;
+        *out = array;
+        return true;
+    }
+
+    case QCborStreamReader::Map: {
+        QJsonObject object;
+        if (!reader.enterContainer()) return false;
+        while (reader.hasNext()) {
+            // Keys are always text in our API; anything else is treated as corrupt
+            if (!reader.isString()) return false;
+            QString key;
+            if (!readText(reader, &key)) return false;
+
+            QJsonValue value;
+            if (!readValue(reader, &value, depth + 1)) return false;
+            object.insert(key, value);
+        }
+        if (!reader.leaveContainer()) return false;
+        *out = object;
+        return true;
+    }
+
+    case QCborStreamReader::Tag: {
+        const quint64 tag = quint64(reader.toTag());
+        if (!reader.next()) return false;
+
+        if (tag == TAG_EPOCH_DATETIME) {
+            if (reader.isInteger()) {
+                qint64 secs = 0;
+                if (!readInteger(reader, &secs)) return false;
+                *out = double(secs) * 1000.0;
+                return true;
+            }
+            QJsonValue secs;
+            if (!readValue(reader, &secs, depth + 1) || !secs.isDouble()) return false;
+            *out = double(qRound64(secs.toDouble() * 1000.0));
+            return true;
+        }
+
+        if (tag == TAG_DECIMAL_FRACTION && reader.isArray() && reader.isLengthKnown() && reader.length() == 2) {
+            qint64 exponent = 0;
+            qint64 mantissa = 0;
+            if (!reader.enterContainer()
+                || !readInteger(reader, &exponent)
+                || !readInteger(reader, &mantissa)
+                || !reader.leaveContainer()) {
+                return false;
+            }
+            if (qAbs(exponent) > MAX_DECIMAL_EXPONENT) return false;
+            *out = decimalToString(mantissa, exponent);
+            return true;
+        }
+
+        // Unknown tag: keep the tagged value itself
+        return readValue(reader, out, depth + 1);
+    }
+
+    case QCborStreamReader::SimpleType:
+        // false/true/null/undefined and unassigned simple values
+        if (reader.isBool()) *out = reader.toBool();
+        else *out = QJsonValue();
+        return reader.next();
+
+    case QCborStreamReader::Invalid:
+        return false;
+    }
+    return false;
+}
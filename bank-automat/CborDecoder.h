@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QString>
+
+class QCborStreamReader;
+
+// Single-pass CBOR -> QJsonDocument decoder (QCborStreamReader, no intermediate QCborValue tree).
+// Produces the same document shape as the JSON replies, except for the typed tags the
+// backend uses (backend/cbor.js):
+//   tag 1 (epoch seconds)    -> number, epoch milliseconds
+//   tag 4 (decimal fraction) -> string, e.g. [-2, 1250] -> "12.50" (same text as the JSON DECIMAL)
+// Byte strings become base64url text like QCborValue::toJsonValue. Other tags are ignored.
+// For the replies ApiClient still hands out as documents (session bootstrap, withdrawals);
+// balances, transaction pages, login and the statement stream go through ReplyDecoder.
+class CborDecoder
+{
+public:
+    static QJsonDocument decode(const QByteArray& data, bool* ok = nullptr, QString* error = nullptr);
+
+    static QString decimalToString(qint64 mantissa, qint64 exponent);
+
+private:
+    static bool readValue(QCborStreamReader& reader, QJsonValue* out, int depth);
+    static bool readInteger(QCborStreamReader& reader, qint64* out);
+    static bool readText(QCborStreamReader& reader, QString* out);
+};
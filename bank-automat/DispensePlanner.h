@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+
+// Note mix for a withdrawal: the fewest notes that pay the amount exactly out of what the
+// cassettes still hold, for any set of denominations. Bounded change-making as a DP over
+// the amount in steps of the denominations' gcd; for each cassette a table row keeps how
+// many of its notes the best mix so far uses, so the plan is read back without a search.
+// constexpr throughout: the checks below run at compile time, and an amount costs well
+// under a millisecond on the kiosk, so infeasible input is refused before any request.
+// backend/dispense.js is the same algorithm for the bank's own plan check.
+class DispensePlanner
+{
+public:
+    static constexpr int MAX_CASSETTES = 4;
+    // DP size in gcd steps: 10 000 € with 20 € / 50 € notes
+    static constexpr int MAX_STEPS = 1000;
+    static constexpr int UNLIMITED = std::numeric_limits<int>::max();
+
+    // Notes the kiosk's cassettes are fitted for, largest first (same as backend/dispense.js)
+    static constexpr std::array<int, 2> KIOSK_DENOMINATIONS = { 50, 20 };
+
+    struct Cassette {
+        int denomination = 0; // 0 = slot not fitted
+        int count = 0;
+    };
+    using Cassettes = std::array<Cassette, MAX_CASSETTES>;
+
+    struct Plan {
+        bool ok = false;
+        int noteCount = 0;
+        std::array<int, MAX_CASSETTES> notes{}; // per cassette slot
+    };
+
+    // gcd of the fitted denominations, 0 without any
+    static constexpr int step(const Cassettes &cassettes)
+    {
+        int step = 0;
+        for (const Cassette &c : cassettes) {
+            if (c.denomination > 0) step = std::gcd(step, c.denomination);
+        }
+        return step;
+    }
+
+    // Largest amount plan() looks at; above it there is no plan, whatever the notes
+    static constexpr int maxAmount(const Cassettes &cassettes) { return step(cassettes) * MAX_STEPS; }
+
+    // Fewest notes paying exactly `amount` with at most cassettes[i].count notes from slot i
+    static constexpr Plan plan(int amount, const Cassettes &cassettes)
+    {
+        Plan result;
+        const int step = DispensePlanner::step(cassettes);
+        if (amount <= 0 || step == 0 || amount % step != 0 || amount / step > MAX_STEPS) return result;
+        const int target = amount / step;
+
+        // best[a]: fewest notes for a * step from the cassettes seen so far
+        constexpr int NONE = std::numeric_limits<int>::max();
+        std::array<int, MAX_STEPS + 1> best{};
+        for (int a = 1; a <= target; ++a) best[a] = NONE;
+        // take[i][a]: notes from cassette i in that mix
+        std::array<std::array<short, MAX_STEPS + 1>, MAX_CASSETTES> take{};
+
+        for (int i = 0; i < MAX_CASSETTES; ++i) {
+            const int d = cassettes[i].denomination / step;
+            if (d <= 0 || cassettes[i].count <= 0) continue;
+            // Downwards, so best[a - k * d] is still the mix without cassette i
+            for (int a = target; a >= d; --a) {
+                const int most = std::min(cassettes[i].count, a / d);
+                for (int k = 1; k <= most; ++k) {
+                    const int rest = best[a - k * d];
+                    if (rest != NONE && rest + k < best[a]) {
+                        best[a] = rest + k;
+                        take[i][a] = short(k);
+                    }
+                }
+            }
+        }
+        if (best[target] == NONE) return result;
+
+        int a = target;
+        for (int i = MAX_CASSETTES - 1; i >= 0; --i) {
+            result.notes[i] = take[i][a];
+            a -= take[i][a] * (cassettes[i].denomination / step);
+        }
+        result.ok = true;
+        result.noteCount = best[target];
+        return result;
+    }
+
+    // Denominations with no count limit (the bank's check, the stand-in)
+    template <std::size_t N>
+    static constexpr Cassettes unlimited(const std::array<int, N> &denominations)
+    {
+        static_assert(N <= MAX_CASSETTES, "more denominations than cassette slots");
+        Cassettes cassettes{};
+        for (std::size_t i = 0; i < N; ++i) cassettes[i] = { denominations[i], UNLIMITED };
+        return cassettes;
+    }
+
+    // Notes of one denomination in a plan
+    static constexpr int notesOf(const Plan &plan, const Cassettes &cassettes, int denomination)
+    {
+        int notes = 0;
+        for (int i = 0; i < MAX_CASSETTES; ++i) {
+            if (cassettes[i].denomination == denomination) notes += plan.notes[i];
+        }
+        return notes;
+    }
+};
+
+namespace DispensePlannerChecks {
+constexpr DispensePlanner::Cassettes KIOSK = DispensePlanner::unlimited(DispensePlanner::KIOSK_DENOMINATIONS);
+constexpr DispensePlanner::Cassettes NO_FIFTIES = { { { 50, 0 }, { 20, 10 } } };
+
+static_assert(DispensePlanner::notesOf(DispensePlanner::plan(100, KIOSK), KIOSK, 50) == 2, "100 = 2 x 50");
+static_assert(DispensePlanner::notesOf(DispensePlanner::plan(110, KIOSK), KIOSK, 20) == 3, "110 = 50 + 3 x 20");
+static_assert(DispensePlanner::plan(60, KIOSK).noteCount == 3, "60 = 3 x 20");
+static_assert(!DispensePlanner::plan(30, KIOSK).ok, "30 has no mix");
+static_assert(!DispensePlanner::plan(25, KIOSK).ok, "not a multiple of 10");
+static_assert(DispensePlanner::plan(100, NO_FIFTIES).noteCount == 5, "100 = 5 x 20 without 50s");
+static_assert(!DispensePlanner::plan(220, NO_FIFTIES).ok, "only ten 20s left");
+static_assert(DispensePlanner::maxAmount(KIOSK) == 10000, "10 000 € with 20s and 50s");
+} // namespace DispensePlannerChecks
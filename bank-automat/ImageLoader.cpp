@@ -0,0 +1,227 @@
+#include "ImageLoader.h"
+#include "ApiClient.h"
+#include "TransactionStore.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+static constexpr qsizetype SCALED_CACHE_BYTES  = 32 * 1024 * 1024;
+static constexpr qsizetype ENCODED_CACHE_BYTES = 16 * 1024 * 1024;
+// Disk cache: least recently used files (by mtime) go first past either limit
+static constexpr qint64 DISK_CACHE_BYTES = 64 * 1024 * 1024;
+// Customer data stays on the kiosk's disk no longer than the stored transaction rows
+static constexpr qint64 DISK_CACHE_MAX_AGE_S = TransactionStore::DEFAULT_RETENTION_MS / 1000;
+
+ImageLoader::ImageLoader(ApiClient* api, QObject *parent)
+    : QObject(parent),
+      m_api(api),
+      m_scaled(SCALED_CACHE_BYTES),
+      m_encoded(ENCODED_CACHE_BYTES)
+{
+    m_diskDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                + QStringLiteral("/images");
+    QDir().mkpath(m_diskDir);
+
+    // Whatever earlier runs left behind, off the GUI thread
+    const QString dir = m_diskDir;
+    QThreadPool::globalInstance()->start([dir]() { pruneDiskCache(dir); });
+}
+
+void ImageLoader::pruneDiskCache(const QString& dir)
+{
+    // Newest first: everything past the byte budget or older than the age limit goes
+    const QFileInfoList files = QDir(dir).entryInfoList(QDir::Files, QDir::Time);
+    const QDateTime oldest = QDateTime::currentDateTimeUtc().addSecs(-DISK_CACHE_MAX_AGE_S);
+    qint64 total = 0;
+    for (const QFileInfo& fi : files) {
+        total += fi.size();
+        if (total > DISK_CACHE_BYTES || fi.lastModified() < oldest) QFile::remove(fi.absoluteFilePath());
+    }
+}
+
+QSize ImageLoader::deviceSize(const QSize& targetSize, qreal devicePixelRatio)
+{
+    const qreal dpr = devicePixelRatio > 0 ? devicePixelRatio : 1.0;
+    return QSize(qRound(targetSize.width() * dpr), qRound(targetSize.height() * dpr));
+}
+
+QString ImageLoader::scaledKey(const QString& filename, const QSize& deviceSize)
+{
+    return QStringLiteral("%1@%2x%3").arg(filename).arg(deviceSize.width()).arg(deviceSize.height());
+}
+
+QString ImageLoader::diskPath(const QString& filename) const
+{
+    // Hash the server name so nothing in it can escape the cache directory
+    const QByteArray hash = QCryptographicHash::hash(filename.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_diskDir + QLatin1Char('/') + QString::fromLatin1(hash);
+}
+
+void ImageLoader::forget(const QString& filename)
+{
+    const QString fn = filename.trimmed();
+    if (fn.isEmpty()) return;
+
+    ++m_generation;
+    m_encoded.remove(fn);
+    const QString prefix = fn + QLatin1Char('@');
+    const QList<QString> keys = m_scaled.keys();
+    for (const QString& key : keys) {
+        if (key.startsWith(prefix)) m_scaled.remove(key);
+    }
+
+    // Files past the retention go now rather than with the next store
+    const QString dir = m_diskDir;
+    QThreadPool::globalInstance()->start([dir]() { pruneDiskCache(dir); });
+}
+
+QPixmap ImageLoader::cached(const QString& filename, const QSize& targetSize, qreal devicePixelRatio) const
+{
+    const QPixmap* pix = m_scaled.object(scaledKey(filename.trimmed(), deviceSize(targetSize, devicePixelRatio)));
+    return pix ? *pix : QPixmap();
+}
+
+void ImageLoader::load(const QString& filename, const QSize& targetSize, qreal devicePixelRatio,
+                       QObject* context, Callback cb)
+{
+    const QString fn = filename.trimmed();
+    if (fn.isEmpty()) {
+        cb(QPixmap(), QStringLiteral("No filename"));
+        return;
+    }
+    if (targetSize.isEmpty()) {
+        cb(QPixmap(), QStringLiteral("Empty target size"));
+        return;
+    }
+
+    const QSize devSize = deviceSize(targetSize, devicePixelRatio);
+
+    // 1. Already decoded at this size
+    if (const QPixmap* pix = m_scaled.object(scaledKey(fn, devSize))) {
+        ++m_memoryHits;
+        cb(*pix, QString());
+        return;
+    }
+
+    // 2./3. Bytes in memory or on disk -> decode on the worker
+    const QByteArray* bytes = m_encoded.object(fn);
+    decodeAsync(fn, bytes ? *bytes : QByteArray(), false, devSize, devicePixelRatio,
+                QPointer<QObject>(context), std::move(cb));
+}
+
+void ImageLoader::decodeAsync(const QString& filename, const QByteArray& encoded, bool storeToDisk,
+                              const QSize& deviceSize, qreal devicePixelRatio,
+                              QPointer<QObject> context, Callback cb)
+{
+    const QString path = diskPath(filename);
+    const quint64 generation = m_generation;
+
+    auto *watcher = new QFutureWatcher<DecodeResult>(this);
+    connect(watcher, &QFutureWatcher<DecodeResult>::finished, this,
+            [this, watcher, filename, generation, deviceSize, devicePixelRatio, context, cb]() {
+        const DecodeResult r = watcher->result();
+        watcher->deleteLater();
+
+        // Forgotten meanwhile (the session is over): not kept in memory
+        if (generation != m_generation) return;
+
+        // 4. Not cached anywhere -> download, then store + decode on the worker
+        if (r.needNetwork) {
+            if (!m_api) {
+                if (context) cb(QPixmap(), QStringLiteral("Image not found"));
+                return;
+            }
+            ++m_networkFetches;
+            m_api->fetchImageByFilename(filename, this,
+                [this, filename, generation, deviceSize, devicePixelRatio, context, cb](const QByteArray& data) {
+                    if (generation != m_generation) return;
+                    decodeAsync(filename, data, true, deviceSize, devicePixelRatio, context, cb);
+                },
+                [context, cb](const QString& error) {
+                    if (context) cb(QPixmap(), error);
+                });
+            return;
+        }
+
+        if (r.fromDisk) ++m_diskHits;
+        if (!r.encoded.isEmpty() && r.encoded.size() <= ENCODED_CACHE_BYTES) {
+            m_encoded.insert(filename, new QByteArray(r.encoded), r.encoded.size());
+        }
+
+        if (r.image.isNull()) {
+            if (context) cb(QPixmap(), r.error.isEmpty() ? QStringLiteral("Image decode failed") : r.error);
+            return;
+        }
+
+        // QPixmap must be created on the GUI thread; the decode itself already happened off it
+        QPixmap* pix = new QPixmap(QPixmap::fromImage(r.image));
+        pix->setDevicePixelRatio(devicePixelRatio > 0 ? devicePixelRatio : 1.0);
+        const QPixmap result = *pix;
+        m_scaled.insert(scaledKey(filename, deviceSize), pix, qMax<qsizetype>(1, r.image.sizeInBytes()));
+
+        if (context) cb(result, QString());
+    });
+
+    watcher->setFuture(QtConcurrent::run(&ImageLoader::decode, encoded, path, storeToDisk, deviceSize));
+}
+
+ImageLoader::DecodeResult ImageLoader::decode(QByteArray encoded, const QString& diskPath,
+                                              bool storeToDisk, const QSize& deviceSize)
+{
+    DecodeResult r;
+
+    if (encoded.isEmpty()) {
+        QFile f(diskPath);
+        if (!f.open(QIODevice::ReadOnly)) {
+            r.needNetwork = true;
+            return r;
+        }
+        encoded = f.readAll();
+        r.fromDisk = true;
+        // mtime = last use, for the LRU order of pruneDiskCache()
+        f.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    } else if (storeToDisk) {
+        // Atomic write: a crash never leaves a truncated image behind
+        QSaveFile f(diskPath);
+        if (f.open(QIODevice::WriteOnly)) {
+            f.write(encoded);
+            if (f.commit()) pruneDiskCache(QFileInfo(diskPath).absolutePath());
+        }
+    }
+    r.encoded = encoded;
+
+    r.image = decodeScaled(encoded, deviceSize, &r.error);
+    if (r.image.isNull() && r.fromDisk) {
+        QFile::remove(diskPath); // corrupt cache entry -> refetch next time
+    }
+    return r;
+}
+
+QImage ImageLoader::decodeScaled(const QByteArray& encoded, const QSize& deviceSize, QString* error)
+{
+    QByteArray bytes = encoded; // shared, QBuffer only reads
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+
+    // Decode directly at the display size (JPEG scales during the DCT)
+    const QSize full = reader.size();
+    if (full.isValid() && (full.width() > deviceSize.width() || full.height() > deviceSize.height())) {
+        reader.setScaledSize(full.scaled(deviceSize, Qt::KeepAspectRatio));
+    }
+
+    const QImage image = reader.read();
+    if (image.isNull() && error) *error = reader.errorString();
+    return image;
+}
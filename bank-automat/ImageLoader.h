@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <functional>
+
+class ApiClient;
+
+// Customer photo pipeline.
+// Images are decoded straight to the requested size on a worker thread
+// (QImageReader::setScaledSize), so the GUI thread never touches a
+// full-resolution decode. Lookup order:
+//   1. scaled pixmap cache   (filename, size)
+//   2. encoded bytes cache   (filename) -> decode on worker
+//   3. disk cache            (shared across sessions, LRU by mtime, bounded in bytes and by
+//                             TransactionStore's retention, pruned on start and after every
+//                             store) -> read + decode on worker
+//   4. network               (/images/uploads/<filename>) -> store to disk + decode on worker
+// Upload filenames are server generated and never reused, so cached bytes never go stale.
+// Memory holds a photo only while its customer is at the kiosk: forget() at the end of
+// the session drops it there. The disk copy stays for a returning customer.
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageLoader(ApiClient* api, QObject *parent = nullptr);
+
+    using Callback = std::function<void(const QPixmap& pixmap, const QString& error)>;
+
+    // Loads `filename` scaled to fit targetSize (KeepAspectRatio, device pixels = size * dpr).
+    // cb runs on the GUI thread; it is skipped if `context` has been destroyed meanwhile.
+    void load(const QString& filename, const QSize& targetSize, qreal devicePixelRatio,
+              QObject* context, Callback cb);
+
+    // Non-blocking lookup of an already scaled pixmap (null if not cached)
+    QPixmap cached(const QString& filename, const QSize& targetSize, qreal devicePixelRatio) const;
+
+    // Drops `filename` from the memory caches (loads of it still running keep nothing
+    // there) and prunes the disk cache
+    void forget(const QString& filename);
+
+    QString diskCacheDir() const { return m_diskDir; }
+
+    // The decode step on its own: encoded bytes -> image fitting deviceSize, scaled while
+    // decoding (JPEG scales in the DCT). Thread-safe; null image + error on failure.
+    static QImage decodeScaled(const QByteArray& encoded, const QSize& deviceSize, QString* error = nullptr);
+
+    quint64 memoryHits() const { return m_memoryHits; }
+    quint64 diskHits() const { return m_diskHits; }
+    quint64 networkFetches() const { return m_networkFetches; }
+
+private:
+    struct DecodeResult {
+        QImage image;
+        QByteArray encoded; // bytes that were decoded (read from disk if not given)
+        bool needNetwork = false;
+        bool fromDisk = false;
+        QString error;
+    };
+
+    ApiClient* m_api = nullptr;
+    QString m_diskDir;
+
+    QCache<QString, QPixmap> m_scaled;     // cost = bytes
+    QCache<QString, QByteArray> m_encoded; // cost = bytes
+    quint64 m_generation = 0;              // bumped by forget(): older results are discarded
+
+    quint64 m_memoryHits = 0;
+    quint64 m_diskHits = 0;
+    quint64 m_networkFetches = 0;
+
+    void decodeAsync(const QString& filename, const QByteArray& encoded, bool storeToDisk,
+                     const QSize& deviceSize, qreal devicePixelRatio,
+                     QPointer<QObject> context, Callback cb);
+
+    // Drops the least recently used files past the size/age limits (any thread)
+    static void pruneDiskCache(const QString& dir);
+
+    static QString scaledKey(const QString& filename, const QSize& deviceSize);
+    static QSize deviceSize(const QSize& targetSize, qreal devicePixelRatio);
+    QString diskPath(const QString& filename) const;
+
+    // Worker-thread part: optional disk read/write + scaled decode
+    static DecodeResult decode(QByteArray encoded, const QString& diskPath,
+                               bool storeToDisk, const QSize& deviceSize);
+};
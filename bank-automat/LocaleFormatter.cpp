@@ -0,0 +1,25 @@
+#include "LocaleFormatter.h"
+
+#include <QDateTime>
+
+LocaleFormatter::LocaleFormatter(const QLocale &locale)
+    : m_locale(locale)
+    , m_dateTimeFormat(locale.dateTimeFormat(QLocale::ShortFormat))
+{
+}
+
+const LocaleFormatter &LocaleFormatter::shared()
+{
+    static const LocaleFormatter formatter;
+    return formatter;
+}
+
+QString LocaleFormatter::dateTime(qint64 epochMs) const
+{
+    return m_locale.toString(QDateTime::fromMSecsSinceEpoch(epochMs), m_dateTimeFormat);
+}
+
+QString LocaleFormatter::money(qint64 cents) const
+{
+    return m_locale.toString(double(cents) / 100.0, 'f', 2);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QLocale>
+#include <QString>
+
+// Display text in the kiosk locale. What QLocale would look up on every call (the
+// short date-time pattern of the locale) is resolved once here, so a page of rows
+// costs one format per cell and no pattern lookups.
+class LocaleFormatter
+{
+public:
+    explicit LocaleFormatter(const QLocale& locale = QLocale());
+
+    // For the default locale; GUI thread
+    static const LocaleFormatter& shared();
+
+    // Kiosk local time, QLocale::ShortFormat
+    QString dateTime(qint64 epochMs) const;
+    // Two decimals with the locale's separators ("1 234,50" in fi_FI)
+    QString money(qint64 cents) const;
+
+    const QLocale& locale() const { return m_locale; }
+
+private:
+    QLocale m_locale;
+    QString m_dateTimeFormat;
+};
@@ -1,18 +1,19 @@
 #include "LoginDialog.h"
 #include "ui_LoginDialog.h"
+#include "ActivityMonitor.h"
 #include "ApiClient.h"
 
-#include <QEvent>
 #include <QMessageBox>
 #include <QWidget>
 #include <QLineEdit>
 
 static constexpr int PIN_TIMEOUT_MS = 30 * 1000;
 
-LoginDialog::LoginDialog(ApiClient* api, QWidget *parent)
+LoginDialog::LoginDialog(ApiClient* api, ActivityMonitor* activity, QWidget *parent)
     : QDialog(parent),
       ui(new Ui::LoginDialog),
-      m_api(api)
+      m_api(api),
+      m_activity(activity)
 {
     ui->setupUi(this);
     // Role selection hidden until backend returns multiple linked accounts
@@ -34,25 +35,16 @@ LoginDialog::LoginDialog(ApiClient* api, QWidget *parent)
     connect(ui->pinLineEdit, &QLineEdit::returnPressed,
         this, &LoginDialog::on_loginButton_clicked);
 
-    // --- Resetoi timeout *mistä tahansa* käyttäjäaktiivisuudesta dialogissa ---
-    this->installEventFilter(this);
-    const auto widgets = this->findChildren<QWidget*>();
-    for (QWidget *w : widgets) {
-        w->installEventFilter(this);
-    }
-
-    // --- Inactivity timeout (30 s) ---
-    m_timeoutTimer.setInterval(PIN_TIMEOUT_MS);
-    m_timeoutTimer.setSingleShot(true);
-    connect(&m_timeoutTimer, &QTimer::timeout, this, &LoginDialog::onTimeout);
+    // --- Inactivity timeout (30 s), resetoituu *mistä tahansa* käyttäjäaktiivisuudesta ---
+    // (laskee vain dialogin ollessa näkyvissä: showEvent käynnistää)
+    m_idleWatch = m_activity->watch(PIN_TIMEOUT_MS, this, [this]() { onTimeout(); });
+    m_activity->disarm(m_idleWatch);
 
     // Resetoi timeout käyttäjäaktiivisuudesta
     connect(ui->pinLineEdit, &QLineEdit::textEdited, this, &LoginDialog::resetTimeout);
     connect(ui->cardNumberLineEdit, &QLineEdit::textEdited, this, &LoginDialog::resetTimeout);
     connect(ui->loginButton, &QPushButton::clicked, this, &LoginDialog::resetTimeout);
     connect(ui->cancelButton, &QPushButton::clicked, this, &LoginDialog::resetTimeout);
-
-    m_timeoutTimer.start();
 }
 
 LoginDialog::~LoginDialog()
@@ -94,7 +86,7 @@ void LoginDialog::on_loginButton_clicked()
 
         m_accountRole = role;
         m_accountId = chosenAccountId;
-        m_timeoutTimer.stop();
+        m_activity->disarm(m_idleWatch);
         accept();
         return;
     }
@@ -113,7 +105,7 @@ void LoginDialog::on_loginButton_clicked()
     // Estä timeout laukeamasta kesken backend-vastauksen.
     // Jos login epäonnistuu, käynnistetään timer uudelleen onLoginResultissa.
     m_loginInProgress = true;
-    m_timeoutTimer.stop();
+    m_activity->disarm(m_idleWatch);
 
     // Disable button while waiting
     ui->loginButton->setEnabled(false);
@@ -124,12 +116,15 @@ void LoginDialog::on_loginButton_clicked()
 
 void LoginDialog::on_cancelButton_clicked()
 {
-    m_timeoutTimer.stop();
+    m_activity->disarm(m_idleWatch);
     reject();
 }
 
 void LoginDialog::onLoginResult(bool ok, QJsonArray accounts, QString error)
 {
+    // Reset meanwhile (timeout, customer left): the answer belongs to nobody
+    if (!m_loginInProgress) return;
+
     // Enable button again
     ui->loginButton->setEnabled(true);
     ui->loginButton->setText("Login");
@@ -152,6 +147,9 @@ void LoginDialog::onLoginResult(bool ok, QJsonArray accounts, QString error)
         return;
     }
 
+    // Card and PIN are good: the customer's data can start loading while a role is chosen
+    emit authenticated(m_accounts);
+
     // If only one option -> select automatically
     if (m_accounts.size() == 1) {
         const QJsonObject o = m_accounts.at(0).toObject();
@@ -165,7 +163,7 @@ void LoginDialog::onLoginResult(bool ok, QJsonArray accounts, QString error)
         }
 
     // Onnistunut login -> timer ei saa laueta enää
-    m_timeoutTimer.stop();
+    m_activity->disarm(m_idleWatch);
     accept();  // Sulkee dialogin QDialog::Accepted tilassa
         return;
     }
@@ -200,10 +198,16 @@ void LoginDialog::onLoginResult(bool ok, QJsonArray accounts, QString error)
 
 void LoginDialog::onTimeout()
 {
-    m_timeoutTimer.stop();
-    m_loginInProgress = false;
-
     // 30 s ilman riittävää toimintaa -> takaisin aloitusnäyttöön
+    reset();
+    reject();
+}
+
+void LoginDialog::reset()
+{
+    m_activity->disarm(m_idleWatch);
+    m_loginInProgress = false; // a login still on the way is ignored (onLoginResult)
+
     ui->pinLineEdit->clear();
     ui->cardNumberLineEdit->clear();
     ui->errorLabel->clear();
@@ -217,51 +221,24 @@ void LoginDialog::onTimeout()
 
     m_waitingRoleSelection = false;
     m_accounts = QJsonArray();
-
-    reject();
+    m_accountId = -1;
+    m_accountRole = "debit";
 }
 
 void LoginDialog::resetTimeout()
 {
     // Käyttäjä teki toiminnon -> resetoi aikaraja
     if (m_loginInProgress) return;
-    m_timeoutTimer.start();
-}
-
-bool LoginDialog::eventFilter(QObject *obj, QEvent *event)
-{
-    Q_UNUSED(obj);
-
-    // Kun odotetaan backend-vastausta, ei resetoida / käynnistetä timeria uudelleen.
-    if (!this->isVisible()) {
-        return QDialog::eventFilter(obj, event);
-    }
-
-    // Resetoi 10s laskuri kaikesta relevantista aktiviteetista.
-    switch (event->type()) {
-    case QEvent::KeyPress:
-    case QEvent::KeyRelease:
-    case QEvent::MouseMove:
-    case QEvent::MouseButtonPress:
-    case QEvent::MouseButtonRelease:
-    case QEvent::Wheel:
-    case QEvent::TouchBegin:
-    case QEvent::TouchUpdate:
-    case QEvent::TouchEnd:
-    case QEvent::FocusIn:
-        resetTimeout();
-        break;
-    default:
-        break;
-    }
-
-    return QDialog::eventFilter(obj, event);
+    m_activity->arm(m_idleWatch);
 }
 
 void LoginDialog::showEvent(QShowEvent *event)
 {
     QDialog::showEvent(event);
 
+    // Make sure /auth/login never pays for connection setup
+    if (m_api) m_api->prewarm();
+
     // Clean UI state every time the dialog is shown
     ui->pinLineEdit->clear();
     ui->errorLabel->clear();
@@ -287,4 +264,11 @@ void LoginDialog::showEvent(QShowEvent *event)
 
     m_loginInProgress = false;
     resetTimeout();
-}
\ No newline at end of file
+}
+
+void LoginDialog::hideEvent(QHideEvent *event)
+{
+    // Closed some other way than the buttons (Esc): stop counting until shown again
+    m_activity->disarm(m_idleWatch);
+    QDialog::hideEvent(event);
+}
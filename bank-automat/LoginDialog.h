@@ -1,12 +1,12 @@
 #pragma once
 
 #include <QDialog>
-#include <QEvent>
-#include <QTimer>
 #include <QShowEvent>
+#include <QHideEvent>
 #include <QJsonArray>
 #include <QString>
 
+class ActivityMonitor;
 class ApiClient;
 
 namespace Ui {
@@ -18,17 +18,24 @@ class LoginDialog : public QDialog
     Q_OBJECT
 
 public:
-    explicit LoginDialog(ApiClient* api, QWidget *parent = nullptr);
+    explicit LoginDialog(ApiClient* api, ActivityMonitor* activity, QWidget *parent = nullptr);
     ~LoginDialog();
 
     int accountId() const;
     QString accountRole() const;
 
+    // Empty form, no login pending. The dialog is built once and reused for every
+    // customer: call before showing it and once the result has been read.
+    void reset();
+
+signals:
+    // Login succeeded (accounts: [{role, accountId}]); emitted before the role is chosen
+    void authenticated(const QJsonArray& accounts);
+
 protected:
-    // Reset inactivity timer on any user activity inside the dialog
-    bool eventFilter(QObject *obj, QEvent *event) override;
     // Ensure UI is clean every time the dialog is shown
     void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
     void on_loginButton_clicked();
@@ -47,6 +54,8 @@ private:
     QJsonArray m_accounts;
     bool m_waitingRoleSelection = false;
 
-    QTimer m_timeoutTimer;
+    // Inactivity timeout: any user activity restarts it (shared ActivityMonitor)
+    ActivityMonitor* m_activity = nullptr;
+    quint64 m_idleWatch = 0;
     bool m_loginInProgress = false;
 };
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include "ActivityMonitor.h"
 #include "ApiClient.h"
+#include "CassetteInventory.h"
+#include "ImageLoader.h"
+#include "LocaleFormatter.h"
+#include "ReplyDecoder.h"
+#include "Session.h"
+#include "TransactionsModel.h"
+#include "TransactionStore.h"
 
 #include <QMessageBox>
-#include <QDateTime>
-#include <QLocale>
 #include <QShortcut>
 #include <QTabBar>
 #include <QTabWidget>
@@ -12,147 +18,235 @@
 #include <QEvent>
 #include <QHeaderView>
 #include <QResizeEvent>
+#include <QCloseEvent>
+#include <QHideEvent>
+#include <QShowEvent>
+#include <QScrollBar>
 
 static constexpr int IDLE_TIMEOUT_MS = 30 * 1000;
+static constexpr int IMAGE_RESCALE_DEBOUNCE_MS = 100;
+// Background load of a tab's data: only after the customer and the session's requests
+// have been quiet this long
+static constexpr int IDLE_PREFETCH_MS = 2000;
 
-MainWindow::MainWindow(ApiClient* api, int accountId, QWidget *parent)
-    : MainWindow(api, accountId, QStringLiteral("debit"), parent)
-{
-}
-
-MainWindow::MainWindow(ApiClient* api, int accountId, const QString& role, QWidget *parent)
+MainWindow::MainWindow(ApiClient* api, ImageLoader* images, TransactionStore* txStore,
+                       ActivityMonitor* activity, CassetteInventory* cassettes, QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
       m_api(api),
-      m_accountId(accountId),
-      m_accountRole(role)
+      m_images(images),
+      m_txStore(txStore),
+      m_activity(activity),
+      m_cassettes(cassettes)
 {
     ui->setupUi(this);
+    ui->accountComboBox->setVisible(false); // only for cards with several accounts
 
     // Image UI init
     showImagePlaceholder(QStringLiteral("No image"));
 
-    // Fetch customer's image filename via account -> customer, then fetch image bytes
-    if (m_api) {
-        showImagePlaceholder(QStringLiteral("Loading..."));
-        m_api->getCustomerImageFilenameForAccount(m_accountId,
-            [this](bool ok, const QString& filename, const QString& error) {
-                if (!ok) {
-                    showImagePlaceholder(QStringLiteral("No image"));
-                    return;
-                }
-
-                const QString fn = filename.trimmed();
-                if (fn.isEmpty()) {
-                    showImagePlaceholder(QStringLiteral("No image"));
-                    return;
-                }
-
-                m_api->fetchImageByFilename(fn,
-                    [this](const QByteArray& data) {
-                        setImageFromBytes(data);
-                    },
-                    [this](const QString&) {
-                        showImagePlaceholder(QStringLiteral("Image not found"));
-                    }
-                );
-            }
-        );
-    }
+    m_imageRescaleTimer.setSingleShot(true);
+    m_imageRescaleTimer.setInterval(IMAGE_RESCALE_DEBOUNCE_MS);
+    connect(&m_imageRescaleTimer, &QTimer::timeout, this, &MainWindow::rescaleImageToLabel);
 
-    static constexpr int IDLE_TIMEOUT_MS = 30 * 1000;
-    m_idleTimer.setInterval(IDLE_TIMEOUT_MS);
-    m_idleTimer.setSingleShot(true);
+    m_idlePrefetchTimer.setSingleShot(true);
+    m_idlePrefetchTimer.setInterval(IDLE_PREFETCH_MS);
+    m_idlePrefetchTimer.setTimerType(Qt::CoarseTimer);
+    connect(&m_idlePrefetchTimer, &QTimer::timeout, this, &MainWindow::onIdlePrefetch);
 
-    connect(&m_idleTimer, &QTimer::timeout, this, [this]() {
+    // Any user activity anywhere in the app pushes the timeout back (armed while shown)
+    m_idleWatch = m_activity->watch(IDLE_TIMEOUT_MS, this, [this]() {
         emit idleTimeout();
     });
-
-    // Listen to all app events -> reset timer on any user activity
-    qApp->installEventFilter(this);
-    resetIdleTimer();
-
-    const QString roleTxt = m_accountRole.isEmpty() ? QString("debit") : m_accountRole;
-    setWindowTitle(QString("Bank Automat - %1 (Account %2)").arg(roleTxt, QString::number(m_accountId)));
+    m_activity->disarm(m_idleWatch);
 
     new QShortcut(QKeySequence(Qt::Key_Escape), this, SLOT(close()));
 
-    // Setup transactions table
-    ui->transactionsTable->setColumnCount(3);
-    ui->transactionsTable->setHorizontalHeaderLabels({"Date", "Type", "Amount"});
+    // Setup transactions table (model/view; rows are fetched lazily while scrolling)
+    m_txModel = new TransactionsModel(this);
+    ui->transactionsTable->setModel(m_txModel);
     ui->transactionsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     ui->transactionsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->transactionsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    ui->transactionsTable->setWordWrap(false);
+    ui->transactionsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     ui->transactionsTable->horizontalHeader()->setStretchLastSection(true);
+    // Fixed row heights: the view never has to measure rows while scrolling
+    ui->transactionsTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->transactionsTable->verticalHeader()->setDefaultSectionSize(fontMetrics().height() + 8);
+    sizeTransactionsColumns();
+
+    connect(m_txModel, &TransactionsModel::fetchMoreRequested,
+            this, &MainWindow::onTransactionsFetchMoreRequested);
+
+    // Keep the page index (Prev/Next) in sync with manual scrolling
+    connect(ui->transactionsTable->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        const int topRow = ui->transactionsTable->rowAt(0);
+        if (topRow >= 0) m_txPageIndex = topRow / TX_PAGE_SIZE;
+        updateTransactionsNavUi();
+    });
+}
 
-    // Tabs: show "No transactions" only when the user actually opens the Transactions tab
-    connect(ui->tabWidget, &QTabWidget::currentChanged,
-            this, &MainWindow::on_tabWidget_currentChanged);
+MainWindow::~MainWindow()
+{
+    if (m_session) m_session->end(QStringLiteral("closed"));
+    delete ui;
+}
 
-    // Connect ApiClient signals
-    connect(m_api, &ApiClient::balanceResult,
-            this, &MainWindow::onBalanceResult);
+void MainWindow::reset(Session* session)
+{
+    if (m_session && m_session != session) {
+        disconnect(m_session, nullptr, this, nullptr);
+        m_session->end(QStringLiteral("replaced"));
+    }
+    // Whatever the previous customer left on screen
+    onSessionEnded();
+
+    m_session = session;
+    m_api = session->api();
+    m_accountId = session->accountId();
+    m_accountRole = session->role().isEmpty() ? QStringLiteral("debit") : session->role();
+    connect(session, &Session::ended, this, &MainWindow::onSessionEnded);
+    connect(session, &Session::accountChanged, this, &MainWindow::onAccountChanged);
+
+    ui->accountComboBox->clear();
+    const QJsonArray accounts = session->linkedAccounts();
+    for (const auto &v : accounts) {
+        const QJsonObject o = v.toObject();
+        const int id = o.value("accountId").toInt(-1);
+        if (id <= 0) continue;
+        ui->accountComboBox->addItem(QString("%1 (Account %2)").arg(o.value("role").toString(), QString::number(id)), id);
+    }
+    ui->accountComboBox->setVisible(ui->accountComboBox->count() > 1);
+    updateAccountHeader();
 
-    connect(m_api, &ApiClient::withdrawResult,
-            this, &MainWindow::onWithdrawResult);
+    loadSession();
+}
 
-    connect(m_api, &ApiClient::transactionsPageResult,
-            this, &MainWindow::onTransactionsPageResult);
+void MainWindow::updateAccountHeader()
+{
+    setWindowTitle(QString("Bank Automat - %1 (Account %2)").arg(m_accountRole, QString::number(m_accountId)));
+    const int index = ui->accountComboBox->findData(m_accountId);
+    if (index >= 0) ui->accountComboBox->setCurrentIndex(index);
+}
 
-    // Initial load
-    refreshAll();
+void MainWindow::on_accountComboBox_activated(int index)
+{
+    if (m_session) m_session->selectAccount(ui->accountComboBox->itemData(index).toInt());
 }
 
-MainWindow::~MainWindow()
+void MainWindow::onAccountChanged()
 {
-    qApp->removeEventFilter(this);
-    delete ui;
+    m_accountId = m_session->accountId();
+    m_accountRole = m_session->role().isEmpty() ? QStringLiteral("debit") : m_session->role();
+    updateAccountHeader();
+
+    // Everything shown or on its way belongs to the other account
+    m_api->cancel(m_balanceRequest);
+    m_balanceRequest = 0;
+    resetTransactions();
+    setBusy(false);
+    ui->balanceLabel->setText(QStringLiteral("Balance: -"));
+    m_balanceShown = false;
+    clearWithdrawError();
+
+    // Bootstrap still on its way: it shows whichever account is selected when it lands
+    if (m_bootstrapRequest != 0) return;
+
+    // From what the session already has: the balance, and the first page that the
+    // bootstrap put in the store (then only rows newer than it go over the network)
+    const QJsonObject cached = m_session->accountBootstrap(m_accountId);
+    if (cached.contains("balance")) updateBalanceUi(ReplyDecoder::balance(cached.value("balance").toObject()));
+    else requestBalance();
+    showStoredTransactions();
+    invalidateTransactions();
 }
 
-void MainWindow::resetIdleTimer()
+void MainWindow::showEvent(QShowEvent *event)
 {
-    m_idleTimer.start();
+    QMainWindow::showEvent(event);
+    if (m_session && m_session->isActive()) m_activity->arm(m_idleWatch);
 }
 
-bool MainWindow::eventFilter(QObject *obj, QEvent *event)
+void MainWindow::hideEvent(QHideEvent *event)
 {
-    Q_UNUSED(obj);
+    // Hidden while the customer picks a role (data loading) or between customers
+    m_activity->disarm(m_idleWatch);
+    QMainWindow::hideEvent(event);
+}
 
-    switch (event->type()) {
-    case QEvent::MouseMove:
-    case QEvent::MouseButtonPress:
-    case QEvent::MouseButtonRelease:
-    case QEvent::Wheel:
-    case QEvent::KeyPress:
-    case QEvent::KeyRelease:
-    case QEvent::InputMethod:
-    case QEvent::FocusIn:
-        resetIdleTimer();
-        break;
-    default:
-        break;
-    }
-    return false; // don't swallow events
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    emit closed();
+    QMainWindow::closeEvent(event);
+}
+
+QObject* MainWindow::requestContext()
+{
+    // After the session ended nothing should be issued any more; if something still
+    // is, tie it to the window so the callback cannot outlive it
+    return m_session && m_session->isActive() ? m_session->context() : this;
+}
+
+void MainWindow::onSessionEnded()
+{
+    // The requests are cancelled already (their context is gone); drop the customer's data
+    m_activity->disarm(m_idleWatch);
+    m_imageRescaleTimer.stop();
+    ++m_imageRequestSerial;
+    // Memory copies go with the session; the disk keeps rows and photo within the retention
+    if (m_images) m_images->forget(m_imageFilename);
+    if (m_txStore) m_txStore->expire();
+    m_imageFilename.clear();
+    showImagePlaceholder(QString());
+
+    m_balanceRequest = 0;
+    m_bootstrapRequest = 0;
+    m_idlePrefetchTimer.stop();
+    resetTransactions();
+    m_txNeedsLoad = false;
+    m_txDemanded = false;
+    setBusy(false);
+
+    ui->balanceLabel->setText(QStringLiteral("Balance: -"));
+    m_balanceShown = false;
+    ui->customAmountLineEdit->clear();
+    clearWithdrawError();
+    ui->tabWidget->setCurrentIndex(BalanceTab);
+    m_tabTiming = -1;
 }
 
 void MainWindow::setBusy(bool busy)
 {
     m_busy = busy;
 
+    // No switching accounts under a request (a withdrawal is answered for the account it used)
+    ui->accountComboBox->setEnabled(!busy);
     ui->refreshBalanceButton->setEnabled(!busy);
-    ui->withdraw20Button->setEnabled(!busy);
-    ui->withdraw40Button->setEnabled(!busy);
-    ui->withdraw50Button->setEnabled(!busy);
-    ui->withdraw100Button->setEnabled(!busy);
+    updateWithdrawButtons();
     ui->refreshTransactionsButton->setEnabled(!busy);
+    ui->fullStatementButton->setEnabled(!busy);
 
-    if (ui->prevTransactionsButton) ui->prevTransactionsButton->setEnabled(!busy && !m_prevCursor.isEmpty());
-    if (ui->nextTransactionsButton) ui->nextTransactionsButton->setEnabled(!busy && !m_nextCursor.isEmpty());
+    updateTransactionsNavUi();
 
     if (busy) statusBar()->showMessage("Loading...");
     else statusBar()->clearMessage();
 }
 
+void MainWindow::updateWithdrawButtons()
+{
+    const std::pair<QPushButton*, int> quickAmounts[] = {
+        { ui->withdraw20Button, 20 },
+        { ui->withdraw40Button, 40 },
+        { ui->withdraw50Button, 50 },
+        { ui->withdraw100Button, 100 },
+    };
+    for (const auto &[button, amount] : quickAmounts) {
+        button->setEnabled(!m_busy && m_cassettes->check(amount) == CassetteInventory::Check::Ok);
+    }
+    ui->customWithdrawButton->setEnabled(!m_busy);
+}
+
 void MainWindow::setWithdrawError(const QString& msg)
 {
     if (!ui->withdrawErrorLabel) return;
@@ -169,48 +263,353 @@ void MainWindow::clearWithdrawError()
 void MainWindow::refreshAll()
 {
     requestBalance();
+    invalidateTransactions();
+}
+
+void MainWindow::invalidateTransactions()
+{
+    // Loaded when the Transactions tab is opened, or in the background once things are quiet
+    m_txNeedsLoad = true;
+    if (ui->tabWidget->currentIndex() == TransactionsTab) ensureTransactionsLoaded();
+    else m_idlePrefetchTimer.start();
+}
+
+void MainWindow::refreshTransactionsHead()
+{
+    // Nothing on screen yet: the next load brings the new rows anyway
+    if (m_txNeedsLoad || m_txModel->rowCount() == 0) {
+        invalidateTransactions();
+        return;
+    }
+
+    // Only rows newer than the head go over the network; the loaded rows, the prefetched
+    // older page and the store are kept and the new rows are merged in on top
+    m_api->cancel(m_txDeltaRequest);
+    requestTransactionsDelta(m_txModel->headCursor());
+}
+
+void MainWindow::ensureTransactionsLoaded()
+{
+    if (!m_txNeedsLoad) return;
+    m_txNeedsLoad = false;
     requestTransactionsFirstPage();
 }
 
-void MainWindow::requestBalance()
+void MainWindow::onIdlePrefetch()
 {
+    if (!m_txNeedsLoad || !m_session || !m_session->isActive() || !isVisible()) return;
+
+    // The customer's own requests (balance, withdraw, ...) and input go first
+    if (m_api->pendingRequests(requestContext()) > 0 || m_activity->msSinceActivity() < IDLE_PREFETCH_MS) {
+        m_idlePrefetchTimer.start();
+        return;
+    }
+    ensureTransactionsLoaded();
+}
+
+void MainWindow::loadSession()
+{
+    if (!m_api) return;
+
     setBusy(true);
-    m_api->getBalance(m_accountId);
+    showImagePlaceholder(QStringLiteral("Loading..."));
+    m_txNeedsLoad = true; // the bootstrap brings the first page
+
+    m_bootstrapRequest = m_api->getSessionBootstrap(m_accountId, requestContext(),
+        [this](bool ok, QJsonObject bootstrap, QString /*error*/) {
+            m_bootstrapRequest = 0;
+            setBusy(false);
+            if (ok && applySessionBootstrap(bootstrap)) return;
+
+            // Older backend or bootstrap failed -> separate requests
+            loadCustomerImage();
+            refreshAll();
+        });
+
+    // Still on the network: show the stored rows meanwhile (the bootstrap page replaces them)
+    if (m_bootstrapRequest != 0 && m_txModel->rowCount() == 0) showStoredTransactions();
 }
 
-void MainWindow::requestTransactionsFirstPage()
+bool MainWindow::applySessionBootstrap(const QJsonObject& bootstrap)
 {
+    if (m_session) m_session->setBootstrap(bootstrap);
+
+    QJsonObject account;
+    const QJsonArray accounts = bootstrap.value("accounts").toArray();
+    for (const auto &v : accounts) {
+        const QJsonObject o = v.toObject();
+        const int id = o.value("accountId").toInt(-1);
+        if (id == m_accountId) {
+            account = o;
+        } else if (m_txStore && id > 0) {
+            // Other account of the card: switching to it shows these rows at once
+            const QJsonObject page = o.value("transactions").toObject();
+            m_txStore->putHead(id, page.value("items").toArray(), !page.value("nextCursor").toString().isEmpty());
+        }
+    }
+    if (account.isEmpty()) return false;
+
+    updateBalanceUi(ReplyDecoder::balance(account.value("balance").toObject()));
+
+    const QJsonObject page = account.value("transactions").toObject();
+    resetTransactions();
+    m_txNeedsLoad = false;
+    onTransactionsPageLoaded(true, ReplyDecoder::transactions(page.value("items").toArray()),
+                             page.value("nextCursor").toString(), QString());
+
+    const QString fn = bootstrap.value("customer").toObject()
+                           .value("image_filename").toString().trimmed();
+    if (fn.isEmpty()) {
+        showImagePlaceholder(QStringLiteral("No image"));
+    } else {
+        m_imageFilename = fn;
+        rescaleImageToLabel();
+    }
+    return true;
+}
+
+void MainWindow::loadCustomerImage()
+{
+    if (!m_api || !m_images) return;
+
+    // Fetch customer's image filename via account -> customer, then load the (scaled) image
+    showImagePlaceholder(QStringLiteral("Loading..."));
+    m_api->getCustomerImageFilenameForAccount(m_accountId, requestContext(),
+        [this](bool ok, const QString& filename, const QString& error) {
+            Q_UNUSED(error);
+            if (!ok) {
+                showImagePlaceholder(QStringLiteral("No image"));
+                return;
+            }
+
+            const QString fn = filename.trimmed();
+            if (fn.isEmpty()) {
+                showImagePlaceholder(QStringLiteral("No image"));
+                return;
+            }
+
+            m_imageFilename = fn;
+            rescaleImageToLabel();
+        }
+    );
+}
+
+void MainWindow::requestBalance()
+{
+    // Only the latest refresh matters
+    m_api->cancel(m_balanceRequest);
+
     setBusy(true);
+    m_balanceRequest = m_api->getBalance(m_accountId, requestContext(),
+        [this](bool ok, Balance balance, QString error) {
+            m_balanceRequest = 0;
+            onBalanceResult(ok, balance, error);
+        });
+}
+
+void MainWindow::resetTransactions()
+{
+    // New head -> every loaded row (and any page or prefetch in flight) is stale
+    m_api->cancel(m_txPageRequest);
+    m_api->cancel(m_txPrefetchRequest);
+    m_api->cancel(m_txStatementRequest);
+    m_api->cancel(m_txDeltaRequest);
+    m_txPageRequest = 0;
+    m_txPrefetchRequest = 0;
+    m_txStatementRequest = 0;
+    m_txDeltaRequest = 0;
+    m_txModel->clear();
+    m_txPrefetch = TxPrefetch();
+    m_txScrollToPage = -1;
 
     m_txPageIndex = 0;
-    m_txHistory.clear();
-    m_nextCursor.clear();
-    m_prevCursor.clear();
     m_lastTxMove = TxMove::First;
     m_hasAnyTransactions = false;
     m_noTransactionsPopupShown = false;
     updateTransactionsNavUi();
+}
 
-    m_api->getTransactionsPage(m_accountId, TX_PAGE_SIZE);
+void MainWindow::requestTransactionsFirstPage()
+{
+    if (showStoredTransactions()) {
+        requestTransactionsDelta(m_txModel->headCursor());
+        return;
+    }
+    resetTransactions();
+    requestTransactionsPage(QString());
 }
 
-void MainWindow::requestTransactionsBefore(const QString& beforeCursor)
+bool MainWindow::showStoredTransactions()
+{
+    if (!m_txStore) return false;
+    const QJsonArray stored = m_txStore->recent(m_accountId);
+    if (stored.isEmpty()) return false;
+
+    // Stored rows are contiguous from their newest down -> older pages continue before= the last
+    resetTransactions();
+    m_lastTxMove = TxMove::None;
+    m_hasAnyTransactions = true;
+    m_txModel->appendPage(stored, TransactionStore::cursorOf(stored.last().toObject()));
+    updateTransactionsNavUi();
+    tabDataShown(TransactionsTab);
+    return true;
+}
+
+void MainWindow::requestTransactionsDelta(const QString& after)
 {
     setBusy(true);
-    m_api->getTransactionsPage(m_accountId, TX_PAGE_SIZE, beforeCursor, QString());
+
+    m_txDeltaRequest = m_api->fetchTransactionsPage(m_accountId, TX_DELTA_LIMIT, QString(), after, requestContext(),
+        [this](bool ok, TransactionsPage page, QString /*error*/) {
+            m_txDeltaRequest = 0;
+            setBusy(false);
+
+            if (!ok) {
+                // The stored rows stay up; Refresh tries again
+                statusBar()->showMessage("Showing saved transactions - could not reach the bank.", 5000);
+                return;
+            }
+
+            const QVector<Transaction> &items = page.items;
+            if (items.size() >= TX_DELTA_LIMIT) {
+                // Possibly more new rows than one reply holds: start over from the head
+                resetTransactions();
+                requestTransactionsPage(QString());
+                return;
+            }
+
+            if (!items.isEmpty()) {
+                m_txModel->prependRows(items);
+                if (m_txStore) m_txStore->put(m_accountId, items);
+            }
+            updateTransactionsNavUi();
+            prefetchNextTransactionsPage();
+        });
 }
 
-void MainWindow::requestTransactionsAfter(const QString& afterCursor)
+void MainWindow::requestTransactionsPage(const QString& before)
 {
     setBusy(true);
-    m_api->getTransactionsPage(m_accountId, TX_PAGE_SIZE, QString(), afterCursor);
+
+    m_txPageRequest = m_api->fetchTransactionsPage(m_accountId, TX_PAGE_SIZE, before, QString(), requestContext(),
+        [this](bool ok, TransactionsPage page, QString error) {
+            m_txPageRequest = 0;
+            setBusy(false);
+            onTransactionsPageLoaded(ok, page.items, page.nextCursor, error);
+        });
+}
+
+void MainWindow::onTransactionsFetchMoreRequested(const QString& beforeCursor)
+{
+    // Already prefetched -> append without a round trip
+    if (m_txPrefetch.ready && m_txPrefetch.before == beforeCursor) {
+        const TxPrefetch page = m_txPrefetch;
+        m_txPrefetch = TxPrefetch();
+        onTransactionsPageLoaded(true, page.items, page.nextCursor, QString());
+        return;
+    }
+
+    // The prefetch for this page is still on its way -> wait for it instead of asking twice
+    if (m_txPrefetch.inFlight && m_txPrefetch.before == beforeCursor) {
+        setBusy(true);
+        m_txPrefetch.deliver = true;
+        return;
+    }
+
+    // Next = older items
+    requestTransactionsPage(beforeCursor);
+}
+
+void MainWindow::prefetchNextTransactionsPage()
+{
+    // Older pages only for a customer who has looked at the transactions
+    if (!m_txDemanded) return;
+
+    const QString before = m_txModel->nextCursor();
+    if (before.isEmpty() || m_txPrefetch.inFlight) return;
+    if (m_txPrefetch.ready && m_txPrefetch.before == before) return;
+
+    m_txPrefetch = TxPrefetch();
+    m_txPrefetch.before = before;
+    m_txPrefetch.inFlight = true;
+
+    m_txPrefetchRequest = m_api->fetchTransactionsPage(m_accountId, TX_PAGE_SIZE, before, QString(), requestContext(),
+        [this](bool ok, TransactionsPage page, QString error) {
+            m_txPrefetchRequest = 0;
+            m_txPrefetch.inFlight = false;
+
+            // fetchMore is already waiting for exactly this page
+            if (m_txPrefetch.deliver) {
+                m_txPrefetch = TxPrefetch();
+                setBusy(false);
+                onTransactionsPageLoaded(ok, page.items, page.nextCursor, error);
+                return;
+            }
+
+            // Silent prefetch: errors are ignored, fetchMore will simply go to the network
+            if (!ok) {
+                m_txPrefetch = TxPrefetch();
+                return;
+            }
+            m_txPrefetch.items = page.items;
+            m_txPrefetch.nextCursor = page.nextCursor;
+            m_txPrefetch.ready = true;
+        });
+}
+
+void MainWindow::requestFullStatement()
+{
+    resetTransactions();
+    setBusy(true);
+    m_txModel->beginStream();
+
+    // Rows show up chunk by chunk; the first screen is filled long before the body ends
+    m_txStatementRequest = m_api->streamTransactions(m_accountId, FULL_STATEMENT_ROWS, QString(), requestContext(),
+        [this](const QVector<Transaction>& rows) {
+            m_hasAnyTransactions = true;
+            m_txModel->appendRows(rows);
+            statusBar()->showMessage(QString("Loading statement... %1 rows").arg(m_txModel->rowCount()));
+        },
+        [this](bool ok, int count, QString nextCursor, QString error) {
+            m_txStatementRequest = 0;
+            m_txModel->endStream(ok ? nextCursor : QString());
+            setBusy(false);
+
+            if (!ok) {
+                QMessageBox::warning(this, "Transactions", error.isEmpty() ? "Failed to load statement." : error);
+                return;
+            }
+            statusBar()->showMessage(QString("%1 transactions").arg(count), 3000);
+        });
 }
 
 void MainWindow::doWithdraw(int amount)
 {
     clearWithdrawError();
+
+    // No round trip for an amount the machine cannot pay out
+    DispensePlanner::Plan plan;
+    switch (m_cassettes->check(amount, &plan)) {
+    case CassetteInventory::Check::Ok:
+        break;
+    case CassetteInventory::Check::NotPayable:
+        setWithdrawError(QString("Invalid amount (allowed bills: %1)").arg(m_cassettes->denominationsText()));
+        return;
+    case CassetteInventory::Check::OutOfNotes:
+        setWithdrawError("This machine cannot pay that amount right now. Please choose another amount.");
+        return;
+    case CassetteInventory::Check::AboveLimit:
+        setWithdrawError(QString("Amount above limit (max %1€ per withdrawal)").arg(m_cassettes->maxAmount()));
+        return;
+    }
+
+    // The answer belongs to this account and this plan, whatever is selected by then
     setBusy(true);
-    m_api->withdraw(m_accountId, amount);
+    const int accountId = m_accountId;
+    m_api->withdraw(accountId, amount, requestContext(),
+        [this, accountId, plan](bool ok, QJsonObject data, QString error) {
+            onWithdrawResult(ok, data, error, accountId, plan);
+        });
 }
 
 // -------- UI slots --------
@@ -225,35 +624,36 @@ void MainWindow::on_refreshTransactionsButton_clicked()
     requestTransactionsFirstPage();
 }
 
+void MainWindow::on_fullStatementButton_clicked()
+{
+    requestFullStatement();
+}
+
 void MainWindow::on_prevTransactionsButton_clicked()
 {
     if (m_busy) return;
     if (m_txPageIndex == 0) return;     // <-- prevents "newer than newest" empty page
-    if (m_prevCursor.isEmpty()) return;
-
-    m_txPageIndex -= 1;
-    m_lastTxMove = TxMove::Prev;
-
-    // Restore cursors for the target page (the page we are returning to)
-    if (!m_txHistory.isEmpty()) {
-        const auto target = m_txHistory.takeLast();
-        // We can't set them fully yet (we still need items), but we can restore nextCursor immediately
-        // so Next won't get disabled after returning.
-        m_nextCursor = target.nextCursor;
-        // prevCursor will be set from response (or keep target.prevCursor)
-    }
 
-    requestTransactionsAfter(m_prevCursor);  // newer items
+    // Newer rows are always loaded -> no round trip
+    scrollToTransactionsPage(m_txPageIndex - 1);
 }
 
 void MainWindow::on_nextTransactionsButton_clicked()
 {
-    if (m_busy || m_nextCursor.isEmpty()) return;
-    m_txHistory.push_back({ m_nextCursor, m_prevCursor }); // save current page state
-    m_txPageIndex += 1;
+    if (m_busy) return;
+
+    const int target = m_txPageIndex + 1;
+    if (target * TX_PAGE_SIZE < m_txModel->rowCount()) {
+        scrollToTransactionsPage(target);
+        return;
+    }
+
+    if (!m_txModel->canFetchMore(QModelIndex())) return;
+
+    // Next = older items; scroll once they are appended
     m_lastTxMove = TxMove::Next;
-    // Next = older items
-    requestTransactionsBefore(m_nextCursor);
+    m_txScrollToPage = target;
+    m_txModel->fetchMore(QModelIndex());
 }
 
 void MainWindow::on_withdraw20Button_clicked()  { doWithdraw(20); }
@@ -276,47 +676,60 @@ void MainWindow::on_customWithdrawButton_clicked()
 
 // -------- API result slots --------
 
-void MainWindow::onBalanceResult(bool ok, QJsonObject data, QString error)
+void MainWindow::onBalanceResult(bool ok, const Balance &balance, QString error)
 {
     setBusy(false);
 
     if (!ok) {
-        QMessageBox::warning(this, "Balance", error.isEmpty() ? "Failed to load balance." : error);
+        // Still hidden (loading during role selection): no popup over the login dialog
+        if (isVisible()) QMessageBox::warning(this, "Balance", error.isEmpty() ? "Failed to load balance." : error);
         return;
     }
 
-    updateBalanceUi(data);
+    if (m_session) m_session->updateBalance(m_accountId, balance);
+    updateBalanceUi(balance);
 }
 
-void MainWindow::onWithdrawResult(bool ok, QJsonObject data, QString error)
+void MainWindow::onWithdrawResult(bool ok, QJsonObject data, QString error,
+                                  int accountId, const DispensePlanner::Plan& plan)
 {
     setBusy(false);
+    const bool sameAccount = accountId == m_accountId;
 
     if (!ok) {
         // Näytä withdraw-tabin virheet labelissa
-        setWithdrawError(error.isEmpty() ? "Withdraw failed." : error);
+        if (sameAccount) setWithdrawError(error.isEmpty() ? "Withdraw failed." : error);
         return;
     }
 
     clearWithdrawError();
 
-    // Optional success info:
-    const double newBalance = data.value("balance").toDouble();
-    QString extra;
-
-    if (data.contains("bills") && data.value("bills").isObject()) {
-        const QJsonObject bills = data.value("bills").toObject();
-        const int f = bills.value("50").toInt(0);
-        const int t = bills.value("20").toInt(0);
-        extra = QString("\nBills: 50€ x %1, 20€ x %2").arg(f).arg(t);
+    // The kiosk pays its own plan out of its cassettes (the bank only checks that one exists)
+    m_cassettes->take(plan);
+    const QString bills = m_cassettes->planText(plan);
+    updateWithdrawButtons();
+
+    qint64 newBalanceCents = 0;
+    const bool hasBalance = ReplyDecoder::parseCents(data.value("balance"), &newBalanceCents);
+
+    // The reply carries the new balance; the rest of the balance is what the session has
+    const QJsonObject known = m_session ? m_session->accountBootstrap(accountId).value("balance").toObject()
+                                        : QJsonObject();
+    if (hasBalance && !known.isEmpty()) {
+        Balance balance = ReplyDecoder::balance(known);
+        balance.balanceCents = newBalanceCents;
+        m_session->updateBalance(accountId, balance);
+        if (sameAccount) updateBalanceUi(balance);
+    } else if (sameAccount) {
+        requestBalance();
     }
+    if (sameAccount) refreshTransactionsHead();
 
-    QMessageBox::information(this, "Withdraw",
-                             QString("Withdraw successful.\nNew balance: %1%2")
-                                 .arg(QLocale().toString(newBalance, 'f', 2), extra));
-
-    // Refresh after withdraw -> first page so the new tx is visible
-    refreshAll();
+    // No balance in the reply: none shown rather than a made-up 0,00
+    QString message = QStringLiteral("Withdraw successful.");
+    if (hasBalance) message += QString("\nNew balance: %1").arg(LocaleFormatter::shared().money(newBalanceCents));
+    message += QString("\nBills: %1").arg(bills);
+    QMessageBox::information(this, "Withdraw", message);
 }
 
 void MainWindow::onTransactionsResult(bool ok, QJsonArray data, QString error)
@@ -332,13 +745,13 @@ void MainWindow::onTransactionsResult(bool ok, QJsonArray data, QString error)
     updateTransactionsUi(data);
 }
 
-void MainWindow::onTransactionsPageResult(bool ok, QJsonArray items,
-                                         QString nextCursor, QString prevCursor,
-                                         QString error)
+void MainWindow::onTransactionsPageLoaded(bool ok, const QVector<Transaction>& items,
+                                          const QString& nextCursor, const QString& error)
 {
-    setBusy(false);
-
     if (!ok) {
+        m_lastTxMove = TxMove::None;
+        m_txScrollToPage = -1;
+        m_txModel->fetchFailed();
         QMessageBox::warning(this, "Transactions", error.isEmpty() ? "Failed to load transactions." : error);
         updateTransactionsNavUi();
         return;
@@ -347,74 +760,109 @@ void MainWindow::onTransactionsPageResult(bool ok, QJsonArray items,
     // Empty result handling:
     // - On initial load (First page) an empty list means: there are no transactions for this account.
     //   Do NOT show any popup unless the user is on the Transactions tab.
-    // - On Next/Prev navigation an empty list means: you've reached the end in that direction.
+    // - On Next navigation an empty list means: you've reached the end.
     if (items.isEmpty()) {
+        m_txModel->appendPage(QVector<Transaction>(), QString()); // nothing more to fetch
+        m_txScrollToPage = -1;
+
         if (m_lastTxMove == TxMove::First) {
-            // No transactions at all -> keep UI calm on login.
+            // No transactions at all -> keep UI calm on login (popup only on the tab, once)
             m_hasAnyTransactions = false;
-            m_nextCursor.clear();
-            m_prevCursor.clear();
-            m_lastTxMove = TxMove::None;
-            updateTransactionsUi(QJsonArray());
-            updateTransactionsNavUi();
-            return;
-        }
-
-        // Navigation beyond available pages.
-        if (ui->tabWidget->currentIndex() == 2) {
+            tabDataShown(TransactionsTab);
+            if (ui->tabWidget->currentIndex() == TransactionsTab && !m_noTransactionsPopupShown) {
+                m_noTransactionsPopupShown = true;
+                QMessageBox::information(this, "Transactions", "No transactions.");
+            }
+        } else if (m_lastTxMove == TxMove::Next && ui->tabWidget->currentIndex() == TransactionsTab) {
             QMessageBox::information(this, "Transactions", "No more transactions in that direction.");
         }
 
-        if (m_txPageIndex < 0) m_txPageIndex = 0;
+        m_lastTxMove = TxMove::None;
         updateTransactionsNavUi();
         return;
     }
 
+    m_lastTxMove = TxMove::None;
     m_hasAnyTransactions = true;
     m_noTransactionsPopupShown = false;
 
-    // Only overwrite nextCursor if server gave one.
-    // This prevents "Next" becoming disabled after returning with Prev.
-    if (!nextCursor.isEmpty()) {
-        m_nextCursor = nextCursor;
+    // The head page may not join the stored rows; older pages always do
+    if (m_txStore) {
+        if (m_txModel->rowCount() == 0) m_txStore->putHead(m_accountId, items, !nextCursor.isEmpty());
+        else m_txStore->put(m_accountId, items);
     }
-    // prevCursor can always be overwritten
-    m_prevCursor = prevCursor;
-
-    // nextCursor handling:
-    // - If we moved NEXT (older) or FIRST page: trust server, even if empty -> disables Next at end
-    // - If we moved PREV (newer): server may not provide a meaningful nextCursor for "older" direction,
-    //   so keep whatever we restored from history unless server gives a non-empty value.
-    if (m_lastTxMove == TxMove::Prev) {
-        if (!nextCursor.isEmpty()) {
-            m_nextCursor = nextCursor;
-        }
-    } else {
-        // First/Next/None: overwrite even if empty
-        m_nextCursor = nextCursor;
+
+    m_txModel->appendPage(items, nextCursor);
+
+    if (m_txScrollToPage >= 0) {
+        scrollToTransactionsPage(m_txScrollToPage);
+        m_txScrollToPage = -1;
     }
+    updateTransactionsNavUi();
+    tabDataShown(TransactionsTab);
 
-    m_lastTxMove = TxMove::None;
-    updateTransactionsUi(items);
+    prefetchNextTransactionsPage();
+}
+
+void MainWindow::scrollToTransactionsPage(int pageIndex)
+{
+    const QModelIndex first = m_txModel->index(pageIndex * TX_PAGE_SIZE, 0);
+    if (!first.isValid()) return;
+
+    ui->transactionsTable->scrollTo(first, QAbstractItemView::PositionAtTop);
+    m_txPageIndex = pageIndex;
     updateTransactionsNavUi();
 }
 
+void MainWindow::sizeTransactionsColumns()
+{
+    // Widths come from cached font metrics, never from the row contents
+    QHeaderView* header = ui->transactionsTable->horizontalHeader();
+    const QFont font = ui->transactionsTable->font();
+    header->resizeSection(TransactionsModel::DateColumn,
+                          m_txModel->columnWidthHint(TransactionsModel::DateColumn, font));
+    header->resizeSection(TransactionsModel::TypeColumn,
+                          m_txModel->columnWidthHint(TransactionsModel::TypeColumn, font));
+}
+
 void MainWindow::on_tabWidget_currentChanged(int index)
 {
-    // Transactions tab index is 2 (Balance=0, Withdraw=1, Transactions=2)
-    if (index != 2) return;
+    // Time until the tab shows its data (~0 when it is there already)
+    m_tabClock.start();
+    m_tabTiming = index;
+    if (index == BalanceTab && m_balanceShown) tabDataShown(BalanceTab);
+    if (index != TransactionsTab) return;
+
+    // First look at the transactions: load them if needed, from now on keep the next page ready
+    m_txDemanded = true;
+    ensureTransactionsLoaded();
+    prefetchNextTransactionsPage();
+    if (m_txModel->rowCount() > 0) tabDataShown(TransactionsTab);
 
     // If there are no transactions, show a single informative popup when the user opens the tab.
-    if (!m_busy && !m_hasAnyTransactions && ui->transactionsTable->rowCount() == 0 && !m_noTransactionsPopupShown) {
+    if (!m_busy && !m_hasAnyTransactions && m_txModel->rowCount() == 0 && !m_noTransactionsPopupShown) {
         m_noTransactionsPopupShown = true;
         QMessageBox::information(this, "Transactions", "No transactions.");
     }
 }
 
+void MainWindow::tabDataShown(int tab)
+{
+    if (tab != m_tabTiming || !m_api) return;
+    m_tabTiming = -1;
+    m_api->metrics().recordTransition(tab == TransactionsTab ? QStringLiteral("tab_transactions")
+                                                             : QStringLiteral("tab_balance"),
+                                      m_tabClock.nsecsElapsed());
+}
+
 void MainWindow::updateTransactionsNavUi()
 {
-    const bool canPrev = (!m_busy) && (m_txPageIndex > 0) && (!m_prevCursor.isEmpty());
-    const bool canNext = (!m_busy) && (!m_nextCursor.isEmpty());
+    if (!m_txModel) return;
+
+    const bool canPrev = (!m_busy) && (m_txPageIndex > 0);
+    const bool canNext = (!m_busy)
+                         && ((m_txPageIndex + 1) * TX_PAGE_SIZE < m_txModel->rowCount()
+                             || m_txModel->canFetchMore(QModelIndex()));
 
     if (ui->prevTransactionsButton) ui->prevTransactionsButton->setEnabled(canPrev);
     if (ui->nextTransactionsButton) ui->nextTransactionsButton->setEnabled(canNext);
@@ -422,49 +870,24 @@ void MainWindow::updateTransactionsNavUi()
 
 // -------- UI update helpers --------
 
-void MainWindow::updateBalanceUi(const QJsonObject &data)
+void MainWindow::updateBalanceUi(const Balance &balance)
 {
-    // Backend returns strings for DECIMAL often; handle both string/double
-    const QString balanceStr = data.value("balance").toVariant().toString();
-    const QString typeStr = data.value("account_type").toString("debit");
+    const QString balanceStr = ReplyDecoder::decimalText(balance.balanceCents);
+    const QString typeStr = balance.credit ? QStringLiteral("credit") : QStringLiteral("debit");
 
     const QString modeStr = m_accountRole.isEmpty() ? QString("debit") : m_accountRole;
     ui->balanceLabel->setText(QString("Mode: %1 | Balance: %2 € (%3)")
                                   .arg(modeStr, balanceStr, typeStr));
+    m_balanceShown = true;
+    tabDataShown(BalanceTab);
 }
 
 void MainWindow::updateTransactionsUi(const QJsonArray &rows)
 {
-    ui->transactionsTable->setRowCount(0);
-
-    const int startNumber = (m_txPageIndex * TX_PAGE_SIZE) + 1;
-
-    for (int i = 0; i < rows.size(); ++i) {
-        const QJsonObject obj = rows[i].toObject();
-        const QString createdAt = obj.value("created_at").toString();
-        const QString txType = obj.value("tx_type").toString();
-        const QString amount = obj.value("amount").toVariant().toString();
-
-        ui->transactionsTable->insertRow(i);
-
-        // Date formatting (best-effort)
-        QString dateText = createdAt;
-        // If backend returns "YYYY-MM-DDTHH:MM:SS..." or "YYYY-MM-DD HH:MM:SS"
-        QDateTime dt = QDateTime::fromString(createdAt, Qt::ISODate);
-        if (!dt.isValid()) dt = QDateTime::fromString(createdAt, "yyyy-MM-dd HH:mm:ss");
-        if (dt.isValid()) dateText = QLocale().toString(dt, QLocale::ShortFormat);
-
-        ui->transactionsTable->setItem(i, 0, new QTableWidgetItem(dateText));
-        ui->transactionsTable->setItem(i, 1, new QTableWidgetItem(txType));
-        ui->transactionsTable->setItem(i, 2, new QTableWidgetItem(amount));
-
-        // Set running row number in the vertical header: 1-10, 11-20, ...
-        ui->transactionsTable->setVerticalHeaderItem(
-            i, new QTableWidgetItem(QString::number(startNumber + i))
-        );
-    }
-
-    ui->transactionsTable->resizeColumnsToContents();
+    // Show exactly these rows (no further pages)
+    m_txModel->clear();
+    m_txModel->appendPage(rows, QString());
+    m_txPageIndex = 0;
 }
 
 void MainWindow::showImagePlaceholder(const QString& text)
@@ -472,37 +895,39 @@ void MainWindow::showImagePlaceholder(const QString& text)
     if (!ui || !ui->imageLabel) return;
     ui->imageLabel->clear();
     ui->imageLabel->setText(text);
-    m_originalPixmap = QPixmap();
 }
 
-void MainWindow::setImageFromBytes(const QByteArray& data)
+void MainWindow::showImage(const QPixmap& pixmap)
 {
-    QPixmap pix;
-    if (!pix.loadFromData(data)) {
-        showImagePlaceholder(QStringLiteral("Image decode failed"));
-        return;
-    }
-    m_originalPixmap = pix;
-    rescaleImageToLabel();
+    if (!ui || !ui->imageLabel) return;
+    ui->imageLabel->setPixmap(pixmap);
+    ui->imageLabel->setAlignment(Qt::AlignCenter);
 }
 
 void MainWindow::rescaleImageToLabel()
 {
-    if (!ui || !ui->imageLabel) return;
-    if (m_originalPixmap.isNull()) return;
+    if (!ui || !ui->imageLabel || !m_images) return;
+    if (m_imageFilename.isEmpty()) return;
 
     const QSize target = ui->imageLabel->size();
-    const QPixmap scaled = m_originalPixmap.scaled(
-        target,
-        Qt::KeepAspectRatio,
-        Qt::SmoothTransformation
-    );
-    ui->imageLabel->setPixmap(scaled);
-    ui->imageLabel->setAlignment(Qt::AlignCenter);
+    const qreal dpr = ui->imageLabel->devicePixelRatioF();
+
+    // Decoded + scaled on a worker thread; only the newest request is shown
+    const int serial = ++m_imageRequestSerial;
+    m_images->load(m_imageFilename, target, dpr, requestContext(),
+        [this, serial](const QPixmap& pixmap, const QString& /*error*/) {
+            if (serial != m_imageRequestSerial) return;
+            if (pixmap.isNull()) {
+                showImagePlaceholder(QStringLiteral("Image not found"));
+                return;
+            }
+            showImage(pixmap);
+        });
 }
 
 void MainWindow::resizeEvent(QResizeEvent* event)
 {
     QMainWindow::resizeEvent(event);
-    rescaleImageToLabel();
+    // Debounced: a drag-resize triggers one decode at the final size, not one per event
+    m_imageRescaleTimer.start();
 }
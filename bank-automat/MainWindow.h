@@ -8,8 +8,19 @@
 #include <QVector>
 #include <QPixmap>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QPointer>
 
+#include "DispensePlanner.h"
+#include "ReplyDecoder.h"
+
+class ActivityMonitor;
 class ApiClient;
+class CassetteInventory;
+class ImageLoader;
+class Session;
+class TransactionsModel;
+class TransactionStore;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -20,17 +31,29 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(ApiClient* api, int accountId, QWidget *parent = nullptr);
-    explicit MainWindow(ApiClient* api, int accountId, const QString& role, QWidget *parent = nullptr);
+    // Built once at startup and reused for every customer (see reset())
+    explicit MainWindow(ApiClient* api, ImageLoader* images, TransactionStore* txStore,
+                        ActivityMonitor* activity, CassetteInventory* cassettes,
+                        QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Show a new customer: drops everything of the previous one, then loads the session's
+    // accounts (called while still hidden, as soon as the PIN is accepted). Requests and
+    // image loads are issued under the session's context; when it ends the customer's
+    // data is cleared from the (hidden) window right away.
+    void reset(Session* session);
+
 signals:
     // Emitted after 30 seconds of inactivity. StartWindow should handle returning to start.
     void idleTimeout();
+    // The customer closed the window (Esc)
+    void closed();
 
 protected:
-    bool eventFilter(QObject *obj, QEvent *event) override;
     void resizeEvent(QResizeEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
 
 private slots:
     // UI events
@@ -42,65 +65,130 @@ private slots:
     void on_refreshTransactionsButton_clicked();
     void on_prevTransactionsButton_clicked();
     void on_nextTransactionsButton_clicked();
+    void on_fullStatementButton_clicked();
     void on_customWithdrawButton_clicked();
+    // Debit/credit of the same card, from what the session already holds
+    void on_accountComboBox_activated(int index);
 
     // Tabs
     void on_tabWidget_currentChanged(int index);
 
     // API results
-    void onBalanceResult(bool ok, QJsonObject data, QString error);
-    void onWithdrawResult(bool ok, QJsonObject data, QString error);
+    void onBalanceResult(bool ok, const Balance& balance, QString error);
+    void onWithdrawResult(bool ok, QJsonObject data, QString error,
+                          int accountId, const DispensePlanner::Plan& plan);
     void onTransactionsResult(bool ok, QJsonArray data, QString error);
-    void onTransactionsPageResult(bool ok, QJsonArray items,
-                                  QString nextCursor, QString prevCursor,
-                                  QString error);
 
 private:
     Ui::MainWindow *ui;
+    QPointer<Session> m_session;
     ApiClient* m_api = nullptr;
+    ImageLoader* m_images = nullptr;
+    TransactionStore* m_txStore = nullptr; // may be null or not open
     int m_accountId = -1;
     QString m_accountRole = "debit";
 
     void refreshAll();
+
+    // Tabs load their data on demand. Balance comes with the session; the transactions
+    // on opening their tab, or earlier once customer and network are idle (onIdlePrefetch).
+    enum Tab { BalanceTab = 0, WithdrawTab = 1, TransactionsTab = 2 };
+    void invalidateTransactions();
+    // After a withdrawal: rows newer than the loaded head only (after=<head cursor>)
+    void refreshTransactionsHead();
+    void ensureTransactionsLoaded();
+    void onIdlePrefetch();
+    // Records tab open -> data shown (UI transition "tab_balance" / "tab_transactions")
+    void tabDataShown(int tab);
+    bool m_txNeedsLoad = false;
+    bool m_txDemanded = false; // Transactions tab opened this session: keep older pages prefetched
+    bool m_balanceShown = false;
+    QTimer m_idlePrefetchTimer;
+    QElapsedTimer m_tabClock;
+    int m_tabTiming = -1; // tab whose load is being timed
+    // Context for ApiClient/ImageLoader calls: the session's while it is active
+    QObject* requestContext();
+    // Session ended (idle timeout, logout): drop the customer's rows, photo and pending work
+    void onSessionEnded();
+    void onAccountChanged();
+    void updateAccountHeader();
     void requestBalance();
 
-    void requestTransactionsFirstPage();
-    void requestTransactionsBefore(const QString& beforeCursor);
-    void requestTransactionsAfter(const QString& afterCursor);
+    // Initial load: one bootstrap request (balance, first page, image) with per-call fallback
+    void loadSession();
+    bool applySessionBootstrap(const QJsonObject& bootstrap);
+    void loadCustomerImage();
 
+    void resetTransactions();
+    void requestTransactionsFirstPage();
+    void requestTransactionsPage(const QString& before);
+    // Stored rows first, then only what is newer than them (after=<newest stored>)
+    bool showStoredTransactions();
+    void requestTransactionsDelta(const QString& after);
+    void onTransactionsPageLoaded(bool ok, const QVector<Transaction>& items,
+                                  const QString& nextCursor, const QString& error);
+    void onTransactionsFetchMoreRequested(const QString& beforeCursor);
+    void prefetchNextTransactionsPage();
+    void requestFullStatement();
+
+    // Refused right here if the cassettes cannot pay it; otherwise sent with the note plan kept
     void doWithdraw(int amount);
+    // Quick amounts enabled only while the cassettes can pay them
+    void updateWithdrawButtons();
 
     void setBusy(bool busy);
-    void updateBalanceUi(const QJsonObject& data);
+    void updateBalanceUi(const Balance& balance);
     void updateTransactionsUi(const QJsonArray& rows);
     void updateTransactionsNavUi();
+    void scrollToTransactionsPage(int pageIndex);
+    void sizeTransactionsColumns();
     // Image helpers
     void showImagePlaceholder(const QString& text = QStringLiteral("No image"));
-    void setImageFromBytes(const QByteArray& data);
+    void showImage(const QPixmap& pixmap);
     void rescaleImageToLabel();
 
     void setWithdrawError(const QString& msg);
     void clearWithdrawError();
 
     bool m_busy = false;
+    CassetteInventory* m_cassettes = nullptr;
+    quint64 m_balanceRequest = 0; // ApiClient request id of the refresh in flight
+    quint64 m_bootstrapRequest = 0;
 
-    QPixmap m_originalPixmap;
+    // Customer photo: decoded off the GUI thread at label size; resizes are debounced
+    QString m_imageFilename;
+    QTimer m_imageRescaleTimer;
+    int m_imageRequestSerial = 0;
 
     // 30s inactivity handling
-    void resetIdleTimer();
-    QTimer m_idleTimer;
+    ActivityMonitor* m_activity = nullptr;
+    quint64 m_idleWatch = 0;
     static constexpr int TX_PAGE_SIZE = 10;
-    QString m_nextCursor;
-    QString m_prevCursor;
-    int m_txPageIndex = 0; // 0 = newest page, 1 = next older page, ...
-
-    struct TxPageCursors {
+    static constexpr int FULL_STATEMENT_ROWS = 5000;
+    static constexpr int TX_DELTA_LIMIT = 100; // a full delta may leave a gap -> reload the head
+    TransactionsModel* m_txModel = nullptr; // all loaded rows, newest first
+    int m_txPageIndex = 0; // page at the top of the view: 0 = newest, 1 = next older, ...
+    int m_txScrollToPage = -1; // Next pressed past the loaded rows -> scroll there once loaded
+
+    // Background load of the next older page (before=<model nextCursor>).
+    // fetchMore() takes it from here instead of going to the network.
+    struct TxPrefetch {
+        QString before;
+        QVector<Transaction> items;
         QString nextCursor;
-        QString prevCursor;
+        bool inFlight = false;
+        bool ready = false;
+        bool deliver = false; // fetchMore asked for it while still in flight
     };
-    QVector<TxPageCursors> m_txHistory; // stack of pages (page 0,1,2...)
+    TxPrefetch m_txPrefetch;
+
+    // Page loads in flight (ApiClient request ids); cancelled whenever the loaded rows are dropped
+    quint64 m_txPageRequest = 0;
+    quint64 m_txPrefetchRequest = 0;
+    quint64 m_txStatementRequest = 0;
+    quint64 m_txDeltaRequest = 0;
 
-    enum class TxMove { None, First, Next, Prev };
+    enum class TxMove { None, First, Next };
     TxMove m_lastTxMove = TxMove::None;
 
     // Used to avoid showing a transactions popup on login when the user is not on the Transactions tab.
@@ -0,0 +1,1024 @@
+#include "ReplyDecoder.h"
+
+#include <QCborStreamReader>
+#include <QDate>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTime>
+#include <cstring>
+#include <limits>
+
+// Hostile or corrupt input must not be able to recurse the stack away
+static constexpr int MAX_DEPTH = 32;
+// Decimal fractions of a money column never need more than this
+static constexpr qint64 MAX_DECIMAL_EXPONENT = 18;
+// Whole units that still fit in cents
+static constexpr qint64 MAX_UNITS = std::numeric_limits<qint64>::max() / 1000;
+
+static constexpr quint64 TAG_EPOCH_DATETIME = 1;
+static constexpr quint64 TAG_DECIMAL_FRACTION = 4;
+
+// Longest key / enum-like text compared without allocating (an ISO timestamp with
+// milliseconds and offset is 29)
+static constexpr qsizetype WORD_CAPACITY = 32;
+
+template <std::size_t N>
+static bool is(QByteArrayView text, const char (&literal)[N])
+{
+    return text.size() == qsizetype(N - 1) && std::memcmp(text.data(), literal, N - 1) == 0;
+}
+
+template <typename Char>
+static bool isDigit(Char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+template <typename Char>
+static bool isSpace(Char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// `count` digits at p[pos]
+template <typename Char>
+static bool digitsAt(const Char *p, qsizetype n, qsizetype pos, int count, int *out)
+{
+    if (pos + count > n) return false;
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const Char c = p[pos + i];
+        if (!isDigit(c)) return false;
+        value = value * 10 + int(c - '0');
+    }
+    *out = value;
+    return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant, days_from_civil)
+static constexpr qint64 daysFromCivil(int y, int m, int d)
+{
+    y -= m <= 2;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = int(y - era * 400);
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(daysFromCivil(2025, 1, 1) == 20089, "2025");
+
+template <typename Char>
+static bool parseIntegerT(const Char *p, qsizetype n, qint64 *out)
+{
+    qsizetype i = 0;
+    const bool negative = n > 0 && p[0] == '-';
+    if (negative) ++i;
+    if (i == n) return false;
+
+    qint64 value = 0;
+    for (; i < n; ++i) {
+        if (!isDigit(p[i])) return false;
+        const int digit = int(p[i] - '0');
+        if (value > (std::numeric_limits<qint64>::max() - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    *out = negative ? -value : value;
+    return true;
+}
+
+template <typename Char>
+static bool parseCentsT(const Char *p, qsizetype n, qint64 *cents)
+{
+    qsizetype i = 0;
+    while (i < n && isSpace(p[i])) ++i;
+    while (n > i && isSpace(p[n - 1])) --n;
+
+    bool negative = false;
+    if (i < n && (p[i] == '-' || p[i] == '+')) {
+        negative = p[i] == '-';
+        ++i;
+    }
+
+    qint64 units = 0;
+    int unitDigits = 0;
+    for (; i < n && isDigit(p[i]); ++i, ++unitDigits) {
+        if (units > MAX_UNITS) return false;
+        units = units * 10 + int(p[i] - '0');
+    }
+
+    qint64 fraction = 0;
+    int fractionDigits = 0;
+    if (i < n && p[i] == '.') {
+        for (++i; i < n && isDigit(p[i]); ++i, ++fractionDigits) {
+            if (fractionDigits < 2) fraction = fraction * 10 + int(p[i] - '0');
+        }
+    }
+    if (i != n || unitDigits + fractionDigits == 0) return false;
+    if (fractionDigits == 1) fraction *= 10;
+
+    *cents = (units * 100 + fraction) * (negative ? -1 : 1);
+    return true;
+}
+
+template <typename Char>
+static bool parseTimestampT(const Char *p, qsizetype n, qint64 *epochMs)
+{
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (n < 19) return false;
+    if (!digitsAt(p, n, 0, 4, &year) || p[4] != '-'
+        || !digitsAt(p, n, 5, 2, &month) || p[7] != '-'
+        || !digitsAt(p, n, 8, 2, &day) || (p[10] != 'T' && p[10] != ' ')
+        || !digitsAt(p, n, 11, 2, &hour) || p[13] != ':'
+        || !digitsAt(p, n, 14, 2, &minute) || p[16] != ':'
+        || !digitsAt(p, n, 17, 2, &second)) {
+        return false;
+    }
+    if (!QDate::isValid(year, month, day) || hour > 23 || minute > 59 || second > 59) return false;
+
+    qsizetype i = 19;
+    int ms = 0;
+    if (i < n && p[i] == '.') {
+        const qsizetype start = ++i;
+        for (int scale = 100; i < n && isDigit(p[i]); ++i, scale /= 10) ms += int(p[i] - '0') * scale;
+        if (i == start) return false;
+    }
+
+    bool zoned = false;
+    qint64 offsetMs = 0;
+    if (i < n && (p[i] == 'Z' || p[i] == 'z')) {
+        zoned = true;
+        ++i;
+    } else if (i < n && (p[i] == '+' || p[i] == '-')) {
+        // +HH:MM, +HHMM or +HH
+        const int sign = p[i] == '-' ? -1 : 1;
+        int offsetHours = 0;
+        int offsetMinutes = 0;
+        if (!digitsAt(p, n, i + 1, 2, &offsetHours)) return false;
+        i += 3;
+        if (i < n && p[i] == ':') ++i;
+        if (i < n) {
+            if (!digitsAt(p, n, i, 2, &offsetMinutes)) return false;
+            i += 2;
+        }
+        zoned = true;
+        offsetMs = sign * qint64(offsetHours * 60 + offsetMinutes) * 60000;
+    }
+    if (i != n) return false;
+
+    if (!zoned) {
+        // SQL DATETIME text: kiosk local time
+        *epochMs = QDateTime(QDate(year, month, day), QTime(hour, minute, second, ms)).toMSecsSinceEpoch();
+        return true;
+    }
+    *epochMs = daysFromCivil(year, month, day) * 86400000
+               + qint64((hour * 60 + minute) * 60 + second) * 1000 + ms - offsetMs;
+    return true;
+}
+
+bool ReplyDecoder::parseCents(QByteArrayView text, qint64 *cents)
+{
+    return parseCentsT(text.data(), text.size(), cents);
+}
+
+bool ReplyDecoder::parseCents(QStringView text, qint64 *cents)
+{
+    return parseCentsT(text.utf16(), text.size(), cents);
+}
+
+bool ReplyDecoder::parseCents(const QJsonValue &value, qint64 *cents)
+{
+    if (value.isDouble()) {
+        *cents = qRound64(value.toDouble() * 100.0);
+        return true;
+    }
+    if (!value.isString()) return false;
+    const QString text = value.toString();
+    return parseCents(QStringView(text), cents);
+}
+
+bool ReplyDecoder::parseTimestamp(QByteArrayView text, qint64 *epochMs)
+{
+    return parseTimestampT(text.data(), text.size(), epochMs);
+}
+
+bool ReplyDecoder::parseTimestamp(QStringView text, qint64 *epochMs)
+{
+    return parseTimestampT(text.utf16(), text.size(), epochMs);
+}
+
+bool ReplyDecoder::parseTimestamp(const QJsonValue &value, qint64 *epochMs)
+{
+    if (value.isDouble()) {
+        *epochMs = qint64(value.toDouble());
+        return true;
+    }
+    if (!value.isString()) return false;
+    const QString text = value.toString();
+    return parseTimestamp(QStringView(text), epochMs);
+}
+
+QString ReplyDecoder::decimalText(qint64 cents)
+{
+    // Right to left into a stack buffer: the QString is the only allocation
+    char buf[24];
+    char *const end = buf + sizeof(buf);
+    char *p = end;
+    quint64 abs = cents < 0 ? quint64(0) - quint64(cents) : quint64(cents);
+
+    *--p = char('0' + abs % 10);
+    abs /= 10;
+    *--p = char('0' + abs % 10);
+    abs /= 10;
+    *--p = '.';
+    do {
+        *--p = char('0' + abs % 10);
+        abs /= 10;
+    } while (abs);
+    if (cents < 0) *--p = '-';
+
+    return QString::fromLatin1(p, end - p);
+}
+
+Transaction::Type ReplyDecoder::parseType(QByteArrayView txType)
+{
+    if (is(txType, "withdrawal")) return Transaction::Type::Withdrawal;
+    if (is(txType, "deposit")) return Transaction::Type::Deposit;
+    if (is(txType, "balance")) return Transaction::Type::Balance;
+    return Transaction::Type::Other;
+}
+
+Transaction::Type ReplyDecoder::parseType(QStringView txType)
+{
+    if (txType.compare(QLatin1String("withdrawal")) == 0) return Transaction::Type::Withdrawal;
+    if (txType.compare(QLatin1String("deposit")) == 0) return Transaction::Type::Deposit;
+    if (txType.compare(QLatin1String("balance")) == 0) return Transaction::Type::Balance;
+    return Transaction::Type::Other;
+}
+
+const QString &ReplyDecoder::typeText(Transaction::Type type)
+{
+    static const QString withdrawal = QStringLiteral("withdrawal");
+    static const QString deposit = QStringLiteral("deposit");
+    static const QString balance = QStringLiteral("balance");
+    static const QString empty;
+
+    switch (type) {
+    case Transaction::Type::Withdrawal: return withdrawal;
+    case Transaction::Type::Deposit:    return deposit;
+    case Transaction::Type::Balance:    return balance;
+    default:                            return empty;
+    }
+}
+
+int LoginResult::preferredAccountId() const
+{
+    for (const Account &a : accounts) {
+        if (a.debit) return a.accountId;
+    }
+    return accounts.isEmpty() ? 0 : accounts.first().accountId;
+}
+
+// ---------------------------------------------------------------------------
+// JSON: scanned in place
+
+namespace {
+
+class JsonScanner
+{
+public:
+    explicit JsonScanner(const QByteArray &raw)
+        : m_begin(raw.constData()), m_p(m_begin), m_end(m_begin + raw.size())
+    {
+    }
+
+    qsizetype offset()
+    {
+        skipSpace();
+        return m_p - m_begin;
+    }
+
+    char peek()
+    {
+        skipSpace();
+        return m_p < m_end ? *m_p : '\0';
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (m_p == m_end || *m_p != c) return false;
+        ++m_p;
+        return true;
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return m_p == m_end;
+    }
+
+    // Bytes between the quotes; escape sequences are left as they are
+    bool string(QByteArrayView *out, bool *escaped)
+    {
+        if (!consume('"')) return false;
+        const char *start = m_p;
+        *escaped = false;
+        while (m_p < m_end) {
+            if (*m_p == '"') {
+                *out = QByteArrayView(start, m_p - start);
+                ++m_p;
+                return true;
+            }
+            if (*m_p == '\\') {
+                if (m_end - m_p < 2) return false;
+                *escaped = true;
+                ++m_p;
+            }
+            ++m_p;
+        }
+        return false;
+    }
+
+    // Number or literal (true / false / null)
+    bool token(QByteArrayView *out)
+    {
+        skipSpace();
+        const char *start = m_p;
+        while (m_p < m_end && isTokenChar(*m_p)) ++m_p;
+        *out = QByteArrayView(start, m_p - start);
+        return m_p > start;
+    }
+
+    bool skipValue(int depth = 0)
+    {
+        if (depth > MAX_DEPTH) return false;
+        switch (peek()) {
+        case '"': {
+            QByteArrayView s;
+            bool escaped = false;
+            return string(&s, &escaped);
+        }
+        case '{':
+            return object([this, depth](QByteArrayView) { return skipValue(depth + 1); });
+        case '[':
+            return array([this, depth] { return skipValue(depth + 1); });
+        default: {
+            QByteArrayView t;
+            return token(&t);
+        }
+        }
+    }
+
+    // onMember(key) must consume the member's value
+    template <typename OnMember>
+    bool object(OnMember onMember)
+    {
+        if (!consume('{')) return false;
+        if (consume('}')) return true;
+        do {
+            QByteArrayView key;
+            bool escaped = false;
+            if (!string(&key, &escaped) || !consume(':') || !onMember(key)) return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+    template <typename OnItem>
+    bool array(OnItem onItem)
+    {
+        if (!consume('[')) return false;
+        if (consume(']')) return true;
+        do {
+            if (!onItem()) return false;
+        } while (consume(','));
+        return consume(']');
+    }
+
+private:
+    const char *m_begin;
+    const char *m_p;
+    const char *m_end;
+
+    void skipSpace()
+    {
+        while (m_p < m_end && isSpace(*m_p)) ++m_p;
+    }
+
+    static bool isTokenChar(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+               || c == '-' || c == '+' || c == '.';
+    }
+};
+
+// Cursors and messages are plain ASCII; anything escaped goes through the real parser
+QString unescapeJson(QByteArrayView raw)
+{
+    QByteArray doc;
+    doc.reserve(raw.size() + 4);
+    doc.append("[\"");
+    doc.append(raw.data(), raw.size());
+    doc.append("\"]");
+    return QJsonDocument::fromJson(doc).array().at(0).toString();
+}
+
+bool jsonNumber(QByteArrayView token, double *out)
+{
+    bool ok = false;
+    *out = token.toByteArray().toDouble(&ok);
+    return ok;
+}
+
+bool jsonInteger(JsonScanner &s, qint64 *out)
+{
+    QByteArrayView t;
+    if (!s.token(&t)) return false;
+    if (is(t, "null")) {
+        *out = 0;
+        return true;
+    }
+    if (parseIntegerT(t.data(), t.size(), out)) return true;
+    double d = 0;
+    if (!jsonNumber(t, &d)) return false;
+    *out = qint64(d);
+    return true;
+}
+
+bool jsonBool(JsonScanner &s, bool *out)
+{
+    QByteArrayView t;
+    if (!s.token(&t)) return false;
+    *out = is(t, "true");
+    return true;
+}
+
+// Unescaped string as a view (null -> empty); escaped text is reported, not decoded
+bool jsonWord(JsonScanner &s, QByteArrayView *out, bool *escaped)
+{
+    *escaped = false;
+    if (s.peek() == '"') return s.string(out, escaped);
+    QByteArrayView t;
+    if (!s.token(&t) || !is(t, "null")) return false;
+    *out = QByteArrayView();
+    return true;
+}
+
+bool jsonText(JsonScanner &s, QString *out)
+{
+    QByteArrayView raw;
+    bool escaped = false;
+    if (!jsonWord(s, &raw, &escaped)) return false;
+    *out = escaped ? unescapeJson(raw) : QString::fromUtf8(raw.data(), raw.size());
+    return true;
+}
+
+// DECIMAL text or number -> cents; null -> 0
+bool jsonMoney(JsonScanner &s, qint64 *cents)
+{
+    if (s.peek() == '"') {
+        QByteArrayView raw;
+        bool escaped = false;
+        return s.string(&raw, &escaped) && !escaped && ReplyDecoder::parseCents(raw, cents);
+    }
+    QByteArrayView t;
+    if (!s.token(&t)) return false;
+    if (is(t, "null")) {
+        *cents = 0;
+        return true;
+    }
+    if (ReplyDecoder::parseCents(t, cents)) return true;
+    double d = 0;
+    if (!jsonNumber(t, &d)) return false;
+    *cents = qRound64(d * 100.0);
+    return true;
+}
+
+// ISO text or epoch ms -> epoch ms; null or unparsable text -> 0
+bool jsonTimestamp(JsonScanner &s, qint64 *epochMs)
+{
+    if (s.peek() == '"') {
+        QByteArrayView raw;
+        bool escaped = false;
+        if (!s.string(&raw, &escaped)) return false;
+        if (escaped || !ReplyDecoder::parseTimestamp(raw, epochMs)) *epochMs = 0;
+        return true;
+    }
+    return jsonInteger(s, epochMs);
+}
+
+bool jsonBalance(JsonScanner &s, Balance *out)
+{
+    return s.object([&](QByteArrayView key) {
+        if (is(key, "id")) return jsonInteger(s, &out->accountId);
+        if (is(key, "balance")) return jsonMoney(s, &out->balanceCents);
+        if (is(key, "credit_limit")) return jsonMoney(s, &out->creditLimitCents);
+        if (is(key, "account_type")) {
+            QByteArrayView type;
+            bool escaped = false;
+            if (!jsonWord(s, &type, &escaped)) return false;
+            out->credit = is(type, "credit");
+            return true;
+        }
+        return s.skipValue();
+    });
+}
+
+bool jsonTransactionMember(JsonScanner &s, QByteArrayView key, Transaction *out)
+{
+    if (is(key, "id")) return jsonInteger(s, &out->id);
+    if (is(key, "amount")) return jsonMoney(s, &out->amountCents);
+    if (is(key, "created_at")) return jsonTimestamp(s, &out->createdMs);
+    if (is(key, "tx_type")) {
+        QByteArrayView type;
+        bool escaped = false;
+        if (!jsonWord(s, &type, &escaped)) return false;
+        out->type = escaped ? Transaction::Type::Other : ReplyDecoder::parseType(type);
+        if (out->type == Transaction::Type::Other) {
+            out->otherType = escaped ? unescapeJson(type) : QString::fromUtf8(type.data(), type.size());
+        }
+        return true;
+    }
+    return s.skipValue();
+}
+
+bool jsonTransaction(JsonScanner &s, Transaction *out)
+{
+    return s.object([&](QByteArrayView key) { return jsonTransactionMember(s, key, out); });
+}
+
+// Row, or the trailer { end:true, count, nextCursor, prevCursor }
+bool jsonStatementRecord(JsonScanner &s, StatementRecord *out)
+{
+    return s.object([&](QByteArrayView key) {
+        if (is(key, "end")) return jsonBool(s, &out->end);
+        if (is(key, "nextCursor")) return jsonText(s, &out->nextCursor);
+        return jsonTransactionMember(s, key, &out->row);
+    });
+}
+
+bool jsonTransactions(JsonScanner &s, QVector<Transaction> *items)
+{
+    return s.array([&] {
+        items->append(Transaction());
+        return jsonTransaction(s, &items->last());
+    });
+}
+
+bool jsonPage(JsonScanner &s, TransactionsPage *out)
+{
+    if (s.peek() == '[') return jsonTransactions(s, &out->items);
+    return s.object([&](QByteArrayView key) {
+        if (is(key, "items")) return jsonTransactions(s, &out->items);
+        if (is(key, "nextCursor")) return jsonText(s, &out->nextCursor);
+        if (is(key, "prevCursor")) return jsonText(s, &out->prevCursor);
+        return s.skipValue();
+    });
+}
+
+bool jsonLogin(JsonScanner &s, LoginResult *out, qint64 *legacyAccountId)
+{
+    return s.object([&](QByteArrayView key) {
+        if (is(key, "ok")) return jsonBool(s, &out->ok);
+        if (is(key, "accountId")) return jsonInteger(s, legacyAccountId);
+        if (is(key, "error")) return jsonText(s, &out->error);
+        if (is(key, "attemptsLeft")) {
+            qint64 left = -1;
+            if (!jsonInteger(s, &left)) return false;
+            out->attemptsLeft = int(left);
+            return true;
+        }
+        if (is(key, "bootstrap")) {
+            out->bootstrapBegin = s.offset();
+            if (!s.skipValue()) return false;
+            out->bootstrapEnd = s.offset();
+            return true;
+        }
+        if (is(key, "accounts")) {
+            return s.array([&] {
+                LoginResult::Account account;
+                const bool ok = s.object([&](QByteArrayView field) {
+                    if (is(field, "accountId")) {
+                        qint64 id = 0;
+                        if (!jsonInteger(s, &id)) return false;
+                        account.accountId = int(id);
+                        return true;
+                    }
+                    if (is(field, "role")) {
+                        QByteArrayView role;
+                        bool escaped = false;
+                        if (!jsonWord(s, &role, &escaped)) return false;
+                        account.debit = is(role, "debit");
+                        return true;
+                    }
+                    return s.skipValue();
+                });
+                if (ok) out->accounts.append(account);
+                return ok;
+            });
+        }
+        return s.skipValue();
+    });
+}
+
+// ---------------------------------------------------------------------------
+// CBOR: QCborStreamReader, keys and enum-like texts into a stack buffer
+
+struct Word {
+    char data[WORD_CAPACITY];
+    qsizetype size = -1; // -1 = longer than WORD_CAPACITY (matches nothing)
+
+    QByteArrayView view() const { return size < 0 ? QByteArrayView() : QByteArrayView(data, size); }
+};
+
+bool cborWord(QCborStreamReader &r, Word *out)
+{
+    if (!r.isString()) return false;
+    qsizetype size = 0;
+    bool fits = true;
+    for (;;) {
+        const qsizetype chunk = r.currentStringChunkSize();
+        if (fits && size + qMax<qsizetype>(chunk, 0) <= WORD_CAPACITY) {
+            const auto part = r.readStringChunk(out->data + size, WORD_CAPACITY - size);
+            if (part.status == QCborStreamReader::EndOfString) break;
+            if (part.status != QCborStreamReader::Ok) return false;
+            size += part.data;
+        } else {
+            fits = false;
+            const auto part = r.readString();
+            if (part.status == QCborStreamReader::EndOfString) break;
+            if (part.status != QCborStreamReader::Ok) return false;
+        }
+    }
+    out->size = fits ? size : -1;
+    return true;
+}
+
+bool cborNull(QCborStreamReader &r)
+{
+    return (r.isNull() || r.isUndefined()) && r.next();
+}
+
+bool cborText(QCborStreamReader &r, QString *out)
+{
+    out->clear();
+    if (cborNull(r)) return true;
+    if (!r.isString()) return false;
+    auto chunk = r.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        out->append(chunk.data);
+        chunk = r.readString();
+    }
+    return chunk.status == QCborStreamReader::EndOfString;
+}
+
+bool cborDouble(QCborStreamReader &r, double *out)
+{
+    if (r.isDouble()) *out = r.toDouble();
+    else if (r.isFloat()) *out = double(r.toFloat());
+    else if (r.isFloat16()) *out = double(r.toFloat16());
+    else return false;
+    return r.next();
+}
+
+bool cborInteger(QCborStreamReader &r, qint64 *out)
+{
+    if (r.isInteger()) {
+        *out = r.toInteger();
+        return r.next();
+    }
+    if (cborNull(r)) {
+        *out = 0;
+        return true;
+    }
+    double d = 0;
+    if (!cborDouble(r, &d)) return false;
+    *out = qint64(d);
+    return true;
+}
+
+bool cborBool(QCborStreamReader &r, bool *out)
+{
+    if (!r.isBool()) return false;
+    *out = r.toBool();
+    return r.next();
+}
+
+// Tag 4 [exponent, mantissa], DECIMAL text or number -> cents; null -> 0
+bool cborMoney(QCborStreamReader &r, qint64 *cents)
+{
+    if (r.isTag()) {
+        const quint64 tag = quint64(r.toTag());
+        if (!r.next()) return false;
+        if (tag != TAG_DECIMAL_FRACTION) return cborMoney(r, cents);
+        if (!r.isArray() || !r.isLengthKnown() || r.length() != 2) return false;
+
+        qint64 exponent = 0;
+        qint64 mantissa = 0;
+        if (!r.enterContainer() || !r.isInteger()) return false;
+        exponent = r.toInteger();
+        if (!r.next() || !r.isInteger()) return false;
+        mantissa = r.toInteger();
+        if (!r.next() || !r.leaveContainer()) return false;
+
+        if (qAbs(exponent) > MAX_DECIMAL_EXPONENT) return false;
+
+        // Rescale to exponent -2: cents
+        qint64 scale = exponent + 2;
+        for (; scale > 0; --scale) {
+            if (qAbs(mantissa) > std::numeric_limits<qint64>::max() / 10) return false;
+            mantissa *= 10;
+        }
+        for (; scale < 0; ++scale) mantissa /= 10;
+        *cents = mantissa;
+        return true;
+    }
+    if (r.isString()) {
+        Word text;
+        return cborWord(r, &text) && ReplyDecoder::parseCents(text.view(), cents);
+    }
+    if (r.isInteger()) {
+        *cents = r.toInteger() * 100;
+        return r.next();
+    }
+    if (cborNull(r)) {
+        *cents = 0;
+        return true;
+    }
+    double d = 0;
+    if (!cborDouble(r, &d)) return false;
+    *cents = qRound64(d * 100.0);
+    return true;
+}
+
+// Tag 1 epoch seconds, ISO text or epoch ms -> epoch ms; null or unparsable text -> 0
+bool cborTimestamp(QCborStreamReader &r, qint64 *epochMs)
+{
+    if (r.isTag()) {
+        const quint64 tag = quint64(r.toTag());
+        if (!r.next()) return false;
+        if (tag != TAG_EPOCH_DATETIME) return cborTimestamp(r, epochMs);
+        if (r.isInteger()) {
+            *epochMs = r.toInteger() * 1000;
+            return r.next();
+        }
+        double secs = 0;
+        if (!cborDouble(r, &secs)) return false;
+        *epochMs = qRound64(secs * 1000.0);
+        return true;
+    }
+    if (r.isString()) {
+        Word text;
+        if (!cborWord(r, &text)) return false;
+        if (!ReplyDecoder::parseTimestamp(text.view(), epochMs)) *epochMs = 0;
+        return true;
+    }
+    return cborInteger(r, epochMs);
+}
+
+template <typename OnMember>
+bool cborMap(QCborStreamReader &r, OnMember onMember)
+{
+    if (!r.isMap() || !r.enterContainer()) return false;
+    while (r.hasNext()) {
+        // Keys are always text in our API; anything else is treated as corrupt
+        Word key;
+        if (!cborWord(r, &key) || !onMember(key.view())) return false;
+    }
+    return r.leaveContainer();
+}
+
+template <typename OnItem>
+bool cborArray(QCborStreamReader &r, OnItem onItem)
+{
+    if (!r.isArray() || !r.enterContainer()) return false;
+    while (r.hasNext()) {
+        if (!onItem()) return false;
+    }
+    return r.leaveContainer();
+}
+
+bool cborBalance(QCborStreamReader &r, Balance *out)
+{
+    return cborMap(r, [&](QByteArrayView key) {
+        if (is(key, "id")) return cborInteger(r, &out->accountId);
+        if (is(key, "balance")) return cborMoney(r, &out->balanceCents);
+        if (is(key, "credit_limit")) return cborMoney(r, &out->creditLimitCents);
+        if (is(key, "account_type")) {
+            if (cborNull(r)) return true;
+            Word type;
+            if (!cborWord(r, &type)) return false;
+            out->credit = is(type.view(), "credit");
+            return true;
+        }
+        return r.next();
+    });
+}
+
+bool cborTransactionMember(QCborStreamReader &r, QByteArrayView key, Transaction *out)
+{
+    if (is(key, "id")) return cborInteger(r, &out->id);
+    if (is(key, "amount")) return cborMoney(r, &out->amountCents);
+    if (is(key, "created_at")) return cborTimestamp(r, &out->createdMs);
+    if (is(key, "tx_type")) {
+        if (cborNull(r)) return true;
+        if (r.isString() && r.isLengthKnown() && r.length() > WORD_CAPACITY) {
+            out->type = Transaction::Type::Other;
+            return cborText(r, &out->otherType);
+        }
+        Word type;
+        if (!cborWord(r, &type)) return false;
+        out->type = ReplyDecoder::parseType(type.view());
+        if (out->type == Transaction::Type::Other && type.size >= 0) {
+            out->otherType = QString::fromUtf8(type.data, type.size);
+        }
+        return true;
+    }
+    return r.next();
+}
+
+bool cborTransaction(QCborStreamReader &r, Transaction *out)
+{
+    return cborMap(r, [&](QByteArrayView key) { return cborTransactionMember(r, key, out); });
+}
+
+bool cborStatementRecord(QCborStreamReader &r, StatementRecord *out)
+{
+    return cborMap(r, [&](QByteArrayView key) {
+        if (is(key, "end")) return cborBool(r, &out->end);
+        if (is(key, "nextCursor")) return cborText(r, &out->nextCursor);
+        return cborTransactionMember(r, key, &out->row);
+    });
+}
+
+bool cborTransactions(QCborStreamReader &r, QVector<Transaction> *items)
+{
+    if (r.isLengthKnown()) items->reserve(items->size() + qsizetype(r.length()));
+    return cborArray(r, [&] {
+        items->append(Transaction());
+        return cborTransaction(r, &items->last());
+    });
+}
+
+bool cborPage(QCborStreamReader &r, TransactionsPage *out)
+{
+    if (r.isArray()) return cborTransactions(r, &out->items);
+    return cborMap(r, [&](QByteArrayView key) {
+        if (is(key, "items")) return cborTransactions(r, &out->items);
+        if (is(key, "nextCursor")) return cborText(r, &out->nextCursor);
+        if (is(key, "prevCursor")) return cborText(r, &out->prevCursor);
+        return r.next();
+    });
+}
+
+bool cborLogin(QCborStreamReader &r, LoginResult *out, qint64 *legacyAccountId)
+{
+    return cborMap(r, [&](QByteArrayView key) {
+        if (is(key, "ok")) return cborBool(r, &out->ok);
+        if (is(key, "accountId")) return cborInteger(r, legacyAccountId);
+        if (is(key, "error")) return cborText(r, &out->error);
+        if (is(key, "attemptsLeft")) {
+            qint64 left = -1;
+            if (!cborInteger(r, &left)) return false;
+            out->attemptsLeft = int(left);
+            return true;
+        }
+        if (is(key, "bootstrap")) {
+            out->bootstrapBegin = qsizetype(r.currentOffset());
+            if (!r.next()) return false;
+            out->bootstrapEnd = qsizetype(r.currentOffset());
+            return true;
+        }
+        if (is(key, "accounts")) {
+            return cborArray(r, [&] {
+                LoginResult::Account account;
+                const bool ok = cborMap(r, [&](QByteArrayView field) {
+                    if (is(field, "accountId")) {
+                        qint64 id = 0;
+                        if (!cborInteger(r, &id)) return false;
+                        account.accountId = int(id);
+                        return true;
+                    }
+                    if (is(field, "role")) {
+                        Word role;
+                        if (!cborWord(r, &role)) return false;
+                        account.debit = is(role.view(), "debit");
+                        return true;
+                    }
+                    return r.next();
+                });
+                if (ok) out->accounts.append(account);
+                return ok;
+            });
+        }
+        return r.next();
+    });
+}
+
+} // namespace
+
+bool ReplyDecoder::decodeBalance(const QByteArray &raw, Format format, Balance *out)
+{
+    *out = Balance();
+    if (format == Format::Cbor) {
+        QCborStreamReader reader(raw);
+        return cborBalance(reader, out) && reader.lastError() == QCborError::NoError;
+    }
+    JsonScanner scanner(raw);
+    return jsonBalance(scanner, out) && scanner.atEnd();
+}
+
+bool ReplyDecoder::decodeTransactionsPage(const QByteArray &raw, Format format, TransactionsPage *out)
+{
+    *out = TransactionsPage();
+    if (format == Format::Cbor) {
+        QCborStreamReader reader(raw);
+        return cborPage(reader, out) && reader.lastError() == QCborError::NoError;
+    }
+    JsonScanner scanner(raw);
+    return jsonPage(scanner, out) && scanner.atEnd();
+}
+
+bool ReplyDecoder::decodeLogin(const QByteArray &raw, Format format, LoginResult *out)
+{
+    *out = LoginResult();
+    qint64 legacyAccountId = 0;
+    bool ok = false;
+    if (format == Format::Cbor) {
+        QCborStreamReader reader(raw);
+        ok = cborLogin(reader, out, &legacyAccountId) && reader.lastError() == QCborError::NoError;
+    } else {
+        JsonScanner scanner(raw);
+        ok = jsonLogin(scanner, out, &legacyAccountId) && scanner.atEnd();
+    }
+
+    // Old shape { ok:true, accountId:<int> }: one debit account
+    if (ok && out->accounts.isEmpty() && legacyAccountId > 0) {
+        out->accounts.append({ int(legacyAccountId), true });
+    }
+    return ok;
+}
+
+bool ReplyDecoder::readStatementRecord(QCborStreamReader &reader, StatementRecord *out)
+{
+    *out = StatementRecord();
+    return cborStatementRecord(reader, out) && reader.lastError() == QCborError::NoError;
+}
+
+bool ReplyDecoder::decodeStatementRecord(const QByteArray &line, StatementRecord *out)
+{
+    *out = StatementRecord();
+    JsonScanner scanner(line);
+    return jsonStatementRecord(scanner, out) && scanner.atEnd();
+}
+
+Balance ReplyDecoder::balance(const QJsonObject &obj)
+{
+    Balance b;
+    b.accountId = obj.value(QLatin1String("id")).toInteger();
+    b.credit = obj.value(QLatin1String("account_type")).toString() == QLatin1String("credit");
+    parseCents(obj.value(QLatin1String("balance")), &b.balanceCents);
+    parseCents(obj.value(QLatin1String("credit_limit")), &b.creditLimitCents);
+    return b;
+}
+
+Transaction ReplyDecoder::transaction(const QJsonObject &row)
+{
+    Transaction t;
+    t.id = row.value(QLatin1String("id")).toInteger();
+
+    const QString type = row.value(QLatin1String("tx_type")).toString();
+    t.type = parseType(QStringView(type));
+    if (t.type == Transaction::Type::Other) t.otherType = type;
+
+    parseCents(row.value(QLatin1String("amount")), &t.amountCents);
+    if (!parseTimestamp(row.value(QLatin1String("created_at")), &t.createdMs)) t.createdMs = 0;
+    return t;
+}
+
+QVector<Transaction> ReplyDecoder::transactions(const QJsonArray &rows)
+{
+    QVector<Transaction> items;
+    items.reserve(rows.size());
+    for (const auto &v : rows) items.append(transaction(v.toObject()));
+    return items;
+}
+
+LoginResult ReplyDecoder::login(const QJsonObject &obj)
+{
+    LoginResult result;
+    result.ok = obj.value(QLatin1String("ok")).toBool(false);
+    result.attemptsLeft = obj.value(QLatin1String("attemptsLeft")).toInt(-1);
+    result.error = obj.value(QLatin1String("error")).toString();
+
+    const QJsonArray accounts = obj.value(QLatin1String("accounts")).toArray();
+    for (const auto &v : accounts) {
+        const QJsonObject o = v.toObject();
+        result.accounts.append({ o.value(QLatin1String("accountId")).toInt(-1),
+                                 o.value(QLatin1String("role")).toString() == QLatin1String("debit") });
+    }
+    const int legacyAccountId = obj.value(QLatin1String("accountId")).toInt(-1);
+    if (result.accounts.isEmpty() && legacyAccountId > 0) result.accounts.append({ legacyAccountId, true });
+    return result;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+#include <QStringView>
+#include <QVarLengthArray>
+#include <QVector>
+
+class QCborStreamReader;
+
+// Typed API replies. Money is fixed-point cents, timestamps are epoch milliseconds.
+
+struct Balance {
+    qint64 accountId = 0;
+    bool credit = false;           // account_type
+    qint64 balanceCents = 0;
+    qint64 creditLimitCents = 0;   // 0 for debit accounts
+};
+
+struct Transaction {
+    enum class Type : quint8 { Withdrawal, Deposit, Balance, Other };
+
+    qint64 id = 0;
+    Type type = Type::Other;
+    qint64 amountCents = 0;
+    qint64 createdMs = 0;          // 0 = missing or unparsable
+    QString otherType;             // raw tx_type for Type::Other only, else empty
+};
+
+struct TransactionsPage {
+    QVector<Transaction> items;    // newest first
+    QString nextCursor;
+    QString prevCursor;
+};
+
+// One record of the streamed statement (?stream=1): a row, or the trailer after the last one
+struct StatementRecord {
+    bool end = false;
+    Transaction row;               // end == false
+    QString nextCursor;            // end == true; empty = no more rows
+};
+
+struct LoginResult {
+    struct Account {
+        int accountId = 0;
+        bool debit = false;        // role
+    };
+
+    bool ok = false;
+    QVarLengthArray<Account, 2> accounts;
+    int attemptsLeft = -1;         // 401 replies only
+    QString error;
+    // Byte range of the "bootstrap" member in the reply (empty if none). Left undecoded:
+    // the caller decodes just that slice when the session needs it.
+    qsizetype bootstrapBegin = 0;
+    qsizetype bootstrapEnd = 0;
+
+    // Debit if the card has one, else the first account; 0 without accounts
+    int preferredAccountId() const;
+};
+
+// Reply bytes -> typed structs in one pass, without building a QJsonDocument/QJsonValue
+// tree. JSON is scanned in place (keys and enum-like strings are compared as bytes, only
+// cursors/error texts become QStrings); CBOR goes through QCborStreamReader with the
+// typed tags of backend/cbor.js (tag 4 decimal fraction -> cents, tag 1 -> epoch ms).
+// Unknown members are skipped, so the server can add fields freely. ApiClient reads
+// balances, transaction pages and login replies with these.
+//
+// The QJsonObject overloads give the same structs for rows that are already documents
+// (session bootstrap, TransactionStore::recent).
+class ReplyDecoder
+{
+public:
+    enum class Format { Json, Cbor };
+
+    static bool decodeBalance(const QByteArray& raw, Format format, Balance* out);
+    // Accepts the object shape {items,nextCursor,prevCursor} and the old bare array
+    static bool decodeTransactionsPage(const QByteArray& raw, Format format, TransactionsPage* out);
+    static bool decodeLogin(const QByteArray& raw, Format format, LoginResult* out);
+    // Streamed statement, one record at a time: the next item of a CBOR sequence (false
+    // with reader.lastError() == EndOfFile while it has not fully arrived), or one NDJSON line
+    static bool readStatementRecord(QCborStreamReader& reader, StatementRecord* out);
+    static bool decodeStatementRecord(const QByteArray& line, StatementRecord* out);
+
+    static Balance balance(const QJsonObject& obj);
+    static Transaction transaction(const QJsonObject& row);
+    static QVector<Transaction> transactions(const QJsonArray& rows);
+    static LoginResult login(const QJsonObject& obj);
+
+    // DECIMAL text ("-1234.5", "12.50", "7") or JSON number -> cents; digits past the
+    // second decimal are dropped. false on anything else.
+    static bool parseCents(QByteArrayView text, qint64* cents);
+    static bool parseCents(QStringView text, qint64* cents);
+    static bool parseCents(const QJsonValue& value, qint64* cents);
+
+    // "YYYY-MM-DD[T ]HH:MM:SS[.fff][Z|+HH:MM|-HH:MM]"; without a zone it is kiosk local
+    // time (what the SQL DATETIME text means). Epoch ms numbers pass through the
+    // QJsonValue overload. false on anything else.
+    static bool parseTimestamp(QByteArrayView text, qint64* epochMs);
+    static bool parseTimestamp(QStringView text, qint64* epochMs);
+    static bool parseTimestamp(const QJsonValue& value, qint64* epochMs);
+
+    // Cents -> the DECIMAL text the backend sends ("-1234.50")
+    static QString decimalText(qint64 cents);
+
+    static Transaction::Type parseType(QByteArrayView txType);
+    static Transaction::Type parseType(QStringView txType);
+    static const QString& typeText(Transaction::Type type);
+};
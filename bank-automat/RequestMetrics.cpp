@@ -0,0 +1,291 @@
+#include "RequestMetrics.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QUrl>
+#include <QUrlQuery>
+#include <algorithm>
+#include <cmath>
+
+static const double EXPORTED_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+// -------- LatencyHistogram --------
+
+int LatencyHistogram::bucketIndex(quint64 micros)
+{
+    if (micros < quint64(SUB_BUCKETS)) return int(micros);
+
+    // Top SUB_BUCKET_BITS+1 bits select the bucket: exact below 64 µs, ~3% above
+    const int msb = 63 - qCountLeadingZeroBits(micros);
+    const int shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + int(micros >> shift) - SUB_BUCKETS;
+}
+
+qint64 LatencyHistogram::bucketUpper(int index)
+{
+    if (index < SUB_BUCKETS) return index;
+
+    const int shift = index / SUB_BUCKETS - 1;
+    const qint64 lower = qint64(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + (qint64(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros)
+{
+    if (micros < 0) micros = 0;
+    const quint64 clamped = qMin<quint64>(quint64(micros), (quint64(1) << MAX_VALUE_BITS) - 1);
+
+    ++m_buckets[bucketIndex(clamped)];
+    ++m_count;
+    m_sum += micros;
+    m_max = qMax(m_max, micros);
+}
+
+void LatencyHistogram::reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+qint64 LatencyHistogram::quantileMicros(double q) const
+{
+    if (m_count == 0) return 0;
+
+    const quint64 target = qMax<quint64>(1, quint64(std::ceil(qBound(0.0, q, 1.0) * double(m_count))));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_buckets[i];
+        if (seen >= target) return qMin(bucketUpper(i), m_max);
+    }
+    return m_max;
+}
+
+// -------- RequestMetrics --------
+
+RequestMetrics::RequestMetrics(QObject *parent)
+    : QObject(parent)
+{
+    m_dumpTimer.setTimerType(Qt::VeryCoarseTimer); // whole seconds: lets idle wakeups coalesce
+    connect(&m_dumpTimer, &QTimer::timeout, this, [this]() { dumpNow(); });
+}
+
+RequestMetrics::~RequestMetrics()
+{
+    qDeleteAll(m_endpoints);
+}
+
+RequestMetrics::Endpoint *RequestMetrics::endpoint(const QString &endpoint)
+{
+    Endpoint *&e = m_endpoints[endpoint];
+    if (!e) e = new Endpoint;
+    return e;
+}
+
+void RequestMetrics::record(const QString &endpoint, Phase phase, qint64 nanos)
+{
+    if (phase < 0 || phase >= PhaseCount) return;
+    this->endpoint(endpoint)->phases[phase].record(nanos / 1000);
+}
+
+void RequestMetrics::count(const QString &endpoint, Counter counter)
+{
+    if (counter < 0 || counter >= CounterCount) return;
+    ++this->endpoint(endpoint)->counters[counter];
+}
+
+quint64 RequestMetrics::counter(const QString &endpoint, Counter counter) const
+{
+    if (counter < 0 || counter >= CounterCount) return 0;
+    const Endpoint *e = m_endpoints.value(endpoint, nullptr);
+    return e ? e->counters[counter] : 0;
+}
+
+quint64 RequestMetrics::counterTotal(Counter counter) const
+{
+    if (counter < 0 || counter >= CounterCount) return 0;
+    quint64 total = 0;
+    for (const Endpoint *e : m_endpoints) total += e->counters[counter];
+    return total;
+}
+
+const LatencyHistogram *RequestMetrics::histogram(const QString &endpoint, Phase phase) const
+{
+    if (phase < 0 || phase >= PhaseCount) return nullptr;
+    const Endpoint *e = m_endpoints.value(endpoint, nullptr);
+    return e ? &e->phases[phase] : nullptr;
+}
+
+const char *RequestMetrics::phaseName(Phase phase)
+{
+    switch (phase) {
+    case Queue:    return "queue";
+    case Connect:  return "connect";
+    case Ttfb:     return "ttfb";
+    case Download: return "download";
+    case Decode:   return "decode";
+    case Total:    return "total";
+    default:       return "unknown";
+    }
+}
+
+const char *RequestMetrics::counterName(Counter counter)
+{
+    switch (counter) {
+    case Retries:      return "retry";
+    case Hedges:       return "hedge";
+    case HedgeWins:    return "hedge_win";
+    case BudgetDenied: return "budget_denied";
+    default:           return "unknown";
+    }
+}
+
+static QByteArray labelValue(const QString &value)
+{
+    QByteArray out = value.toUtf8();
+    out.replace('\\', "\\\\");
+    out.replace('"', "\\\"");
+    out.replace('\n', "\\n");
+    return out;
+}
+
+static QByteArray seconds(qint64 micros)
+{
+    return QByteArray::number(double(micros) / 1e6, 'g', 9);
+}
+
+void RequestMetrics::recordTransition(const QString &name, qint64 nanos)
+{
+    m_transitions[name].record(nanos / 1000);
+}
+
+const LatencyHistogram *RequestMetrics::transitionHistogram(const QString &name) const
+{
+    const auto it = m_transitions.constFind(name);
+    return it != m_transitions.constEnd() ? &*it : nullptr;
+}
+
+void RequestMetrics::setGauge(const QByteArray &name, const QByteArray &help, double value)
+{
+    Gauge &g = m_gauges[name];
+    g.help = help;
+    g.value = value;
+}
+
+QByteArray RequestMetrics::toPrometheus() const
+{
+    static const QByteArray name = "bank_automat_request_phase_seconds";
+
+    QByteArray out;
+    out += "# HELP " + name + " Kiosk-side request latency by endpoint and phase.\n";
+    out += "# TYPE " + name + " summary\n";
+
+    QByteArray maxOut;
+    maxOut += "# HELP " + name + "_max Slowest observation by endpoint and phase.\n";
+    maxOut += "# TYPE " + name + "_max gauge\n";
+
+    static const QByteArray attemptsName = "bank_automat_request_extra_attempts_total";
+    QByteArray attemptsOut;
+    attemptsOut += "# HELP " + attemptsName + " Retries and hedges sent, hedges that answered first, "
+                   "and retries or hedges refused by the retry budget.\n";
+    attemptsOut += "# TYPE " + attemptsName + " counter\n";
+
+    // Stable output order for diffing successive dumps
+    QStringList endpoints = m_endpoints.keys();
+    std::sort(endpoints.begin(), endpoints.end());
+
+    for (const QString &endpoint : endpoints) {
+        const Endpoint *e = m_endpoints.value(endpoint);
+        for (int p = 0; p < PhaseCount; ++p) {
+            const LatencyHistogram &h = e->phases[p];
+            if (h.count() == 0) continue;
+
+            const QByteArray labels = "endpoint=\"" + labelValue(endpoint) + "\",phase=\""
+                                      + phaseName(Phase(p)) + "\"";
+            for (double q : EXPORTED_QUANTILES) {
+                out += name + "{" + labels + ",quantile=\"" + QByteArray::number(q) + "\"} "
+                       + seconds(h.quantileMicros(q)) + "\n";
+            }
+            out += name + "_sum{" + labels + "} " + seconds(h.sumMicros()) + "\n";
+            out += name + "_count{" + labels + "} " + QByteArray::number(h.count()) + "\n";
+            maxOut += name + "_max{" + labels + "} " + seconds(h.maxMicros()) + "\n";
+        }
+        for (int c = 0; c < CounterCount; ++c) {
+            if (e->counters[c] == 0) continue;
+            attemptsOut += attemptsName + "{endpoint=\"" + labelValue(endpoint) + "\",kind=\""
+                           + counterName(Counter(c)) + "\"} " + QByteArray::number(e->counters[c]) + "\n";
+        }
+    }
+
+    static const QByteArray transitionName = "bank_automat_ui_transition_seconds";
+    QByteArray transitionsOut;
+    if (!m_transitions.isEmpty()) {
+        transitionsOut += "# HELP " + transitionName + " Time from a tap or login to the next screen being on display.\n";
+        transitionsOut += "# TYPE " + transitionName + " summary\n";
+    }
+    for (auto it = m_transitions.constBegin(); it != m_transitions.constEnd(); ++it) {
+        const QByteArray labels = "transition=\"" + labelValue(it.key()) + "\"";
+        for (double q : EXPORTED_QUANTILES) {
+            transitionsOut += transitionName + "{" + labels + ",quantile=\"" + QByteArray::number(q) + "\"} "
+                              + seconds(it->quantileMicros(q)) + "\n";
+        }
+        transitionsOut += transitionName + "_sum{" + labels + "} " + seconds(it->sumMicros()) + "\n";
+        transitionsOut += transitionName + "_count{" + labels + "} " + QByteArray::number(it->count()) + "\n";
+    }
+
+    QByteArray gaugesOut;
+    for (auto it = m_gauges.constBegin(); it != m_gauges.constEnd(); ++it) {
+        const QByteArray gaugeName = "bank_automat_" + it.key();
+        gaugesOut += "# HELP " + gaugeName + " " + it->help + "\n";
+        gaugesOut += "# TYPE " + gaugeName + " gauge\n";
+        gaugesOut += gaugeName + " " + QByteArray::number(it->value, 'g', 15) + "\n";
+    }
+    return out + maxOut + attemptsOut + transitionsOut + gaugesOut;
+}
+
+void RequestMetrics::setDumpFile(const QString &path, int intervalMs)
+{
+    m_dumpPath = path;
+    if (m_dumpPath.isEmpty() || intervalMs <= 0) {
+        m_dumpTimer.stop();
+        return;
+    }
+    QDir().mkpath(QFileInfo(m_dumpPath).absolutePath());
+    m_dumpTimer.start(intervalMs);
+}
+
+bool RequestMetrics::dumpNow()
+{
+    if (m_dumpPath.isEmpty()) return false;
+
+    QSaveFile f(m_dumpPath);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(toPrometheus());
+    return f.commit();
+}
+
+QString RequestMetrics::endpointFor(const QUrl &url)
+{
+    QStringList segments = url.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+
+    for (int i = 0; i < segments.size(); ++i) {
+        bool numeric = false;
+        segments[i].toLongLong(&numeric);
+        if (numeric) {
+            segments[i] = QStringLiteral(":id");
+        } else if (i == 2 && segments.at(0) == QLatin1String("images")) {
+            segments[i] = QStringLiteral(":file"); // /images/uploads/<filename>
+        } else if (i == 3 && segments.at(2) == QLatin1String("withdrawals")) {
+            segments[i] = QStringLiteral(":key"); // /accounts/:id/withdrawals/<idempotency key>/cancel
+        }
+    }
+
+    QString endpoint = QLatin1Char('/') + segments.join(QLatin1Char('/'));
+    if (QUrlQuery(url).queryItemValue(QStringLiteral("stream")) == QLatin1String("1")) {
+        endpoint += QStringLiteral("?stream=1");
+    }
+    return endpoint;
+}
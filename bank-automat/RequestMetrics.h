@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QTimer>
+#include <array>
+
+class QUrl;
+
+// HDR-style latency histogram: log-linear buckets, 32 per power of two (~3% relative
+// error) from 1 µs up to ~71 min. Fixed memory, O(1) record, no allocation.
+class LatencyHistogram
+{
+public:
+    void record(qint64 micros);
+    void reset();
+
+    quint64 count() const { return m_count; }
+    qint64 sumMicros() const { return m_sum; }
+    qint64 maxMicros() const { return m_max; }
+
+    // Upper bound of the bucket holding the q-quantile (q in 0..1), 0 if empty
+    qint64 quantileMicros(double q) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 32; // larger values are clamped
+    static constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketIndex(quint64 micros);
+    static qint64 bucketUpper(int index);
+
+    std::array<quint32, BUCKET_COUNT> m_buckets{};
+    quint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_max = 0;
+};
+
+// Kiosk-side request timing per endpoint and phase, exported as Prometheus text.
+// Phases of one reply (QNetworkReply signals, QElapsedTimer):
+//   queue    handed to QNAM -> socket starts connecting (new connection) or request sent (reused)
+//   connect  socket starts connecting -> request sent (TCP + TLS; new connections only)
+//   ttfb     request sent -> response headers
+//   download response headers -> finished
+//   decode   JSON/CBOR body -> document
+//   total    handed to QNAM -> finished
+class RequestMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    enum Phase { Queue = 0, Connect, Ttfb, Download, Decode, Total, PhaseCount };
+    // Extra attempts per endpoint (ApiClient retry policy)
+    enum Counter { Retries = 0, Hedges, HedgeWins, BudgetDenied, CounterCount };
+
+    explicit RequestMetrics(QObject *parent = nullptr);
+    ~RequestMetrics();
+
+    void record(const QString& endpoint, Phase phase, qint64 nanos);
+
+    // nullptr if nothing was recorded for this endpoint yet
+    const LatencyHistogram* histogram(const QString& endpoint, Phase phase) const;
+
+    void count(const QString& endpoint, Counter counter);
+    quint64 counter(const QString& endpoint, Counter counter) const;
+    quint64 counterTotal(Counter counter) const; // all endpoints
+
+    // Screen transitions timed by the UI (e.g. "tap_to_login_dialog"), same histogram;
+    // nullptr if never recorded
+    void recordTransition(const QString& name, qint64 nanos);
+    const LatencyHistogram* transitionHistogram(const QString& name) const;
+
+    // Process-level value exported as-is (e.g. session RSS); name without prefix
+    void setGauge(const QByteArray& name, const QByteArray& help, double value);
+
+    // Prometheus text exposition format (summary with quantile labels)
+    QByteArray toPrometheus() const;
+
+    // Rewrite `path` with toPrometheus() every intervalMs (atomic replace, so a
+    // node_exporter textfile collector never reads half a file). Empty path stops.
+    void setDumpFile(const QString& path, int intervalMs);
+    bool dumpNow();
+
+    // Route template used as the endpoint label: numeric segments -> ":id",
+    // upload filenames -> ":file", withdrawal keys -> ":key", query dropped (except stream=1)
+    static QString endpointFor(const QUrl& url);
+
+private:
+    struct Endpoint {
+        LatencyHistogram phases[PhaseCount];
+        quint64 counters[CounterCount] = {};
+    };
+    Endpoint* endpoint(const QString& endpoint);
+    QHash<QString, Endpoint*> m_endpoints; // owned
+
+    QMap<QString, LatencyHistogram> m_transitions; // sorted: stable dump order
+
+    struct Gauge {
+        QByteArray help;
+        double value = 0;
+    };
+    QMap<QByteArray, Gauge> m_gauges; // sorted: stable dump order
+
+    QString m_dumpPath;
+    QTimer m_dumpTimer;
+
+    static const char* phaseName(Phase phase);
+    static const char* counterName(Counter counter);
+};
@@ -0,0 +1,162 @@
+#include "Session.h"
+
+#include "ApiClient.h"
+#include "ReplyDecoder.h"
+
+#include <QFile>
+#include <QtGlobal>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+static constexpr int MEMORY_SAMPLE_MS = 5000;
+// Aborted replies are deleted on the next event loop turns; whatever is still
+// around after this is counted as leaked
+static constexpr int END_GRACE_MS = 1000;
+
+static quint64 s_sessionsStarted = 0;
+static quint64 s_sessionsFinished = 0;
+
+Session::Session(ApiClient *api, const QJsonArray &linkedAccounts, QObject *parent)
+    : QObject(parent)
+    , m_api(api)
+    , m_linkedAccounts(linkedAccounts)
+    , m_scope(new QObject(this))
+{
+    // Debit if the card has one, else the first linked account
+    for (const auto &v : linkedAccounts) {
+        const QJsonObject o = v.toObject();
+        const bool debit = o.value("role").toString() == QLatin1String("debit");
+        if (m_accountId > 0 && !debit) continue;
+        m_accountId = o.value("accountId").toInt(-1);
+        m_role = o.value("role").toString();
+        if (debit) break;
+    }
+
+    m_clock.start();
+    m_stats.id = ++s_sessionsStarted;
+    m_stats.accountId = m_accountId;
+    m_stats.rssStartBytes = residentBytes();
+    m_stats.rssPeakBytes = m_stats.rssStartBytes;
+
+    QTimer *sampler = createTimer(MEMORY_SAMPLE_MS, false);
+    connect(sampler, &QTimer::timeout, this, &Session::sampleMemory);
+    sampler->start();
+}
+
+bool Session::selectAccount(int accountId)
+{
+    for (const auto &v : std::as_const(m_linkedAccounts)) {
+        const QJsonObject o = v.toObject();
+        if (o.value("accountId").toInt(-1) != accountId) continue;
+        if (accountId == m_accountId) return true;
+
+        m_accountId = accountId;
+        m_role = o.value("role").toString();
+        m_stats.accountId = accountId;
+        emit accountChanged();
+        return true;
+    }
+    return false;
+}
+
+void Session::setBootstrap(const QJsonObject &bootstrap)
+{
+    const QJsonArray accounts = bootstrap.value("accounts").toArray();
+    for (const auto &v : accounts) {
+        const QJsonObject o = v.toObject();
+        const int id = o.value("accountId").toInt(-1);
+        if (id > 0) m_accountBootstraps.insert(id, o);
+    }
+    const QString image = bootstrap.value("customer").toObject().value("image_filename").toString().trimmed();
+    if (!image.isEmpty()) m_customerImage = image;
+}
+
+void Session::updateBalance(int accountId, const Balance &balance)
+{
+    const auto it = m_accountBootstraps.find(accountId);
+    if (it == m_accountBootstraps.end()) return;
+
+    // Kept in the reply's shape (DECIMAL text), like the rest of the bootstrap
+    QJsonObject obj = it->value(QStringLiteral("balance")).toObject();
+    obj.insert(QStringLiteral("id"), balance.accountId);
+    obj.insert(QStringLiteral("account_type"), balance.credit ? QStringLiteral("credit") : QStringLiteral("debit"));
+    obj.insert(QStringLiteral("balance"), ReplyDecoder::decimalText(balance.balanceCents));
+    obj.insert(QStringLiteral("credit_limit"), ReplyDecoder::decimalText(balance.creditLimitCents));
+    it->insert(QStringLiteral("balance"), obj);
+}
+
+QObject *Session::context() const
+{
+    return m_scope ? m_scope.data() : const_cast<Session*>(this);
+}
+
+QTimer *Session::createTimer(int intervalMs, bool singleShot)
+{
+    QTimer *t = new QTimer(context());
+    t->setInterval(intervalMs);
+    t->setSingleShot(singleShot);
+    return t;
+}
+
+void Session::end(const QString &reason)
+{
+    if (!isActive()) return;
+
+    sampleMemory();
+    m_stats.endReason = reason;
+    m_stats.durationMs = m_clock.elapsed();
+    if (m_api) m_stats.requestsCancelled = m_api->pendingRequests(m_scope.data());
+
+    // Cancels every request of the scope (ApiClient/ImageLoader watch it) and deletes the timers
+    delete m_scope.data();
+    m_accountBootstraps.clear();
+    m_customerImage.clear();
+    // Revalidatable replies (balances, transaction pages) belong to this customer too
+    if (m_api) m_api->clearResponseCache();
+
+    emit ended();
+    QTimer::singleShot(END_GRACE_MS, this, &Session::finish);
+}
+
+void Session::sampleMemory()
+{
+    m_stats.rssPeakBytes = std::max(m_stats.rssPeakBytes, residentBytes());
+}
+
+void Session::finish()
+{
+    ++s_sessionsFinished;
+    m_stats.rssAfterBytes = residentBytes();
+    if (m_api) {
+        m_stats.leakedReplies = m_api->orphanReplies();
+
+        RequestMetrics &metrics = m_api->metrics();
+        metrics.setGauge("sessions_total", "Customer sessions ended since start.", double(s_sessionsFinished));
+        metrics.setGauge("session_rss_peak_bytes", "Resident memory high-water of the last session.",
+                         double(m_stats.rssPeakBytes));
+        metrics.setGauge("session_rss_after_bytes", "Resident memory once the last session was released.",
+                         double(m_stats.rssAfterBytes));
+        metrics.setGauge("session_leaked_replies", "Network replies still alive after the last session.",
+                         double(m_stats.leakedReplies));
+    }
+
+    emit finished(m_stats);
+    deleteLater();
+}
+
+qint64 Session::residentBytes()
+{
+#ifdef Q_OS_LINUX
+    // statm: size resident shared ... (pages)
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) return 0;
+    return fields.at(1).toLongLong() * ::sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+
+class ApiClient;
+struct Balance;
+
+// One customer at the kiosk, from login to idle timeout / logout.
+// Everything issued for that customer hangs off context(): it is the ApiClient and
+// ImageLoader context of every request and the parent of session timers. end() destroys
+// it, which cancels the requests (replies aborted, callbacks dropped) and deletes the
+// timers there and then, and clears ApiClient's response cache; windows drop their
+// per-customer data (rows, photo) on ended().
+//
+// The session starts as soon as the card and PIN are accepted, before a card with a
+// debit and a credit account has had its role chosen: everything of the customer can
+// load meanwhile, and the session keeps it (bootstrap per linked account) so switching
+// accounts later needs no network.
+//
+// Instrumentation, so a kiosk running for weeks can be checked for growth: RSS at start,
+// sampled high-water while active, RSS and orphaned QNetworkReplys once the aborted
+// replies have had time to go away. Reported by finished() and as gauges in the
+// metrics file; the session deletes itself afterwards.
+class Session : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats {
+        quint64 id = 0;
+        int accountId = 0;
+        QString endReason;
+        qint64 durationMs = 0;
+        int requestsCancelled = 0;  // still in flight when the session ended
+        qint64 rssStartBytes = 0;   // 0 = not available on this platform
+        qint64 rssPeakBytes = 0;
+        qint64 rssAfterBytes = 0;   // after the grace period
+        int leakedReplies = 0;      // replies alive that no request owns any more
+    };
+
+    // linkedAccounts: [{role, accountId}] from the login reply; the debit account (else
+    // the first) is selected. Destroyed without end() (e.g. with its parent at shutdown),
+    // the scope still goes and cancels what is left; no stats then.
+    Session(ApiClient* api, const QJsonArray& linkedAccounts, QObject* parent = nullptr);
+
+    quint64 id() const { return m_stats.id; }
+    int accountId() const { return m_accountId; }
+    QString role() const { return m_role; }
+    QJsonArray linkedAccounts() const { return m_linkedAccounts; }
+    // false if the account is not linked to this card
+    bool selectAccount(int accountId);
+
+    // Latest known state per linked account, in the bootstrap shape
+    // ({role, accountId, balance:{...}, transactions:{items,nextCursor,prevCursor}})
+    void setBootstrap(const QJsonObject& bootstrap);
+    QJsonObject accountBootstrap(int accountId) const { return m_accountBootstraps.value(accountId); }
+    void updateBalance(int accountId, const Balance& balance);
+    QString customerImage() const { return m_customerImage; }
+    ApiClient* api() const { return m_api; }
+    bool isActive() const { return !m_scope.isNull(); }
+
+    // Context for requests of this customer. After end() the session itself, so a
+    // stray late call is still cancelled when the session goes away.
+    QObject* context() const;
+
+    // Timer stopped and deleted by end()
+    QTimer* createTimer(int intervalMs, bool singleShot);
+
+    // Idempotent; emits ended() synchronously, finished() after the grace period
+    void end(const QString& reason);
+
+    // Resident set size of this process, 0 if unknown
+    static qint64 residentBytes();
+
+signals:
+    void accountChanged();
+    void ended();
+    void finished(const Session::Stats& stats);
+
+private:
+    ApiClient* m_api = nullptr;
+    int m_accountId = 0;
+    QString m_role;
+    QJsonArray m_linkedAccounts;
+    QHash<int, QJsonObject> m_accountBootstraps;
+    QString m_customerImage;
+    QPointer<QObject> m_scope;
+    QElapsedTimer m_clock;
+    Stats m_stats;
+
+    void sampleMemory();
+    void finish();
+};
@@ -4,22 +4,50 @@
 #include "ApiClient.h"
 #include "LoginDialog.h"
 #include "MainWindow.h"
+#include "Session.h"
 #include <QShortcut>
 #include <QKeySequence>
 #include <QTimer>
 #include <QApplication>
+#include <QShowEvent>
+#include <QWindow>
+#include <QDebug>
 
-static constexpr int HANDOFF_POLL_MS = 15;
-static constexpr int HANDOFF_MAX_MS  = 1500;
-
-StartWindow::StartWindow(ApiClient* api, QWidget *parent)
+StartWindow::StartWindow(ApiClient* api, ImageLoader* images, TransactionStore* txStore,
+                         ActivityMonitor* activity, CassetteInventory* cassettes, QWidget *parent)
     : QWidget(parent),
       ui(new Ui::StartWindow),
-      m_api(api)
+      m_api(api),
+      m_images(images),
+      m_txStore(txStore),
+      m_activity(activity),
+      m_cassettes(cassettes)
 {
     ui->setupUi(this);
     setWindowTitle("Bank Automat");
 
+    // Both screens up front: a tap or a login only resets and shows them.
+    // winId() creates the native windows now, so the first show does not pay for it either.
+    m_loginDialog = new LoginDialog(m_api, m_activity, this);
+    connect(m_loginDialog, &LoginDialog::authenticated, this, &StartWindow::onAuthenticated);
+    connect(m_loginDialog, &QDialog::finished, this, &StartWindow::onLoginFinished);
+    m_loginDialog->winId();
+    m_loginDialog->windowHandle()->installEventFilter(this);
+
+    m_mainWindow = new MainWindow(m_api, m_images, m_txStore, m_activity, m_cassettes);
+    m_mainWindow->winId();
+    m_mainWindow->windowHandle()->installEventFilter(this);
+
+    // If MainWindow emits inactivity timeout, return to start
+    connect(m_mainWindow, &MainWindow::idleTimeout, this, &StartWindow::forceResetToStart);
+
+    // If user closes MainWindow manually, end the session and return to start (direct
+    // connection: the start screen is up before the last visible window is gone)
+    connect(m_mainWindow, &MainWindow::closed, this, [this]() {
+        if (m_session) m_session->end(QStringLiteral("closed"));
+        forceResetToStart();
+    });
+
     showFullScreen();   // koko ruutu
 
     new QShortcut(QKeySequence(Qt::Key_Escape), this, SLOT(close()));
@@ -27,9 +55,17 @@ StartWindow::StartWindow(ApiClient* api, QWidget *parent)
 
 StartWindow::~StartWindow()
 {
+    if (m_session) m_session->end(QStringLiteral("shutdown"));
+    delete m_mainWindow;
     delete ui;
 }
 
+void StartWindow::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (m_api) m_api->prewarm();
+}
+
 void StartWindow::forceResetToStart()
 {
     // Bring StartWindow up FIRST (cover desktop)
@@ -38,82 +74,105 @@ void StartWindow::forceResetToStart()
     this->activateWindow();
     if (ui && ui->startButton) ui->startButton->setFocus();
 
-    // Then close MainWindow slightly later (avoid desktop flash)
-    if (m_mainWindow) {
-        MainWindow* toClose = m_mainWindow;
-        m_mainWindow = nullptr;
+    // The session is over: abort its requests and drop its data now rather than
+    // dispatching them to a closing window
+    if (m_session) m_session->end(QStringLiteral("idle timeout"));
+    if (m_presenting == Presenting::MainWindow) m_presenting = Presenting::None;
 
-        QTimer::singleShot(50, this, [toClose]() {
-            if (toClose) {
-                toClose->close();
-                toClose->deleteLater();
-            }
+    // Then hide MainWindow slightly later (avoid desktop flash); it is kept for the next customer
+    if (m_mainWindow->isVisible()) {
+        QTimer::singleShot(50, this, [this]() {
+            if (!m_session || !m_session->isActive()) m_mainWindow->hide();
         });
     }
 }
 
 void StartWindow::on_startButton_clicked()
 {
-    LoginDialog dlg(m_api, this);
-
-    if (dlg.exec() == QDialog::Accepted) {
-        const int accountId = dlg.accountId();
-        const QString role = dlg.accountRole();
+    if (m_loginDialog->isVisible()) return;
 
-        // Make absolutely sure StartWindow covers the screen right after the modal closes
-        this->showFullScreen();
-        this->raise();
-        this->activateWindow();
-        qApp->processEvents(); // force paint before creating MainWindow
-
-        // Create + show MainWindow first. Keep StartWindow visible until
-        // MainWindow becomes the active top-level window to avoid a brief
-        // desktop "flash" when the modal dialog closes.
-        m_mainWindow = new MainWindow(m_api, accountId, role);
-
-        // If MainWindow emits inactivity timeout, return to start
-        QObject::connect(m_mainWindow, SIGNAL(idleTimeout()), this, SLOT(forceResetToStart()));
+    m_transitionClock.start();
+    m_presenting = Presenting::LoginDialog;
 
-        // If user closes MainWindow manually, return to start
-        connect(m_mainWindow, &QObject::destroyed, this, [this]() {
-            m_mainWindow = nullptr;
-        });
-
-        m_mainWindow->showFullScreen();
-        m_mainWindow->raise();
-        m_mainWindow->activateWindow();
-
-        // Poll until MainWindow is active, then hide StartWindow.
-        auto *handoffTimer = new QTimer(this);
-        handoffTimer->setInterval(HANDOFF_POLL_MS);
-        handoffTimer->setSingleShot(false);
+    m_loginDialog->reset();
+    m_loginDialog->open();
+}
 
-        QTimer::singleShot(HANDOFF_MAX_MS, handoffTimer, [handoffTimer]() {
-            if (handoffTimer) handoffTimer->stop();
-        });
+void StartWindow::onAuthenticated(const QJsonArray &accounts)
+{
+    if (m_session) m_session->end(QStringLiteral("login again"));
+
+    // The session starts here, not when the dialog closes: while a card with several
+    // accounts waits for its role, the hidden MainWindow already loads balances, first
+    // pages and the photo
+    m_session = new Session(m_api, accounts, this);
+    connect(m_session, &Session::finished, this, [](const Session::Stats &s) {
+        qInfo().noquote() << QStringLiteral("session %1 (account %2) ended: %3 after %4 s, "
+                                            "%5 requests cancelled, RSS %6 -> peak %7 -> %8 KiB, "
+                                            "%9 leaked replies")
+                                 .arg(s.id).arg(s.accountId).arg(s.endReason)
+                                 .arg(s.durationMs / 1000.0, 0, 'f', 1)
+                                 .arg(s.requestsCancelled)
+                                 .arg(s.rssStartBytes / 1024).arg(s.rssPeakBytes / 1024)
+                                 .arg(s.rssAfterBytes / 1024).arg(s.leakedReplies);
+        if (s.leakedReplies > 0) qWarning() << "session" << s.id << "left" << s.leakedReplies << "replies behind";
+    });
+
+    m_mainWindow->reset(m_session);
+}
 
-        connect(handoffTimer, &QTimer::timeout, this, [this, handoffTimer]() {
-            if (!m_mainWindow) {
-                handoffTimer->stop();
-                handoffTimer->deleteLater();
-                return;
-            }
-
-            m_mainWindow->raise();
-            m_mainWindow->activateWindow();
-
-            if (m_mainWindow->isVisible() && m_mainWindow->isActiveWindow()) {
-                this->hide();
-                handoffTimer->stop();
-                handoffTimer->deleteLater();
-            }
-        });
+void StartWindow::onLoginFinished(int result)
+{
+    const int accountId = m_loginDialog->accountId();
+    // Nothing of this customer stays in the hidden dialog (card number, PIN)
+    m_loginDialog->reset();
+    if (m_presenting == Presenting::LoginDialog) m_presenting = Presenting::None;
 
-        handoffTimer->start();
-    } else {
+    if (result != QDialog::Accepted || !m_session || !m_session->selectAccount(accountId)) {
+        if (m_session) m_session->end(QStringLiteral("login cancelled"));
         this->showFullScreen();
         this->raise();
         this->activateWindow();
         if (ui && ui->startButton) ui->startButton->setFocus();
+        return;
     }
-}
\ No newline at end of file
+
+    m_transitionClock.start();
+    m_presenting = Presenting::MainWindow;
+
+    // Show MainWindow first and keep StartWindow visible until it is on screen,
+    // so closing the modal dialog never uncovers the desktop
+    m_mainWindow->showFullScreen();
+    m_mainWindow->raise();
+    m_mainWindow->activateWindow();
+}
+
+bool StartWindow::eventFilter(QObject *obj, QEvent *event)
+{
+    const bool shown = (event->type() == QEvent::Expose && static_cast<QWindow*>(obj)->isExposed())
+                       || event->type() == QEvent::FocusIn;
+    if (!shown || m_presenting == Presenting::None) return QWidget::eventFilter(obj, event);
+
+    const Presenting screen = m_presenting;
+    const bool expected = (screen == Presenting::LoginDialog && obj == m_loginDialog->windowHandle())
+                          || (screen == Presenting::MainWindow && obj == m_mainWindow->windowHandle());
+    if (expected) {
+        m_presenting = Presenting::None;
+        const qint64 elapsedNs = m_transitionClock.nsecsElapsed();
+        // After this event has been handled, i.e. once the window has painted its first frame
+        QTimer::singleShot(0, this, [this, screen, elapsedNs]() { onPresented(screen, elapsedNs); });
+    }
+    return QWidget::eventFilter(obj, event);
+}
+
+void StartWindow::onPresented(Presenting screen, qint64 elapsedNs)
+{
+    if (screen == Presenting::LoginDialog) {
+        if (m_api) m_api->metrics().recordTransition(QStringLiteral("tap_to_login_dialog"), elapsedNs);
+        return;
+    }
+
+    if (m_api) m_api->metrics().recordTransition(QStringLiteral("login_to_dashboard"), elapsedNs);
+    // Customer still there (no timeout in between): the start screen can go
+    if (m_session && m_session->isActive() && m_mainWindow->isVisible()) this->hide();
+}
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QPointer>
 #include <QWidget>
 
+class ActivityMonitor;
 class ApiClient;
+class CassetteInventory;
+class ImageLoader;
+class TransactionStore;
+class LoginDialog;
 class MainWindow;
+class Session;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class StartWindow; }
@@ -14,18 +23,43 @@ class StartWindow : public QWidget
     Q_OBJECT
 
 public:
-    explicit StartWindow(ApiClient* api, QWidget *parent = nullptr);
+    explicit StartWindow(ApiClient* api, ImageLoader* images, TransactionStore* txStore,
+                         ActivityMonitor* activity, CassetteInventory* cassettes,
+                         QWidget *parent = nullptr);
     ~StartWindow();
 
 public slots:
     // Return to the initial UI state (used by inactivity timeout and window close)
     void forceResetToStart();
 
+protected:
+    // Warm up the backend connection while the attract screen is showing
+    void showEvent(QShowEvent *event) override;
+    // Expose / activation of the login dialog and main window (handoff, transition timing)
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
 private slots:
     void on_startButton_clicked();
+    void onAuthenticated(const QJsonArray& accounts);
+    void onLoginFinished(int result);
 
 private:
     Ui::StartWindow *ui;
     ApiClient* m_api = nullptr;
-    MainWindow* m_mainWindow = nullptr;
-};
\ No newline at end of file
+    ImageLoader* m_images = nullptr;
+    TransactionStore* m_txStore = nullptr;
+    ActivityMonitor* m_activity = nullptr;
+    CassetteInventory* m_cassettes = nullptr;
+
+    // Built once in the constructor (native windows included) and reused for every customer
+    LoginDialog* m_loginDialog = nullptr;
+    MainWindow* m_mainWindow = nullptr; // top-level, owned
+    QPointer<Session> m_session; // customer at the kiosk, null on the attract screen
+
+    // Screen on its way up: finished by its first expose or activation, not by polling.
+    // tap -> login dialog and login -> main window are recorded as UI transitions.
+    enum class Presenting { None, LoginDialog, MainWindow };
+    Presenting m_presenting = Presenting::None;
+    QElapsedTimer m_transitionClock;
+    void onPresented(Presenting screen, qint64 elapsedNs);
+};
@@ -0,0 +1,392 @@
+#include "TransactionStore.h"
+
+#include "ReplyDecoder.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QStandardPaths>
+#include <QVector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+static const char FILE_MAGIC[8] = { 'B', 'A', 'T', 'X', 'S', 'T', '0', '1' };
+static constexpr quint32 FILE_VERSION = 1;
+static constexpr quint32 RECORD_MARKER = 0x31525854; // "TXR1"
+static constexpr quint32 SLOT_MARKER = 0x31534c53;   // "SLS1"
+
+static constexpr qint64 FILE_HEADER_SIZE = 64;
+static constexpr qint64 SLOT_HEADER_SIZE = 32;
+static constexpr qint64 RECORD_SIZE = 64;
+static constexpr qint64 SLOT_SIZE = SLOT_HEADER_SIZE + TransactionStore::RECORDS_PER_SLOT * RECORD_SIZE;
+static constexpr qint64 FILE_SIZE = FILE_HEADER_SIZE + TransactionStore::SLOT_COUNT * SLOT_SIZE;
+
+// Native byte order: the file never leaves the kiosk
+struct TransactionStore::Record {
+    qint64 createdMs;
+    qint64 id;
+    qint64 amountCents;
+    qint64 storedAtMs;
+    char txType[24];   // NUL-padded
+    quint32 marker;
+    quint32 crc;       // CRC-32 of everything above
+};
+static_assert(sizeof(TransactionStore::Record) == RECORD_SIZE, "record layout");
+
+struct TransactionStore::SlotHeader {
+    qint32 accountId;
+    quint32 marker;
+    qint64 lastWriteMs; // least recently written slot is reused first
+    qint64 reserved0;
+    quint32 reserved1;
+    quint32 crc;
+};
+static_assert(sizeof(TransactionStore::SlotHeader) == SLOT_HEADER_SIZE, "slot header layout");
+
+struct FileHeader {
+    char magic[8];
+    quint32 version;
+    quint32 slotCount;
+    quint32 recordsPerSlot;
+    quint32 recordSize;
+    char reserved[40];
+};
+static_assert(sizeof(FileHeader) == FILE_HEADER_SIZE, "file header layout");
+
+static quint32 crc32(const void *data, size_t size)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    const uchar *p = static_cast<const uchar *>(data);
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static bool newerThan(qint64 ms, qint64 id, qint64 otherMs, qint64 otherId)
+{
+    return ms > otherMs || (ms == otherMs && id > otherId);
+}
+
+TransactionStore::TransactionStore(const QString &path, qint64 retentionMs)
+    : m_path(path),
+      m_retentionMs(retentionMs)
+{
+    if (m_path.isEmpty()) {
+        m_path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                 + QStringLiteral("/transactions.store");
+    }
+}
+
+TransactionStore::~TransactionStore()
+{
+    if (m_map) m_file.unmap(m_map);
+}
+
+bool TransactionStore::open(QString *error)
+{
+    if (m_map) return true;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        if (error) *error = m_file.errorString();
+        return false;
+    }
+
+    FileHeader expected{};
+    std::memcpy(expected.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    expected.version = FILE_VERSION;
+    expected.slotCount = SLOT_COUNT;
+    expected.recordsPerSlot = RECORDS_PER_SLOT;
+    expected.recordSize = RECORD_SIZE;
+
+    bool fresh = m_file.size() != FILE_SIZE;
+    if (!fresh) {
+        FileHeader actual{};
+        fresh = m_file.read(reinterpret_cast<char *>(&actual), sizeof(actual)) != qint64(sizeof(actual))
+                || std::memcmp(&actual, &expected, sizeof(actual)) != 0;
+    }
+    if (fresh) {
+        // New file or another layout: start empty (resize() zero-fills)
+        if (!m_file.resize(0) || !m_file.resize(FILE_SIZE)) {
+            if (error) *error = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_map = m_file.map(0, FILE_SIZE);
+    if (!m_map) {
+        if (error) *error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    if (fresh) std::memcpy(m_map, &expected, sizeof(expected));
+
+    expire();
+    return true;
+}
+
+// -------- layout access --------
+
+uchar *TransactionStore::slotHeaderAt(int slot) const
+{
+    return m_map + FILE_HEADER_SIZE + qint64(slot) * SLOT_SIZE;
+}
+
+uchar *TransactionStore::recordAt(int slot, int index) const
+{
+    return slotHeaderAt(slot) + SLOT_HEADER_SIZE + qint64(index) * RECORD_SIZE;
+}
+
+bool TransactionStore::readRecord(int slot, int index, Record *out) const
+{
+    std::memcpy(out, recordAt(slot, index), sizeof(Record));
+    return out->marker == RECORD_MARKER && out->crc == crc32(out, offsetof(Record, crc));
+}
+
+void TransactionStore::writeRecord(int slot, int index, Record record)
+{
+    record.marker = RECORD_MARKER;
+    record.crc = crc32(&record, offsetof(Record, crc));
+    std::memcpy(recordAt(slot, index), &record, sizeof(Record));
+}
+
+int TransactionStore::slotAccount(int slot) const
+{
+    SlotHeader h;
+    std::memcpy(&h, slotHeaderAt(slot), sizeof(h));
+    if (h.marker != SLOT_MARKER || h.crc != crc32(&h, offsetof(SlotHeader, crc))) return 0;
+    return h.accountId;
+}
+
+// -------- slots --------
+
+int TransactionStore::findSlot(int accountId) const
+{
+    if (!m_map || accountId <= 0) return -1;
+    for (int s = 0; s < SLOT_COUNT; ++s) {
+        if (slotAccount(s) == accountId) return s;
+    }
+    return -1;
+}
+
+int TransactionStore::claimSlot(int accountId)
+{
+    int slot = -1;
+    qint64 oldestWrite = std::numeric_limits<qint64>::max();
+    for (int s = 0; s < SLOT_COUNT; ++s) {
+        if (slotAccount(s) == 0) {
+            slot = s;
+            break;
+        }
+        SlotHeader h;
+        std::memcpy(&h, slotHeaderAt(s), sizeof(h));
+        if (h.lastWriteMs < oldestWrite) {
+            oldestWrite = h.lastWriteMs;
+            slot = s;
+        }
+    }
+
+    // Records first, header last: a crash in between leaves a free slot, never stale rows
+    clearSlot(slot);
+
+    SlotHeader h{};
+    h.accountId = accountId;
+    h.marker = SLOT_MARKER;
+    h.lastWriteMs = QDateTime::currentMSecsSinceEpoch();
+    h.crc = crc32(&h, offsetof(SlotHeader, crc));
+    std::memcpy(slotHeaderAt(slot), &h, sizeof(h));
+    return slot;
+}
+
+void TransactionStore::clearSlot(int slot)
+{
+    if (slot < 0) return;
+    std::memset(slotHeaderAt(slot) + SLOT_HEADER_SIZE, 0, RECORDS_PER_SLOT * RECORD_SIZE);
+    std::memset(slotHeaderAt(slot), 0, SLOT_HEADER_SIZE);
+}
+
+// -------- rows --------
+
+// Rows without a valid amount are not stored rather than stored as 0
+static QVector<Transaction> storableRows(const QJsonArray &items)
+{
+    QVector<Transaction> rows;
+    rows.reserve(items.size());
+    qint64 cents = 0;
+    for (const auto &v : items) {
+        const QJsonObject row = v.toObject();
+        if (ReplyDecoder::parseCents(row.value("amount"), &cents)) rows.append(ReplyDecoder::transaction(row));
+    }
+    return rows;
+}
+
+void TransactionStore::insert(int slot, const Transaction &tx, qint64 nowMs)
+{
+    if (tx.id <= 0 || tx.createdMs <= 0) return;
+    Record r{};
+    r.amountCents = tx.amountCents;
+    r.id = tx.id;
+    r.createdMs = tx.createdMs;
+    r.storedAtMs = nowMs;
+    const QString &typeText = tx.type == Transaction::Type::Other ? tx.otherType : ReplyDecoder::typeText(tx.type);
+    const QByteArray type = typeText.toUtf8().left(sizeof(r.txType) - 1);
+    std::memcpy(r.txType, type.constData(), type.size());
+
+    int freeIndex = -1;
+    int oldestIndex = -1;
+    Record oldest{};
+    for (int i = 0; i < RECORDS_PER_SLOT; ++i) {
+        Record existing;
+        if (!readRecord(slot, i, &existing)) {
+            if (freeIndex < 0) freeIndex = i;
+            continue;
+        }
+        if (existing.id == r.id) {
+            writeRecord(slot, i, r); // same row again: refresh its retention
+            return;
+        }
+        if (oldestIndex < 0 || newerThan(oldest.createdMs, oldest.id, existing.createdMs, existing.id)) {
+            oldestIndex = i;
+            oldest = existing;
+        }
+    }
+
+    if (freeIndex >= 0) {
+        writeRecord(slot, freeIndex, r);
+    } else if (newerThan(r.createdMs, r.id, oldest.createdMs, oldest.id)) {
+        // Full: keep the newest rows so the slot stays one contiguous run
+        writeRecord(slot, oldestIndex, r);
+    }
+}
+
+void TransactionStore::put(int accountId, const QJsonArray &items)
+{
+    put(accountId, storableRows(items));
+}
+
+void TransactionStore::putHead(int accountId, const QJsonArray &items, bool hasMore)
+{
+    putHead(accountId, storableRows(items), hasMore);
+}
+
+void TransactionStore::put(int accountId, const QVector<Transaction> &items)
+{
+    if (!m_map || accountId <= 0 || items.isEmpty()) return;
+
+    int slot = findSlot(accountId);
+    if (slot < 0) slot = claimSlot(accountId);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const Transaction &tx : items) insert(slot, tx, now);
+
+    SlotHeader h;
+    std::memcpy(&h, slotHeaderAt(slot), sizeof(h));
+    h.lastWriteMs = now;
+    h.crc = crc32(&h, offsetof(SlotHeader, crc));
+    std::memcpy(slotHeaderAt(slot), &h, sizeof(h));
+}
+
+void TransactionStore::putHead(int accountId, const QVector<Transaction> &items, bool hasMore)
+{
+    if (!m_map || accountId <= 0) return;
+
+    const int slot = findSlot(accountId);
+    if (slot >= 0 && hasMore) {
+        // The head page must share a row with what is stored, or rows in between are unknown
+        QSet<qint64> stored;
+        for (int i = 0; i < RECORDS_PER_SLOT; ++i) {
+            Record r;
+            if (readRecord(slot, i, &r)) stored.insert(r.id);
+        }
+        bool overlaps = false;
+        for (const Transaction &tx : items) {
+            if (stored.contains(tx.id)) {
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) clearSlot(slot);
+    }
+    put(accountId, items);
+}
+
+void TransactionStore::forget(int accountId)
+{
+    clearSlot(findSlot(accountId));
+}
+
+QJsonArray TransactionStore::recent(int accountId, int limit) const
+{
+    const int slot = findSlot(accountId);
+    if (slot < 0 || limit <= 0) return QJsonArray();
+
+    const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - m_retentionMs;
+    QVector<Record> rows;
+    rows.reserve(RECORDS_PER_SLOT);
+    for (int i = 0; i < RECORDS_PER_SLOT; ++i) {
+        Record r;
+        if (readRecord(slot, i, &r) && r.storedAtMs >= cutoff) rows.append(r);
+    }
+    std::sort(rows.begin(), rows.end(), [](const Record &a, const Record &b) {
+        return newerThan(a.createdMs, a.id, b.createdMs, b.id);
+    });
+
+    QJsonArray out;
+    for (int i = 0; i < qMin(limit, int(rows.size())); ++i) {
+        const Record &r = rows.at(i);
+        out.append(QJsonObject{
+            { "id", r.id },
+            { "tx_type", QString::fromUtf8(r.txType, int(qstrnlen(r.txType, sizeof(r.txType)))) },
+            { "amount", ReplyDecoder::decimalText(r.amountCents) },
+            { "created_at", double(r.createdMs) },
+        });
+    }
+    return out;
+}
+
+int TransactionStore::expire()
+{
+    if (!m_map) return 0;
+
+    const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - m_retentionMs;
+    int dropped = 0;
+    for (int s = 0; s < SLOT_COUNT; ++s) {
+        if (slotAccount(s) == 0) continue;
+
+        int kept = 0;
+        for (int i = 0; i < RECORDS_PER_SLOT; ++i) {
+            Record r;
+            if (!readRecord(s, i, &r)) continue;
+            if (r.storedAtMs < cutoff) {
+                std::memset(recordAt(s, i), 0, RECORD_SIZE);
+                ++dropped;
+            } else {
+                ++kept;
+            }
+        }
+        if (kept == 0) clearSlot(s);
+    }
+    return dropped;
+}
+
+QString TransactionStore::cursorOf(const QJsonObject &row)
+{
+    qint64 createdMs = 0;
+    if (!ReplyDecoder::parseTimestamp(row.value("created_at"), &createdMs)) createdMs = 0;
+    return QStringLiteral("%1|%2").arg(createdMs).arg(row.value("id").toInteger());
+}
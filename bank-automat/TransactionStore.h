@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+struct Transaction;
+
+// Recent transactions per account, kept on disk across sessions so the Transactions
+// tab can show rows before the network answers (then reconcile with after=<newest>).
+//
+// One memory-mapped file of fixed size (QFile::map, no parsing on open):
+//   header | SLOT_COUNT x ( slot header | RECORDS_PER_SLOT x 64-byte record )
+// A slot holds the newest rows of one account, contiguous from its newest row down;
+// the least recently written slot is reused when all are taken.
+//
+// Crash safety: every record and slot header carries a CRC-32, written as part of the
+// same 64/32-byte copy. A write torn by a crash fails its CRC and reads as an empty
+// record, so the file never needs repair or a journal. Records older than the retention
+// window (by time stored) are dropped on open and never returned. The same window bounds
+// ImageLoader's disk cache: nothing of a customer stays on disk longer than this.
+class TransactionStore
+{
+public:
+    static constexpr int SLOT_COUNT = 128;
+    static constexpr int RECORDS_PER_SLOT = 200; // 20 pages of 10
+    static constexpr qint64 DEFAULT_RETENTION_MS = qint64(7) * 24 * 3600 * 1000;
+
+    explicit TransactionStore(const QString& path = QString(), qint64 retentionMs = DEFAULT_RETENTION_MS);
+    ~TransactionStore();
+
+    // Maps the file, creating or re-initialising it when missing or of another layout.
+    // Without a successful open() every call below is a no-op / returns nothing.
+    bool open(QString* error = nullptr);
+    bool isOpen() const { return m_map != nullptr; }
+    QString path() const { return m_path; }
+
+    // Newest page from the server. If it does not reach the stored rows and more rows
+    // follow (hasMore), there could be a gap, so the account's stored rows are dropped first.
+    void putHead(int accountId, const QVector<Transaction>& items, bool hasMore);
+    // Rows known to join the stored ones: older pages read on from them, or the after= delta
+    void put(int accountId, const QVector<Transaction>& items);
+    // Rows still in the API shape (session bootstrap); ones without a valid amount are skipped
+    void putHead(int accountId, const QJsonArray& items, bool hasMore);
+    void put(int accountId, const QJsonArray& items);
+    void forget(int accountId);
+
+    // Newest first, in the API row shape ({id, tx_type, amount, created_at}); created_at
+    // is epoch ms like a CBOR reply, amount the DECIMAL text
+    QJsonArray recent(int accountId, int limit = RECORDS_PER_SLOT) const;
+
+    // Drops records past the retention window; returns how many
+    int expire();
+
+    // "<epochMs>|<id>" for a row in the API shape (same format as the backend cursors)
+    static QString cursorOf(const QJsonObject& row);
+
+private:
+    struct Record;
+    struct SlotHeader;
+
+    QString m_path;
+    qint64 m_retentionMs;
+    QFile m_file;
+    uchar* m_map = nullptr;
+
+    int findSlot(int accountId) const;
+    int claimSlot(int accountId);
+    void clearSlot(int slot);
+    void insert(int slot, const Transaction& tx, qint64 nowMs);
+
+    uchar* slotHeaderAt(int slot) const;
+    uchar* recordAt(int slot, int index) const;
+    bool readRecord(int slot, int index, Record* out) const;
+    void writeRecord(int slot, int index, Record record);
+    int slotAccount(int slot) const; // 0 = free
+};
@@ -0,0 +1,233 @@
+#include "TransactionsModel.h"
+
+#include "LocaleFormatter.h"
+
+#include <QDateTime>
+#include <QFont>
+#include <QFontMetrics>
+#include <QJsonObject>
+#include <algorithm>
+
+// Extra room around the measured text (cell margins + sort indicator space)
+static constexpr int COLUMN_PADDING_PX = 24;
+
+TransactionsModel::TransactionsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int TransactionsModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_ids.size();
+}
+
+int TransactionsModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return ColumnCount;
+}
+
+QVariant TransactionsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_ids.size()) return QVariant();
+
+    const int row = index.row();
+
+    if (role == Qt::TextAlignmentRole && index.column() == AmountColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) return QVariant();
+
+    // All strings are prebuilt -> returning them only bumps a refcount
+    switch (index.column()) {
+    case DateColumn:
+        return m_dateText.at(row);
+    case TypeColumn:
+        if (m_types.at(row) == Transaction::Type::Other) return m_otherTypeText.at(row);
+        return ReplyDecoder::typeText(m_types.at(row));
+    case AmountColumn:
+        return m_amountText.at(row);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant TransactionsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return QVariant();
+
+    if (orientation == Qt::Vertical) {
+        // Running row number: 1-10, 11-20, ...
+        return section + 1;
+    }
+
+    switch (section) {
+    case DateColumn:   return QStringLiteral("Date");
+    case TypeColumn:   return QStringLiteral("Type");
+    case AmountColumn: return QStringLiteral("Amount");
+    default:           return QVariant();
+    }
+}
+
+bool TransactionsModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+    return !m_fetching && !m_nextCursor.isEmpty();
+}
+
+void TransactionsModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) return;
+    m_fetching = true;
+    emit fetchMoreRequested(m_nextCursor);
+}
+
+void TransactionsModel::clear()
+{
+    beginResetModel();
+    m_createdMs.clear();
+    m_ids.clear();
+    m_types.clear();
+    m_dateText.clear();
+    m_amountText.clear();
+    m_otherTypeText.clear();
+    m_nextCursor.clear();
+    m_fetching = false;
+    endResetModel();
+}
+
+void TransactionsModel::appendPage(const QVector<Transaction> &items, const QString &nextCursor)
+{
+    m_fetching = false;
+    m_nextCursor = nextCursor;
+    addRows(items, m_ids.size());
+}
+
+void TransactionsModel::appendPage(const QJsonArray &items, const QString &nextCursor)
+{
+    m_fetching = false;
+    m_nextCursor = nextCursor;
+    addRows(ReplyDecoder::transactions(items), m_ids.size(), items);
+}
+
+QString TransactionsModel::headCursor() const
+{
+    if (m_ids.isEmpty()) return QString();
+    return QStringLiteral("%1|%2").arg(m_createdMs.first()).arg(m_ids.first());
+}
+
+void TransactionsModel::beginStream()
+{
+    m_fetching = true;
+    m_nextCursor.clear();
+}
+
+void TransactionsModel::appendRows(const QVector<Transaction> &items)
+{
+    addRows(items, m_ids.size());
+}
+
+void TransactionsModel::endStream(const QString &nextCursor)
+{
+    m_fetching = false;
+    m_nextCursor = nextCursor;
+}
+
+void TransactionsModel::prependRows(const QVector<Transaction> &items)
+{
+    addRows(items, 0);
+}
+
+void TransactionsModel::addRows(const QVector<Transaction> &items, int position, const QJsonArray &source)
+{
+    if (items.isEmpty()) return;
+
+    const int count = items.size();
+
+    // Build the new rows aside, then splice them in at `position`
+    QVector<qint64> createdMs;
+    QVector<qint64> ids;
+    QVector<Transaction::Type> types;
+    QVector<QString> dateText;
+    QVector<QString> amountText;
+    QVector<QString> otherTypeText;
+    createdMs.reserve(count);
+    ids.reserve(count);
+    types.reserve(count);
+    dateText.reserve(count);
+    amountText.reserve(count);
+    otherTypeText.reserve(count);
+
+    const LocaleFormatter &format = LocaleFormatter::shared();
+    for (int i = 0; i < count; ++i) {
+        const Transaction &tx = items.at(i);
+
+        createdMs.append(tx.createdMs);
+        ids.append(tx.id);
+        types.append(tx.type);
+        // Shown in kiosk local time whichever format the timestamp came in; text the
+        // decoder does not understand is shown as it came
+        dateText.append(tx.createdMs > 0 ? format.dateTime(tx.createdMs)
+                                         : source.at(i).toObject().value(QLatin1String("created_at")).toString());
+        amountText.append(ReplyDecoder::decimalText(tx.amountCents));
+        otherTypeText.append(tx.otherType);
+    }
+
+    position = qBound(0, position, int(m_ids.size()));
+    beginInsertRows(QModelIndex(), position, position + count - 1);
+    if (position == m_ids.size()) {
+        m_createdMs.append(createdMs);
+        m_ids.append(ids);
+        m_types.append(types);
+        m_dateText.append(dateText);
+        m_amountText.append(amountText);
+        m_otherTypeText.append(otherTypeText);
+    } else {
+        m_createdMs.insert(position, count, 0);
+        m_ids.insert(position, count, 0);
+        m_types.insert(position, count, Transaction::Type::Other);
+        m_dateText.insert(position, count, QString());
+        m_amountText.insert(position, count, QString());
+        m_otherTypeText.insert(position, count, QString());
+        std::copy(createdMs.cbegin(), createdMs.cend(), m_createdMs.begin() + position);
+        std::copy(ids.cbegin(), ids.cend(), m_ids.begin() + position);
+        std::copy(types.cbegin(), types.cend(), m_types.begin() + position);
+        std::copy(dateText.cbegin(), dateText.cend(), m_dateText.begin() + position);
+        std::copy(amountText.cbegin(), amountText.cend(), m_amountText.begin() + position);
+        std::copy(otherTypeText.cbegin(), otherTypeText.cend(), m_otherTypeText.begin() + position);
+    }
+    endInsertRows();
+}
+
+void TransactionsModel::fetchFailed()
+{
+    m_fetching = false;
+}
+
+int TransactionsModel::columnWidthHint(int column, const QFont &font) const
+{
+    if (column < 0 || column >= ColumnCount) return 0;
+
+    const QString key = font.key();
+    if (key != m_metricsFontKey) {
+        // Measure representative strings once per font instead of every row
+        const QFontMetrics fm(font);
+        const QDateTime sample(QDate(2000, 12, 28), QTime(23, 58, 58));
+
+        int typeWidth = fm.horizontalAdvance(QStringLiteral("Type"));
+        for (Transaction::Type t : { Transaction::Type::Withdrawal, Transaction::Type::Deposit,
+                                     Transaction::Type::Balance }) {
+            typeWidth = qMax(typeWidth, fm.horizontalAdvance(ReplyDecoder::typeText(t)));
+        }
+
+        m_metricsWidths[DateColumn] = fm.horizontalAdvance(
+            LocaleFormatter::shared().dateTime(sample.toMSecsSinceEpoch()));
+        m_metricsWidths[TypeColumn] = typeWidth;
+        m_metricsWidths[AmountColumn] = fm.horizontalAdvance(QStringLiteral("-0000000.00"));
+        for (int &w : m_metricsWidths) w += COLUMN_PADDING_PX;
+
+        m_metricsFontKey = key;
+    }
+    return m_metricsWidths[column];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QJsonArray>
+#include <QString>
+#include <QVector>
+
+#include "ReplyDecoder.h"
+
+class QFont;
+
+// Table model for the Transactions tab.
+// Rows are kept newest -> oldest in a struct-of-arrays store; display strings are
+// built once when a page is appended (typed rows, cached locale formatter), so data()
+// never allocates per cell.
+// Older rows are loaded on demand through canFetchMore()/fetchMore(): the model
+// emits fetchMoreRequested(before) and the owner answers with appendPage().
+class TransactionsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { DateColumn = 0, TypeColumn, AmountColumn, ColumnCount };
+
+    explicit TransactionsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // Drop all rows (new head, e.g. after a withdraw)
+    void clear();
+
+    // Append an older page at the bottom. nextCursor = before= cursor of the page after it
+    // (empty -> no more rows). The QJsonArray overload takes rows that are still
+    // documents (session bootstrap, stored rows).
+    void appendPage(const QVector<Transaction> &items, const QString &nextCursor);
+    void appendPage(const QJsonArray &items, const QString &nextCursor);
+
+    // Insert rows newer than the current head at the top (after= delta, newest first).
+    // Leaves the cursor and any fetch in flight alone.
+    void prependRows(const QVector<Transaction> &items);
+
+    // The fetch started by fetchMoreRequested failed; allow fetchMore() again.
+    void fetchFailed();
+
+    // Streamed load (full statement): rows arrive in batches while the reply is still open.
+    // fetchMore() stays off until endStream() sets the cursor for whatever comes after.
+    void beginStream();
+    void appendRows(const QVector<Transaction> &items);
+    void endStream(const QString &nextCursor);
+
+    bool isFetching() const { return m_fetching; }
+    QString nextCursor() const { return m_nextCursor; }
+    // after= cursor of the head (newest) row, empty when there are no rows
+    QString headCursor() const;
+
+    // Column width from font metrics; cached per font so sizing never walks the rows.
+    int columnWidthHint(int column, const QFont &font) const;
+
+signals:
+    void fetchMoreRequested(const QString &beforeCursor);
+
+private:
+    // Struct-of-arrays row store (index = row)
+    QVector<qint64> m_createdMs;
+    QVector<qint64> m_ids;
+    QVector<Transaction::Type> m_types;
+    QVector<QString> m_dateText;
+    QVector<QString> m_amountText;
+    QVector<QString> m_otherTypeText; // raw tx_type for rows with Transaction::Type::Other, else empty
+
+    QString m_nextCursor;
+    bool m_fetching = false;
+
+    mutable QString m_metricsFontKey;
+    mutable int m_metricsWidths[ColumnCount] = { 0, 0, 0 };
+
+    // `source`: the same rows as documents, for created_at text the decoder did not understand
+    void addRows(const QVector<Transaction> &items, int position, const QJsonArray &source = QJsonArray());
+};
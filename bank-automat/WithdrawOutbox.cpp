@@ -0,0 +1,148 @@
+#include "WithdrawOutbox.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtGlobal>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static bool syncToDisk(QFile &file)
+{
+    if (!file.flush()) return false;
+#ifdef Q_OS_WIN
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+WithdrawOutbox::WithdrawOutbox(const QString &path)
+    : m_path(path)
+{
+    if (m_path.isEmpty()) {
+        m_path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                 + QStringLiteral("/withdraw-outbox.jsonl");
+    }
+}
+
+bool WithdrawOutbox::open(QString *error)
+{
+    if (m_file.isOpen()) return true;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    // Replay: intents minus outcomes, reversal marks kept
+    QFile existing(m_path);
+    if (existing.open(QIODevice::ReadOnly)) {
+        while (!existing.atEnd()) {
+            const QJsonObject line = QJsonDocument::fromJson(existing.readLine()).object();
+            const QString key = line.value("key").toString();
+            if (key.isEmpty()) continue; // torn or foreign line
+
+            if (line.value("op").toString() == QLatin1String("intent")) {
+                Entry e;
+                e.key = key;
+                e.accountId = line.value("accountId").toInt();
+                e.amount = line.value("amount").toInt();
+                e.createdMs = line.value("at").toInteger();
+                m_pending.insert(key, e);
+            } else if (line.value("op").toString() == QLatin1String("reverse")) {
+                const auto it = m_pending.find(key);
+                if (it != m_pending.end()) it->reverse = true;
+            } else {
+                m_pending.remove(key);
+            }
+        }
+        existing.close();
+    }
+
+    // Compact to the pending intents (QSaveFile: written and synced aside, then renamed)
+    QSaveFile compacted(m_path);
+    if (!compacted.open(QIODevice::WriteOnly)) {
+        if (error) *error = compacted.errorString();
+        return false;
+    }
+    for (const Entry &e : pending()) {
+        const QJsonObject line{
+            { "op", "intent" },
+            { "key", e.key },
+            { "accountId", e.accountId },
+            { "amount", e.amount },
+            { "at", e.createdMs },
+        };
+        compacted.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+        if (e.reverse) {
+            const QJsonObject mark{ { "op", "reverse" }, { "key", e.key } };
+            compacted.write(QJsonDocument(mark).toJson(QJsonDocument::Compact) + '\n');
+        }
+    }
+    if (!compacted.commit()) {
+        if (error) *error = compacted.errorString();
+        return false;
+    }
+
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (error) *error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool WithdrawOutbox::append(const QJsonObject &line)
+{
+    if (!m_file.isOpen()) return false;
+    const QByteArray bytes = QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+    return m_file.write(bytes) == bytes.size() && syncToDisk(m_file);
+}
+
+bool WithdrawOutbox::recordIntent(const Entry &entry)
+{
+    m_pending.insert(entry.key, entry);
+    return append(QJsonObject{
+        { "op", "intent" },
+        { "key", entry.key },
+        { "accountId", entry.accountId },
+        { "amount", entry.amount },
+        { "at", entry.createdMs },
+    });
+}
+
+bool WithdrawOutbox::recordReversal(const QString &key)
+{
+    const auto it = m_pending.find(key);
+    if (it == m_pending.end() || it->reverse) return true;
+    it->reverse = true;
+    return append(QJsonObject{
+        { "op", "reverse" },
+        { "key", key },
+        { "at", QDateTime::currentMSecsSinceEpoch() },
+    });
+}
+
+bool WithdrawOutbox::recordOutcome(const QString &key, const QString &outcome, int httpStatus)
+{
+    if (!m_pending.remove(key)) return true; // settled already
+    return append(QJsonObject{
+        { "op", outcome },
+        { "key", key },
+        { "status", httpStatus },
+        { "at", QDateTime::currentMSecsSinceEpoch() },
+    });
+}
+
+QVector<WithdrawOutbox::Entry> WithdrawOutbox::pending() const
+{
+    QVector<Entry> out = m_pending.values();
+    std::sort(out.begin(), out.end(), [](const Entry &a, const Entry &b) { return a.createdMs < b.createdMs; });
+    return out;
+}
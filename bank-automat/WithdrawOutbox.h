@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+// Journal of withdrawals whose outcome is not known yet, on disk across crashes.
+// ApiClient writes the intent (idempotency key, account, amount) and fsyncs it before
+// the POST leaves, and the outcome once the bank has answered. Whatever is still
+// pending on the next start is settled by key (ApiClient::reconcileWithdrawals).
+//
+// A withdrawal the bank completed but the kiosk never paid out (the answer came too late)
+// stays here, marked for reversal, until the bank confirms the credit back.
+//
+// Append-only JSON lines, one fsync per line; a line torn by a crash fails to parse
+// and is skipped. open() rewrites the file with only the pending intents.
+class WithdrawOutbox
+{
+public:
+    struct Entry {
+        QString key;
+        int accountId = 0;
+        int amount = 0;
+        qint64 createdMs = 0;
+        bool reverse = false; // debited at the bank, not paid out: to be credited back
+    };
+
+    explicit WithdrawOutbox(const QString& path = QString());
+
+    bool open(QString* error = nullptr);
+    bool isOpen() const { return m_file.isOpen(); }
+    QString path() const { return m_path; }
+
+    // false = not on disk (the withdrawal itself is still safe by key)
+    bool recordIntent(const Entry& entry);
+    // Still pending, from now on as a reversal (survives restarts)
+    bool recordReversal(const QString& key);
+    // outcome: completed | refused | failed | cancelled | reversed
+    bool recordOutcome(const QString& key, const QString& outcome, int httpStatus);
+
+    QVector<Entry> pending() const;
+    bool isPending(const QString& key) const { return m_pending.contains(key); }
+
+private:
+    QString m_path;
+    QFile m_file;
+    QHash<QString, Entry> m_pending;
+
+    bool append(const QJsonObject& line);
+};
@@ -0,0 +1,527 @@
+// Micro-benchmarks for the client hot paths (QBENCHMARK).
+//
+//   bank-automat-bench                      human readable
+//   bank-automat-bench -o bench.xml,xml     machine readable (one <BenchmarkResult> per row)
+//   cmake --build . --target bench          writes bench/bank-automat-bench.xml
+//
+// Fixtures are generated in initTestCase with the same shapes the backend sends,
+// so no server or database is needed.
+
+#include "CborDecoder.h"
+#include "ImageLoader.h"
+#include "LocaleFormatter.h"
+#include "ReplyDecoder.h"
+#include "TransactionsModel.h"
+
+#include <QBuffer>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QDateTime>
+#include <QImage>
+#include <QHeaderView>
+#include <QImageWriter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLinearGradient>
+#include <QLocale>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QTableView>
+#include <QtTest>
+
+static const char *const TX_TYPES[] = { "withdrawal", "deposit", "balance" };
+static const qint64 FIXTURE_START_MS = 1735725600000; // 2025-01-01 10:00 UTC
+
+struct FixtureRow {
+    qint64 id;
+    const char *type;
+    qint64 cents;
+    qint64 createdMs;
+};
+
+static QVector<FixtureRow> fixtureRows(int count)
+{
+    QVector<FixtureRow> rows;
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        rows.append({ 100000 + i, TX_TYPES[i % 3], (20 + (i % 13) * 10) * 100,
+                      FIXTURE_START_MS - qint64(i) * 3600 * 1000 });
+    }
+    return rows;
+}
+
+// JSON as Express sends it: DECIMAL as string, DATETIME as ISO string
+static QJsonArray jsonItems(const QVector<FixtureRow> &rows)
+{
+    QJsonArray items;
+    for (const FixtureRow &r : rows) {
+        QJsonObject o;
+        o["id"] = r.id;
+        o["tx_type"] = QString::fromLatin1(r.type);
+        o["amount"] = CborDecoder::decimalToString(r.cents, -2);
+        o["created_at"] = QDateTime::fromMSecsSinceEpoch(r.createdMs, Qt::UTC)
+                              .toString(Qt::ISODateWithMs);
+        items.append(o);
+    }
+    return items;
+}
+
+static QByteArray jsonPage(const QVector<FixtureRow> &rows)
+{
+    QJsonObject page;
+    page["items"] = jsonItems(rows);
+    page["nextCursor"] = QStringLiteral("1735000000000|99999");
+    page["prevCursor"] = QJsonValue();
+    return QJsonDocument(page).toJson(QJsonDocument::Compact);
+}
+
+// CBOR as backend/cbor.js sends it: tag 4 decimal fractions, tag 1 epoch seconds
+static void writeCborRow(QCborStreamWriter &w, const FixtureRow &r)
+{
+    w.startMap(4);
+    w.append(QLatin1String("id"));
+    w.append(r.id);
+    w.append(QLatin1String("tx_type"));
+    w.append(QLatin1String(r.type));
+    w.append(QLatin1String("amount"));
+    w.append(QCborTag(4));
+    w.startArray(2);
+    w.append(qint64(-2));
+    w.append(r.cents);
+    w.endArray();
+    w.append(QLatin1String("created_at"));
+    w.append(QCborTag(1));
+    w.append(r.createdMs / 1000);
+    w.endMap();
+}
+
+static QByteArray cborPage(const QVector<FixtureRow> &rows)
+{
+    QByteArray out;
+    QCborStreamWriter w(&out);
+    w.startMap(3);
+    w.append(QLatin1String("items"));
+    w.startArray(rows.size());
+    for (const FixtureRow &r : rows) writeCborRow(w, r);
+    w.endArray();
+    w.append(QLatin1String("nextCursor"));
+    w.append(QLatin1String("1735000000000|99999"));
+    w.append(QLatin1String("prevCursor"));
+    w.append(nullptr);
+    w.endMap();
+    return out;
+}
+
+static QByteArray jsonBalance()
+{
+    return QByteArrayLiteral(R"({"id":1,"account_type":"credit","balance":"-1234.50","credit_limit":"5000.00"})");
+}
+
+static QByteArray cborBalance()
+{
+    QByteArray out;
+    QCborStreamWriter w(&out);
+    w.startMap(4);
+    w.append(QLatin1String("id"));
+    w.append(qint64(1));
+    w.append(QLatin1String("account_type"));
+    w.append(QLatin1String("credit"));
+    for (const auto &[key, cents] : { std::pair<const char *, qint64>{ "balance", -123450 },
+                                      std::pair<const char *, qint64>{ "credit_limit", 500000 } }) {
+        w.append(QLatin1String(key));
+        w.append(QCborTag(4));
+        w.startArray(2);
+        w.append(qint64(-2));
+        w.append(cents);
+        w.endArray();
+    }
+    w.endMap();
+    return out;
+}
+
+// Login reply with a bootstrap for a debit+credit card
+static QByteArray jsonLogin()
+{
+    QJsonArray accounts;
+    QJsonArray bootstrapAccounts;
+    int accountId = 1;
+    for (const char *role : { "debit", "credit" }) {
+        QJsonObject link;
+        link["role"] = QString::fromLatin1(role);
+        link["accountId"] = accountId;
+        accounts.append(link);
+
+        QJsonObject page;
+        page["items"] = jsonItems(fixtureRows(10));
+        page["nextCursor"] = QStringLiteral("1735000000000|99999");
+        page["prevCursor"] = QJsonValue();
+
+        QJsonObject acc = link;
+        acc["balance"] = QJsonDocument::fromJson(jsonBalance()).object();
+        acc["transactions"] = page;
+        bootstrapAccounts.append(acc);
+        ++accountId;
+    }
+
+    QJsonObject customer;
+    customer["id"] = 1;
+    customer["image_filename"] = QStringLiteral("1700000000000-123456789.jpg");
+
+    QJsonObject bootstrap;
+    bootstrap["accounts"] = bootstrapAccounts;
+    bootstrap["customer"] = customer;
+
+    QJsonObject reply;
+    reply["ok"] = true;
+    reply["accounts"] = accounts;
+    reply["bootstrap"] = bootstrap;
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+// Same reply as CBOR (untagged: the login route sends no DECIMAL/DATETIME at top level)
+static QByteArray cborLogin()
+{
+    return QCborValue::fromJsonValue(QJsonDocument::fromJson(jsonLogin()).object()).toCbor();
+}
+
+static QByteArray encodeImage(const QImage &image, const char *format, int quality)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, format);
+    writer.setQuality(quality);
+    writer.write(image);
+    return bytes;
+}
+
+class ClientBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // ApiClient response decoding (QJsonDocument vs CborDecoder vs typed ReplyDecoder)
+    void decodeLogin_data();
+    void decodeLogin();
+    void decodeBalance_data();
+    void decodeBalance();
+    void decodeTransactionsPage_data();
+    void decodeTransactionsPage();
+
+    // Transactions tab: what updateTransactionsUi does (clear + append), view attached
+    void transactionsModelAppend_data();
+    void transactionsModelAppend();
+
+    // Per-row created_at handling
+    void parseDate_data();
+    void parseDate();
+
+    // Row fields as the model needs them: QJsonObject lookups vs typed Transaction
+    void rowFields_data();
+    void rowFields();
+
+    // Customer photo: scaled decode vs full decode + QImage::scaled
+    void decodeImage_data();
+    void decodeImage();
+
+private:
+    QByteArray m_largeJpeg;
+    QByteArray m_largePng;
+};
+
+void ClientBench::initTestCase()
+{
+    // A camera-sized photo with enough detail that the codecs have real work to do
+    QImage image(4000, 3000, QImage::Format_RGB32);
+    {
+        QPainter p(&image);
+        QLinearGradient g(0, 0, image.width(), image.height());
+        g.setColorAt(0, QColor(30, 60, 120));
+        g.setColorAt(1, QColor(230, 190, 120));
+        p.fillRect(image.rect(), g);
+        QRandomGenerator rng(42);
+        for (int i = 0; i < 4000; ++i) {
+            p.setPen(QColor::fromRgb(rng.generate()));
+            p.drawEllipse(QPoint(rng.bounded(image.width()), rng.bounded(image.height())),
+                          rng.bounded(5, 80), rng.bounded(5, 80));
+        }
+    }
+    m_largeJpeg = encodeImage(image, "jpeg", 90);
+    m_largePng = encodeImage(image, "png", -1);
+    QVERIFY(!m_largeJpeg.isEmpty());
+    QVERIFY(!m_largePng.isEmpty());
+}
+
+void ClientBench::decodeLogin_data()
+{
+    QTest::addColumn<QByteArray>("raw");
+    QTest::addColumn<bool>("cbor");
+    QTest::addColumn<bool>("typed");
+    QTest::newRow("json") << jsonLogin() << false << false;
+    QTest::newRow("cbor") << cborLogin() << true << false;
+    QTest::newRow("json-typed") << jsonLogin() << false << true;
+    QTest::newRow("cbor-typed") << cborLogin() << true << true;
+}
+
+void ClientBench::decodeLogin()
+{
+    QFETCH(QByteArray, raw);
+    QFETCH(bool, cbor);
+    QFETCH(bool, typed);
+
+    if (typed) {
+        const ReplyDecoder::Format format = cbor ? ReplyDecoder::Format::Cbor : ReplyDecoder::Format::Json;
+        QBENCHMARK {
+            LoginResult result;
+            QVERIFY(ReplyDecoder::decodeLogin(raw, format, &result));
+            QVERIFY(result.preferredAccountId() == 1 && result.bootstrapEnd > result.bootstrapBegin);
+        }
+        return;
+    }
+
+    QBENCHMARK {
+        const QJsonDocument doc = cbor ? CborDecoder::decode(raw) : QJsonDocument::fromJson(raw);
+        const QJsonObject obj = doc.object();
+        int preferredId = -1;
+        const QJsonArray accounts = obj.value("accounts").toArray();
+        for (const auto &v : accounts) {
+            const QJsonObject o = v.toObject();
+            if (o.value("role").toString() == QLatin1String("debit")) {
+                preferredId = o.value("accountId").toInt(-1);
+                break;
+            }
+        }
+        const QJsonObject bootstrap = obj.value("bootstrap").toObject();
+        QVERIFY(preferredId == 1 && !bootstrap.isEmpty());
+    }
+}
+
+void ClientBench::decodeBalance_data()
+{
+    QTest::addColumn<QByteArray>("raw");
+    QTest::addColumn<bool>("cbor");
+    QTest::addColumn<bool>("typed");
+    QTest::newRow("json") << jsonBalance() << false << false;
+    QTest::newRow("cbor") << cborBalance() << true << false;
+    QTest::newRow("json-typed") << jsonBalance() << false << true;
+    QTest::newRow("cbor-typed") << cborBalance() << true << true;
+}
+
+void ClientBench::decodeBalance()
+{
+    QFETCH(QByteArray, raw);
+    QFETCH(bool, cbor);
+    QFETCH(bool, typed);
+
+    if (typed) {
+        const ReplyDecoder::Format format = cbor ? ReplyDecoder::Format::Cbor : ReplyDecoder::Format::Json;
+        QBENCHMARK {
+            Balance balance;
+            QVERIFY(ReplyDecoder::decodeBalance(raw, format, &balance));
+            QCOMPARE(balance.balanceCents, qint64(-123450));
+        }
+        return;
+    }
+
+    QBENCHMARK {
+        const QJsonDocument doc = cbor ? CborDecoder::decode(raw) : QJsonDocument::fromJson(raw);
+        const QString balance = doc.object().value("balance").toVariant().toString();
+        QVERIFY(balance == QLatin1String("-1234.50"));
+    }
+}
+
+void ClientBench::decodeTransactionsPage_data()
+{
+    QTest::addColumn<QByteArray>("raw");
+    QTest::addColumn<bool>("cbor");
+    QTest::addColumn<bool>("typed");
+    QTest::addColumn<int>("rows");
+
+    for (int rows : { 10, 100, 1000 }) {
+        const QVector<FixtureRow> fixture = fixtureRows(rows);
+        const QByteArray json = jsonPage(fixture);
+        const QByteArray cbor = cborPage(fixture);
+        // Payload size in the row tag (json-100-12345B), so the XML keeps it with the timing
+        QTest::addRow("json-%d-%lldB", rows, qint64(json.size())) << json << false << false << rows;
+        QTest::addRow("cbor-%d-%lldB", rows, qint64(cbor.size())) << cbor << true << false << rows;
+        QTest::addRow("json-typed-%d-%lldB", rows, qint64(json.size())) << json << false << true << rows;
+        QTest::addRow("cbor-typed-%d-%lldB", rows, qint64(cbor.size())) << cbor << true << true << rows;
+    }
+}
+
+void ClientBench::decodeTransactionsPage()
+{
+    QFETCH(QByteArray, raw);
+    QFETCH(bool, cbor);
+    QFETCH(bool, typed);
+    QFETCH(int, rows);
+
+    if (typed) {
+        const ReplyDecoder::Format format = cbor ? ReplyDecoder::Format::Cbor : ReplyDecoder::Format::Json;
+        QBENCHMARK {
+            TransactionsPage page;
+            QVERIFY(ReplyDecoder::decodeTransactionsPage(raw, format, &page));
+            QCOMPARE(page.items.size(), rows);
+        }
+        return;
+    }
+
+    QBENCHMARK {
+        const QJsonDocument doc = cbor ? CborDecoder::decode(raw) : QJsonDocument::fromJson(raw);
+        QCOMPARE(doc.object().value("items").toArray().size(), rows);
+    }
+}
+
+void ClientBench::transactionsModelAppend_data()
+{
+    QTest::addColumn<QJsonArray>("items");
+    QTest::newRow("10") << jsonItems(fixtureRows(10));
+    QTest::newRow("100") << jsonItems(fixtureRows(100));
+    QTest::newRow("10000") << jsonItems(fixtureRows(10000));
+}
+
+void ClientBench::transactionsModelAppend()
+{
+    QFETCH(QJsonArray, items);
+
+    TransactionsModel model;
+    QTableView view;
+    view.setModel(&model);
+    view.verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    QBENCHMARK {
+        model.clear();
+        model.appendPage(items, QString());
+    }
+    QCOMPARE(model.rowCount(), items.size());
+}
+
+void ClientBench::parseDate_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::newRow("iso-string") << 0;      // JSON: "2025-01-01T10:00:00.000Z"
+    QTest::newRow("sql-fallback") << 1;    // "2025-01-01 10:00:00": ISODate fails, then custom format
+    QTest::newRow("epoch-ms") << 2;        // CBOR tag 1 -> epoch ms
+    QTest::newRow("iso-typed") << 3;       // ReplyDecoder::parseTimestamp + LocaleFormatter
+}
+
+void ClientBench::parseDate()
+{
+    QFETCH(int, kind);
+
+    static constexpr int ROWS = 1000;
+    QVector<QString> strings;
+    QVector<qint64> epochs;
+    for (const FixtureRow &r : fixtureRows(ROWS)) {
+        const QDateTime dt = QDateTime::fromMSecsSinceEpoch(r.createdMs, Qt::UTC);
+        strings.append(kind == 1 ? dt.toString("yyyy-MM-dd HH:mm:ss") : dt.toString(Qt::ISODateWithMs));
+        epochs.append(r.createdMs);
+    }
+
+    if (kind == 3) {
+        const LocaleFormatter &format = LocaleFormatter::shared();
+        QBENCHMARK {
+            for (int i = 0; i < ROWS; ++i) {
+                qint64 ms = 0;
+                QVERIFY(ReplyDecoder::parseTimestamp(QStringView(strings.at(i)), &ms));
+                const QString text = format.dateTime(ms);
+                Q_UNUSED(text);
+            }
+        }
+        return;
+    }
+
+    const QLocale locale;
+    QBENCHMARK {
+        for (int i = 0; i < ROWS; ++i) {
+            QDateTime dt;
+            if (kind == 2) {
+                dt = QDateTime::fromMSecsSinceEpoch(epochs.at(i));
+            } else {
+                dt = QDateTime::fromString(strings.at(i), Qt::ISODate);
+                if (!dt.isValid()) dt = QDateTime::fromString(strings.at(i), "yyyy-MM-dd HH:mm:ss");
+            }
+            const QString text = locale.toString(dt.toLocalTime(), QLocale::ShortFormat);
+            Q_UNUSED(text);
+        }
+    }
+}
+
+void ClientBench::rowFields_data()
+{
+    QTest::addColumn<bool>("typed");
+    QTest::newRow("qjson-lookups") << false;
+    QTest::newRow("typed") << true;
+}
+
+void ClientBench::rowFields()
+{
+    QFETCH(bool, typed);
+
+    static constexpr int ROWS = 1000;
+    const QJsonArray items = jsonItems(fixtureRows(ROWS));
+
+    if (typed) {
+        const LocaleFormatter &format = LocaleFormatter::shared();
+        QBENCHMARK {
+            for (const auto &v : items) {
+                const Transaction tx = ReplyDecoder::transaction(v.toObject());
+                const QString date = format.dateTime(tx.createdMs);
+                const QString amount = ReplyDecoder::decimalText(tx.amountCents);
+                QVERIFY(tx.id > 0 && !date.isEmpty() && !amount.isEmpty());
+            }
+        }
+        return;
+    }
+
+    // What the model did before: string lookups, two date formats, amount via QVariant
+    const QLocale locale;
+    QBENCHMARK {
+        for (const auto &v : items) {
+            const QJsonObject obj = v.toObject();
+            const QString createdAt = obj.value("created_at").toString();
+            QDateTime dt = QDateTime::fromString(createdAt, Qt::ISODate);
+            if (!dt.isValid()) dt = QDateTime::fromString(createdAt, "yyyy-MM-dd HH:mm:ss");
+            const QString date = locale.toString(dt.toLocalTime(), QLocale::ShortFormat);
+            const QString amount = obj.value("amount").toVariant().toString();
+            QVERIFY(obj.value("id").toInteger() > 0 && !date.isEmpty() && !amount.isEmpty());
+        }
+    }
+}
+
+void ClientBench::decodeImage_data()
+{
+    QTest::addColumn<QByteArray>("encoded");
+    QTest::addColumn<bool>("scaledDecode");
+
+    QTest::newRow("jpeg-scaled-decode") << m_largeJpeg << true;
+    QTest::newRow("jpeg-full-then-scale") << m_largeJpeg << false;
+    QTest::newRow("png-scaled-decode") << m_largePng << true;
+    QTest::newRow("png-full-then-scale") << m_largePng << false;
+}
+
+void ClientBench::decodeImage()
+{
+    QFETCH(QByteArray, encoded);
+    QFETCH(bool, scaledDecode);
+
+    // Image label size on a 1080p kiosk
+    const QSize target(480, 360);
+
+    QBENCHMARK {
+        QImage image;
+        if (scaledDecode) {
+            image = ImageLoader::decodeScaled(encoded, target);
+        } else {
+            // What the label did before: decode everything, then scale smoothly
+            image = QImage::fromData(encoded).scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        QVERIFY(!image.isNull());
+    }
+}
+
+QTEST_MAIN(ClientBench)
+#include "ClientBench.moc"
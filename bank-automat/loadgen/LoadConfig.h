@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Settings of one bank-automat-loadgen run (command line -> main.cpp)
+struct LoadConfig
+{
+    QString baseUrl = QStringLiteral("http://localhost:3000");
+
+    int sessions = 10;          // concurrent virtual ATMs, each with its own ApiClient
+    int durationSec = 60;       // stop starting new customers after this
+    int iterations = 0;         // customers per ATM (0 = until duration)
+    int rampUpMs = 0;           // ATM start times spread over this window
+
+    int thinkMinMs = 500;       // pause between steps, uniform in [min, max]
+    int thinkMaxMs = 2000;
+
+    // Which card a customer uses: cards[i] with probability ~ 1 / (i + 1)^zipf
+    // (0 = uniform). hotShare of customers use cards[0] regardless: with withdrawals
+    // serialised per account (SELECT ... FOR UPDATE) this measures row lock contention.
+    QStringList cards = { QStringLiteral("11111111"), QStringLiteral("22222222"), QStringLiteral("33333333") };
+    QString pin = QStringLiteral("1234");
+    double zipf = 0;
+    double hotShare = 0;
+
+    double creditShare = 0.5;   // cards with debit + credit: share of customers choosing credit
+    QVector<int> amounts = { 20 };
+    int pages = 3;              // transactions pages read per customer (first + older)
+    int pageSize = 10;
+
+    bool preferCbor = true;
+    int readAttempts = 1;       // ApiClient retry policy for balance and transactions GETs
+    bool hedgeReads = false;
+    quint32 seed = 1;
+};
@@ -0,0 +1,115 @@
+#include "LoadStats.h"
+
+#include <QJsonArray>
+#include <QStringList>
+#include <algorithm>
+
+static const double REPORTED_QUANTILES[] = { 0.5, 0.95, 0.99 };
+
+void LoadStats::record(Step step, qint64 micros, Outcome outcome)
+{
+    if (step < 0 || step >= StepCount) return;
+    StepStats &s = m_steps[step];
+    switch (outcome) {
+    case Outcome::Ok:
+        ++s.ok;
+        s.latency.record(micros);
+        break;
+    case Outcome::Rejected:
+        ++s.rejected;
+        s.latency.record(micros);
+        break;
+    case Outcome::Failed:
+        ++s.failed;
+        break;
+    }
+}
+
+void LoadStats::recordError(Step step, const QString &error)
+{
+    if (step < 0 || step >= StepCount) return;
+    ++m_steps[step].errors[error.isEmpty() ? QStringLiteral("(no message)") : error];
+}
+
+const char *LoadStats::stepName(Step step)
+{
+    switch (step) {
+    case Login:            return "login";
+    case Balance:          return "balance";
+    case Withdraw:         return "withdraw";
+    case TransactionsPage: return "transactions_page";
+    case Customer:         return "customer";
+    default:               return "unknown";
+    }
+}
+
+static QByteArray ms(qint64 micros)
+{
+    return QByteArray::number(double(micros) / 1000.0, 'f', 1);
+}
+
+QByteArray LoadStats::report(double elapsedSec) const
+{
+    QByteArray out;
+    out += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg("step", -18).arg("ok", 8).arg("rejected", 9).arg("failed", 7).arg("per s", 8)
+               .arg("p50 ms", 9).arg("p95 ms", 9).arg("p99 ms", 9).arg("max ms", 9)
+               .toUtf8();
+
+    for (int i = 0; i < StepCount; ++i) {
+        const StepStats &s = m_steps[i];
+        const double rate = elapsedSec > 0 ? double(s.ok + s.rejected) / elapsedSec : 0;
+        out += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                   .arg(QString::fromLatin1(stepName(Step(i))), -18)
+                   .arg(s.ok, 8).arg(s.rejected, 9).arg(s.failed, 7)
+                   .arg(rate, 8, 'f', 1)
+                   .arg(QString::fromLatin1(ms(s.latency.quantileMicros(0.5))), 9)
+                   .arg(QString::fromLatin1(ms(s.latency.quantileMicros(0.95))), 9)
+                   .arg(QString::fromLatin1(ms(s.latency.quantileMicros(0.99))), 9)
+                   .arg(QString::fromLatin1(ms(s.latency.maxMicros())), 9)
+                   .toUtf8();
+    }
+
+    // Most frequent error messages per step
+    for (int i = 0; i < StepCount; ++i) {
+        const auto &errors = m_steps[i].errors;
+        if (errors.isEmpty()) continue;
+
+        QVector<QPair<quint64, QString>> sorted;
+        for (auto it = errors.cbegin(); it != errors.cend(); ++it) sorted.append({ it.value(), it.key() });
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+        out += QByteArray("\n") + stepName(Step(i)) + " errors:\n";
+        for (int e = 0; e < qMin(5, int(sorted.size())); ++e) {
+            out += "  " + QByteArray::number(sorted.at(e).first) + "  " + sorted.at(e).second.toUtf8() + "\n";
+        }
+    }
+    return out;
+}
+
+QJsonObject LoadStats::toJson(double elapsedSec) const
+{
+    QJsonObject steps;
+    for (int i = 0; i < StepCount; ++i) {
+        const StepStats &s = m_steps[i];
+
+        QJsonObject quantiles;
+        for (double q : REPORTED_QUANTILES) {
+            quantiles[QString("p%1").arg(q * 100)] = double(s.latency.quantileMicros(q)) / 1000.0;
+        }
+        quantiles["max"] = double(s.latency.maxMicros()) / 1000.0;
+
+        QJsonObject errors;
+        for (auto it = s.errors.cbegin(); it != s.errors.cend(); ++it) errors[it.key()] = qint64(it.value());
+
+        steps[QString::fromLatin1(stepName(Step(i)))] = QJsonObject{
+            { "ok", qint64(s.ok) },
+            { "rejected", qint64(s.rejected) },
+            { "failed", qint64(s.failed) },
+            { "perSecond", elapsedSec > 0 ? double(s.ok + s.rejected) / elapsedSec : 0.0 },
+            { "latencyMs", quantiles },
+            { "errors", errors },
+        };
+    }
+    return QJsonObject{ { "elapsedSec", elapsedSec }, { "steps", steps } };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+
+#include "RequestMetrics.h"
+
+// Step latencies of all virtual ATMs of a run (single-threaded, no locking)
+class LoadStats
+{
+public:
+    enum Step { Login = 0, Balance, Withdraw, TransactionsPage, Customer, StepCount };
+
+    // Rejected = the backend said no for a business reason (insufficient funds, credit
+    // limit): a valid answer, timed like a success but counted apart from failures
+    enum class Outcome { Ok, Rejected, Failed };
+
+    // Latency is kept for Ok and Rejected; failures (transport, 5xx, timeouts) are only counted
+    void record(Step step, qint64 micros, Outcome outcome);
+    void recordError(Step step, const QString& error);
+
+    // Fixed-width table: count, throughput, failures, p50/p95/p99/max per step
+    QByteArray report(double elapsedSec) const;
+    QJsonObject toJson(double elapsedSec) const;
+
+    static const char* stepName(Step step);
+
+private:
+    struct StepStats {
+        LatencyHistogram latency;
+        quint64 ok = 0;
+        quint64 rejected = 0;
+        quint64 failed = 0;
+        QHash<QString, quint64> errors; // message -> count
+    };
+    StepStats m_steps[StepCount];
+};
@@ -0,0 +1,183 @@
+#include "VirtualAtm.h"
+
+#include <QJsonObject>
+#include <QTimer>
+#include <QtMath>
+
+// Business refusals are answers, not failures
+static bool isRefusal(const QString &error)
+{
+    return error == QLatin1String("Insufficient funds") || error == QLatin1String("Credit limit exceeded");
+}
+
+VirtualAtm::VirtualAtm(int index, const LoadConfig &config, LoadStats *stats, QObject *parent)
+    : QObject(parent),
+      m_config(config),
+      m_stats(stats),
+      m_rng(config.seed + quint32(index) * 7919u) // per-ATM stream: same run, same customers
+{
+    m_api.setBaseUrl(config.baseUrl);
+    m_api.setPreferCbor(config.preferCbor);
+
+    ApiClient::RetryPolicy reads;
+    reads.maxAttempts = config.readAttempts;
+    reads.hedge = config.hedgeReads;
+    m_api.setRetryPolicy("/accounts/:id/balance", reads);
+    m_api.setRetryPolicy("/accounts/:id/transactions", reads);
+
+    connect(&m_api, &ApiClient::loginAccountsResult, this, &VirtualAtm::onLogin);
+}
+
+void VirtualAtm::start(int delayMs)
+{
+    QTimer::singleShot(delayMs, this, &VirtualAtm::nextCustomer);
+}
+
+void VirtualAtm::stop()
+{
+    m_stopping = true;
+}
+
+void VirtualAtm::nextCustomer()
+{
+    if (m_done) return;
+    if (m_stopping || (m_config.iterations > 0 && m_customersServed >= m_config.iterations)) {
+        m_done = true;
+        emit finished();
+        return;
+    }
+
+    m_accountId = -1;
+    m_pagesRead = 0;
+    m_before.clear();
+    m_customerClock.start();
+    m_stepClock.start();
+    m_api.login(pickCard(), m_config.pin);
+}
+
+QString VirtualAtm::pickCard()
+{
+    const QStringList &cards = m_config.cards;
+    if (cards.size() == 1 || m_rng.generateDouble() < m_config.hotShare) return cards.first();
+
+    // Zipf over the card list (s = 0 is uniform)
+    double total = 0;
+    for (int i = 0; i < cards.size(); ++i) total += 1.0 / qPow(i + 1, m_config.zipf);
+    double pick = m_rng.generateDouble() * total;
+    for (int i = 0; i < cards.size(); ++i) {
+        pick -= 1.0 / qPow(i + 1, m_config.zipf);
+        if (pick <= 0) return cards.at(i);
+    }
+    return cards.last();
+}
+
+void VirtualAtm::finishStep(LoadStats::Step step, bool ok, const QString &error)
+{
+    const qint64 micros = m_stepClock.nsecsElapsed() / 1000;
+
+    LoadStats::Outcome outcome = LoadStats::Outcome::Ok;
+    if (!ok) {
+        outcome = isRefusal(error) ? LoadStats::Outcome::Rejected : LoadStats::Outcome::Failed;
+        m_stats->recordError(step, error);
+    }
+    m_stats->record(step, micros, outcome);
+}
+
+int VirtualAtm::thinkMs()
+{
+    const int lo = qMax(0, m_config.thinkMinMs);
+    const int hi = qMax(lo, m_config.thinkMaxMs);
+    return hi > lo ? int(m_rng.bounded(lo, hi + 1)) : lo;
+}
+
+void VirtualAtm::think(void (VirtualAtm::*next)())
+{
+    QTimer::singleShot(thinkMs(), this, [this, next]() {
+        m_stepClock.start();
+        (this->*next)();
+    });
+}
+
+void VirtualAtm::onLogin(bool ok, const QJsonArray &accounts, const QString &error)
+{
+    finishStep(LoadStats::Login, ok, error);
+    if (!ok) {
+        endCustomer(false);
+        return;
+    }
+
+    // Role choice, as on the dual-card screen
+    QString wanted = QStringLiteral("debit");
+    if (accounts.size() > 1 && m_rng.generateDouble() < m_config.creditShare) wanted = QStringLiteral("credit");
+    m_accountId = accounts.at(0).toObject().value("accountId").toInt(-1);
+    for (const auto &v : accounts) {
+        const QJsonObject o = v.toObject();
+        if (o.value("role").toString() == wanted) {
+            m_accountId = o.value("accountId").toInt(-1);
+            break;
+        }
+    }
+
+    think(&VirtualAtm::requestBalance);
+}
+
+void VirtualAtm::requestBalance()
+{
+    m_api.getBalance(m_accountId, this, [this](bool ok, Balance, QString error) {
+        finishStep(LoadStats::Balance, ok, error);
+        if (!ok) {
+            endCustomer(false);
+            return;
+        }
+        think(&VirtualAtm::requestWithdraw);
+    });
+}
+
+void VirtualAtm::requestWithdraw()
+{
+    const QVector<int> &amounts = m_config.amounts;
+    const int amount = amounts.at(m_rng.bounded(int(amounts.size())));
+
+    m_api.withdraw(m_accountId, amount, this, [this](bool ok, QJsonObject, QString error) {
+        finishStep(LoadStats::Withdraw, ok, error);
+        // A refused withdrawal still leaves the customer at the ATM
+        if (!ok && !isRefusal(error)) {
+            endCustomer(false);
+            return;
+        }
+        if (m_config.pages <= 0) {
+            endCustomer(true);
+            return;
+        }
+        think(&VirtualAtm::requestPage);
+    });
+}
+
+void VirtualAtm::requestPage()
+{
+    m_api.fetchTransactionsPage(m_accountId, m_config.pageSize, m_before, QString(), this,
+                                [this](bool ok, TransactionsPage page, QString error) {
+        finishStep(LoadStats::TransactionsPage, ok, error);
+        if (!ok) {
+            endCustomer(false);
+            return;
+        }
+        ++m_pagesRead;
+        m_before = page.nextCursor;
+        if (m_pagesRead >= m_config.pages || m_before.isEmpty()) {
+            endCustomer(true);
+            return;
+        }
+        think(&VirtualAtm::requestPage);
+    });
+}
+
+void VirtualAtm::endCustomer(bool completed)
+{
+    m_stats->record(LoadStats::Customer, m_customerClock.nsecsElapsed() / 1000,
+                    completed ? LoadStats::Outcome::Ok : LoadStats::Outcome::Failed);
+    ++m_customersServed;
+
+    // Next customer walks up after a pause (not timed)
+    QTimer::singleShot(thinkMs(), this, &VirtualAtm::nextCustomer);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QObject>
+#include <QRandomGenerator>
+
+#include "ApiClient.h"
+#include "LoadConfig.h"
+#include "LoadStats.h"
+
+// One kiosk: its own ApiClient (own connection pool and response cache, like a real ATM)
+// serving customers one after another:
+//   login -> role choice (debit+credit cards) -> balance -> withdraw -> transaction pages
+// with think time between steps. A failed step ends that customer; the next one starts.
+class VirtualAtm : public QObject
+{
+    Q_OBJECT
+public:
+    VirtualAtm(int index, const LoadConfig& config, LoadStats* stats, QObject* parent = nullptr);
+
+    void start(int delayMs);
+    // Finish the current customer, then emit finished()
+    void stop();
+
+    int customersServed() const { return m_customersServed; }
+    const RequestMetrics& metrics() const { return m_api.metrics(); }
+
+signals:
+    void finished();
+
+private:
+    const LoadConfig& m_config;
+    LoadStats* m_stats;
+    ApiClient m_api;
+    QRandomGenerator m_rng;
+
+    bool m_stopping = false;
+    bool m_done = false;
+    int m_customersServed = 0;
+
+    int m_accountId = -1;
+    int m_pagesRead = 0;
+    QString m_before;               // cursor of the next older page
+    QElapsedTimer m_customerClock;
+    QElapsedTimer m_stepClock;
+
+    void nextCustomer();
+    void onLogin(bool ok, const QJsonArray& accounts, const QString& error);
+    void requestBalance();
+    void requestWithdraw();
+    void requestPage();
+    void endCustomer(bool completed);
+
+    // Pause for a think time, then run `next` as a new timed step
+    void think(void (VirtualAtm::*next)());
+    int thinkMs();
+    QString pickCard();
+    void finishStep(LoadStats::Step step, bool ok, const QString& error);
+};
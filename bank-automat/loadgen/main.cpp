@@ -0,0 +1,153 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTimer>
+#include <cstdio>
+
+#include "LoadConfig.h"
+#include "LoadStats.h"
+#include "VirtualAtm.h"
+
+// bank-automat-loadgen: N virtual ATMs through ApiClient, no widgets.
+//   bank-automat-loadgen --url http://127.0.0.1:3000 --sessions 50 --duration 120
+//   bank-automat-loadgen --sessions 20 --hot-share 0.8 --think 0,0     (row lock contention)
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bank-automat-loadgen");
+
+    LoadConfig config;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Drives concurrent virtual ATM sessions against the bank-automat backend.");
+    parser.addHelpOption();
+
+    QCommandLineOption urlOption("url", "Backend base URL.", "url", config.baseUrl);
+    QCommandLineOption sessionsOption({ "n", "sessions" }, "Concurrent virtual ATMs.", "n", QString::number(config.sessions));
+    QCommandLineOption durationOption({ "d", "duration" }, "Seconds to keep starting customers.", "s", QString::number(config.durationSec));
+    QCommandLineOption iterationsOption("iterations", "Customers per ATM (0 = until duration).", "n", "0");
+    QCommandLineOption rampOption("ramp-up", "Spread ATM starts over this many ms.", "ms", "0");
+    QCommandLineOption thinkOption("think", "Think time between steps, min,max ms.", "min,max",
+                                   QString("%1,%2").arg(config.thinkMinMs).arg(config.thinkMaxMs));
+    QCommandLineOption cardsOption("cards", "Comma-separated card numbers (first = hot card).", "list", config.cards.join(','));
+    QCommandLineOption pinOption("pin", "PIN for every card.", "pin", config.pin);
+    QCommandLineOption zipfOption("zipf", "Card popularity skew (0 = uniform).", "s", "0");
+    QCommandLineOption hotOption("hot-share", "Share of customers forced onto the first card (contention).", "0..1", "0");
+    QCommandLineOption creditOption("credit-share", "Share of dual-card customers choosing credit.", "0..1", "0.5");
+    QCommandLineOption amountsOption("amounts", "Comma-separated withdrawal amounts (picked uniformly).", "list", "20");
+    QCommandLineOption pagesOption("pages", "Transaction pages read per customer.", "n", QString::number(config.pages));
+    QCommandLineOption pageSizeOption("page-size", "Rows per transactions page.", "n", QString::number(config.pageSize));
+    QCommandLineOption jsonWireOption("json-wire", "Ask for JSON instead of CBOR.");
+    QCommandLineOption attemptsOption("read-attempts", "Attempts per balance/transactions GET (1 = no retries).", "n", "1");
+    QCommandLineOption hedgeOption("hedge", "Hedge balance/transactions GETs after their p95.");
+    QCommandLineOption seedOption("seed", "Seed for card choice, amounts and think times.", "n", "1");
+    QCommandLineOption reportOption({ "o", "report" }, "Also write the report as JSON to this file.", "file");
+    parser.addOptions({ urlOption, sessionsOption, durationOption, iterationsOption, rampOption, thinkOption,
+                        cardsOption, pinOption, zipfOption, hotOption, creditOption, amountsOption,
+                        pagesOption, pageSizeOption, jsonWireOption, attemptsOption, hedgeOption,
+                        seedOption, reportOption });
+    parser.process(app);
+
+    config.baseUrl = parser.value(urlOption);
+    config.sessions = qMax(1, parser.value(sessionsOption).toInt());
+    config.durationSec = qMax(0, parser.value(durationOption).toInt());
+    config.iterations = qMax(0, parser.value(iterationsOption).toInt());
+    config.rampUpMs = qMax(0, parser.value(rampOption).toInt());
+    const QStringList think = parser.value(thinkOption).split(',');
+    config.thinkMinMs = think.value(0).toInt();
+    config.thinkMaxMs = think.value(1, think.value(0)).toInt();
+    config.cards = parser.value(cardsOption).split(',', Qt::SkipEmptyParts);
+    config.pin = parser.value(pinOption);
+    config.zipf = qMax(0.0, parser.value(zipfOption).toDouble());
+    config.hotShare = qBound(0.0, parser.value(hotOption).toDouble(), 1.0);
+    config.creditShare = qBound(0.0, parser.value(creditOption).toDouble(), 1.0);
+    config.amounts.clear();
+    for (const QString &a : parser.value(amountsOption).split(',', Qt::SkipEmptyParts)) {
+        if (a.toInt() > 0) config.amounts.append(a.toInt());
+    }
+    config.pages = qMax(0, parser.value(pagesOption).toInt());
+    config.pageSize = qBound(1, parser.value(pageSizeOption).toInt(), 100);
+    config.preferCbor = !parser.isSet(jsonWireOption);
+    config.readAttempts = qMax(1, parser.value(attemptsOption).toInt());
+    config.hedgeReads = parser.isSet(hedgeOption);
+    config.seed = parser.value(seedOption).toUInt();
+
+    if (config.cards.isEmpty() || config.amounts.isEmpty()) {
+        std::fprintf(stderr, "--cards and --amounts need at least one value\n");
+        return 1;
+    }
+    if (config.durationSec == 0 && config.iterations == 0) {
+        std::fprintf(stderr, "Give --duration or --iterations\n");
+        return 1;
+    }
+
+    LoadStats stats;
+    QVector<VirtualAtm *> atms;
+    int running = config.sessions;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const auto finish = [&]() {
+        const double seconds = double(elapsed.nsecsElapsed()) / 1e9;
+        std::fputs(stats.report(seconds).constData(), stdout);
+
+        // Extra load the retry policy put on the backend
+        const auto extraTotal = [&atms](RequestMetrics::Counter c) {
+            qint64 total = 0;
+            for (const VirtualAtm *atm : atms) total += qint64(atm->metrics().counterTotal(c));
+            return total;
+        };
+        const QJsonObject extra{
+            { "retries", extraTotal(RequestMetrics::Retries) },
+            { "hedges", extraTotal(RequestMetrics::Hedges) },
+            { "hedgeWins", extraTotal(RequestMetrics::HedgeWins) },
+            { "budgetDenied", extraTotal(RequestMetrics::BudgetDenied) },
+        };
+        std::printf("\nretries %lld  hedges %lld (won %lld)  refused by budget %lld\n",
+                    extra["retries"].toInteger(), extra["hedges"].toInteger(),
+                    extra["hedgeWins"].toInteger(), extra["budgetDenied"].toInteger());
+
+        if (parser.isSet(reportOption)) {
+            QJsonObject report = stats.toJson(seconds);
+            report["extraAttempts"] = extra;
+            report["sessions"] = config.sessions;
+            report["url"] = config.baseUrl;
+            report["seed"] = qint64(config.seed);
+            QFile f(parser.value(reportOption));
+            if (f.open(QIODevice::WriteOnly)) f.write(QJsonDocument(report).toJson());
+            else std::fprintf(stderr, "Cannot write %s\n", qPrintable(f.fileName()));
+        }
+        app.quit();
+    };
+
+    for (int i = 0; i < config.sessions; ++i) {
+        VirtualAtm *atm = new VirtualAtm(i, config, &stats, &app);
+        QObject::connect(atm, &VirtualAtm::finished, &app, [&]() {
+            if (--running == 0) finish();
+        });
+        atms.append(atm);
+        atm->start(config.sessions > 1 ? config.rampUpMs * i / (config.sessions - 1) : 0);
+    }
+
+    // Stop starting customers at the deadline; customers already at an ATM finish
+    if (config.durationSec > 0) {
+        QTimer::singleShot(config.durationSec * 1000, &app, [&]() {
+            for (VirtualAtm *atm : atms) atm->stop();
+            std::fprintf(stderr, "Duration reached, waiting for %d ATM(s) to finish their customer...\n", running);
+        });
+    }
+
+    // Progress line every 10 s
+    QTimer progress;
+    QObject::connect(&progress, &QTimer::timeout, &app, [&]() {
+        int customers = 0;
+        for (const VirtualAtm *atm : atms) customers += atm->customersServed();
+        std::fprintf(stderr, "%6.0f s  %d customers  %d ATM(s) running\n",
+                     double(elapsed.elapsed()) / 1000.0, customers, running);
+    });
+    progress.start(10 * 1000);
+
+    return app.exec();
+}
@@ -1,7 +1,13 @@
 #include <QApplication>
+#include <QStandardPaths>
 
+#include "ActivityMonitor.h"
 #include "ApiClient.h"
+#include "CassetteInventory.h"
+#include "ImageLoader.h"
 #include "StartWindow.h"
+#include "TransactionStore.h"
+#include "WithdrawOutbox.h"
 
 int main(int argc, char *argv[])
 {
@@ -9,9 +15,69 @@ int main(int argc, char *argv[])
 
     // One shared API client for the whole app
     ApiClient api;
-    api.setBaseUrl("http://localhost:3000");  // backend base URL
+    // Backend base URL (BANK_AUTOMAT_API_URL overrides, e.g. for bank-automat-standin)
+    api.setBaseUrl(qEnvironmentVariable("BANK_AUTOMAT_API_URL", "http://localhost:3000"));
+    api.setKeepAliveInterval(20 * 1000);      // keep the connection hot between customers
 
-    StartWindow w(&api);
+    // A dropped or slow read is retried / hedged before it reaches the customer as an error
+    ApiClient::RetryPolicy reads;
+    reads.maxAttempts = 3;
+    reads.hedge = true;
+    api.setRetryPolicy("/accounts/:id/balance", reads);
+    api.setRetryPolicy("/accounts/:id/transactions", reads);
+    ApiClient::RetryPolicy bootstrap;         // heavy reply: retry, never hedge
+    bootstrap.maxAttempts = 2;
+    api.setRetryPolicy("/accounts/:id/bootstrap", bootstrap);
+
+    // Request latency histograms for the node_exporter textfile collector
+    // (BANK_AUTOMAT_METRICS_FILE overrides the location, empty disables)
+    const QString metricsFile = qEnvironmentVariableIsSet("BANK_AUTOMAT_METRICS_FILE")
+        ? qEnvironmentVariable("BANK_AUTOMAT_METRICS_FILE")
+        : QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/bank_automat.prom";
+    api.metrics().setDumpFile(metricsFile, 15 * 1000);
+
+    // Withdrawals whose reply was lost (crash, timeout) are settled by idempotency key
+    WithdrawOutbox outbox;
+    QString outboxError;
+    if (outbox.open(&outboxError)) api.setWithdrawOutbox(&outbox);
+    else qWarning("Withdraw outbox disabled: %s", qPrintable(outboxError));
+    QObject::connect(&api, &ApiClient::withdrawalReconciled, &api,
+                     [](const WithdrawOutbox::Entry& e, const QString& state) {
+        // Left in the outbox for the next start; the operator has to look at it meanwhile
+        if (state == QLatin1String("unresolved")) {
+            qCritical("Withdrawal %s (account %d, %d EUR) was not paid out and the bank refused to credit it back",
+                      qPrintable(e.key), e.accountId, e.amount);
+            return;
+        }
+        qWarning("Withdrawal %s (account %d, %d EUR) settled after a lost reply: %s",
+                 qPrintable(e.key), e.accountId, e.amount, qPrintable(state));
+    });
+    api.reconcileWithdrawals();
+
+    // Customer photos: decoded off the GUI thread, cached in memory for the session, on disk across sessions
+    ImageLoader images(&api);
+
+    // Recent transactions per account (AppLocalDataLocation), shown before the network answers
+    TransactionStore txStore;
+    QString txStoreError;
+    if (!txStore.open(&txStoreError)) qWarning("Transaction store disabled: %s", qPrintable(txStoreError));
+
+    // Inactivity timeouts of the login dialog and the main window; idle on the attract screen
+    ActivityMonitor activity;
+
+    // Notes in the cassettes as loaded at replenishment (BANK_AUTOMAT_CASSETTES="50:400,20:800"),
+    // counted down per withdrawal and kept across restarts (AppLocalDataLocation): amounts the
+    // machine cannot pay are refused before the bank
+    CassetteInventory cassettes;
+    QString cassetteError;
+    if (!cassettes.open(&cassetteError)) qWarning("Saved cassette counts ignored: %s", qPrintable(cassetteError));
+    // A spec other than the one the saved counts came from is a replenishment
+    const QString cassetteSpec = qEnvironmentVariable("BANK_AUTOMAT_CASSETTES");
+    if (!cassetteSpec.isEmpty() && cassetteSpec != cassettes.spec() && !cassettes.load(cassetteSpec, &cassetteError)) {
+        qWarning("BANK_AUTOMAT_CASSETTES ignored: %s", qPrintable(cassetteError));
+    }
+
+    StartWindow w(&api, &images, &txStore, &activity, &cassettes);
     w.show();
 
     return a.exec();
@@ -0,0 +1,125 @@
+#include "FaultPlan.h"
+
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QtMath>
+
+int RouteFaults::sampleLatencyMs(QRandomGenerator &rng) const
+{
+    double ms = 0;
+    switch (latency) {
+    case Latency::None:
+        return 0;
+    case Latency::Fixed:
+        ms = latencyA;
+        break;
+    case Latency::Uniform:
+        ms = latencyA + rng.generateDouble() * (latencyB - latencyA);
+        break;
+    case Latency::LogNormal: {
+        // Box-Muller: one standard normal sample from two uniforms
+        const double u1 = 1.0 - rng.generateDouble(); // (0, 1], log() stays finite
+        const double u2 = rng.generateDouble();
+        const double z = qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2);
+        ms = latencyA * qExp(latencyB * z);
+        break;
+    }
+    }
+    return int(qBound(0.0, ms, latencyMaxMs));
+}
+
+static bool readRate(const QJsonObject &json, const char *key, double *out, QString *error)
+{
+    if (!json.contains(key)) return true;
+    const double v = json.value(key).toDouble(-1);
+    if (v < 0 || v > 1) {
+        if (error) *error = QString("%1 must be between 0 and 1").arg(key);
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+bool FaultPlan::parseRoute(const QJsonObject &json, RouteFaults *out, QString *error)
+{
+    if (json.contains("latency")) {
+        const QJsonObject lat = json.value("latency").toObject();
+        if (lat.contains("fixed")) {
+            out->latency = RouteFaults::Latency::Fixed;
+            out->latencyA = lat.value("fixed").toDouble();
+        } else if (lat.contains("uniform")) {
+            const QJsonArray range = lat.value("uniform").toArray();
+            if (range.size() != 2 || range.at(0).toDouble() > range.at(1).toDouble()) {
+                if (error) *error = QStringLiteral("latency.uniform must be [min, max]");
+                return false;
+            }
+            out->latency = RouteFaults::Latency::Uniform;
+            out->latencyA = range.at(0).toDouble();
+            out->latencyB = range.at(1).toDouble();
+        } else if (lat.contains("lognormal")) {
+            const QJsonObject ln = lat.value("lognormal").toObject();
+            out->latency = RouteFaults::Latency::LogNormal;
+            out->latencyA = ln.value("median").toDouble();
+            out->latencyB = ln.value("sigma").toDouble(0.5);
+        } else if (!lat.isEmpty()) {
+            if (error) *error = QStringLiteral("latency needs fixed, uniform or lognormal");
+            return false;
+        } else {
+            out->latency = RouteFaults::Latency::None;
+        }
+        if (out->latencyA < 0 || out->latencyB < 0) {
+            if (error) *error = QStringLiteral("latency values must not be negative");
+            return false;
+        }
+        if (lat.contains("maxMs")) out->latencyMaxMs = lat.value("maxMs").toDouble();
+    }
+
+    if (!readRate(json, "errorRate", &out->errorRate, error)) return false;
+    if (json.contains("errorStatus")) {
+        out->errorStatus = json.value("errorStatus").toInt();
+        if (out->errorStatus < 400 || out->errorStatus > 599) {
+            if (error) *error = QStringLiteral("errorStatus must be 4xx or 5xx");
+            return false;
+        }
+    }
+
+    if (json.contains("reset")) {
+        const QJsonObject reset = json.value("reset").toObject();
+        if (!readRate(reset, "rate", &out->resetRate, error)) return false;
+        out->resetAfterBytes = qMax(0, reset.value("afterBytes").toInt(out->resetAfterBytes));
+    }
+
+    if (json.contains("drip")) {
+        const QJsonObject drip = json.value("drip").toObject();
+        out->dripChunkBytes = qMax(0, drip.value("chunkBytes").toInt());
+        out->dripIntervalMs = qMax(0, drip.value("intervalMs").toInt());
+    }
+    return true;
+}
+
+FaultPlan FaultPlan::fromJson(const QJsonObject &json, QString *error)
+{
+    FaultPlan plan;
+    plan.m_json = json;
+    plan.m_seed = quint32(json.value("seed").toInteger(1));
+
+    if (!parseRoute(json.value("default").toObject(), &plan.m_default, error)) return FaultPlan();
+
+    const QJsonObject routes = json.value("routes").toObject();
+    for (auto it = routes.begin(); it != routes.end(); ++it) {
+        RouteFaults route = plan.m_default;
+        QString routeError;
+        if (!parseRoute(it.value().toObject(), &route, &routeError)) {
+            if (error) *error = it.key() + ": " + routeError;
+            return FaultPlan();
+        }
+        plan.m_routes.insert(it.key(), route);
+    }
+    return plan;
+}
+
+const RouteFaults &FaultPlan::forRoute(const QString &route) const
+{
+    const auto it = m_routes.constFind(route);
+    return it != m_routes.constEnd() ? it.value() : m_default;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+
+class QRandomGenerator;
+
+// Network misbehaviour injected by the stand-in backend, per route.
+//
+// JSON form (see standin/faults.example.json):
+//   {
+//     "seed": 42,
+//     "default": { "latency": { "lognormal": { "median": 20, "sigma": 0.5 } } },
+//     "routes": {
+//       "POST /accounts/:id/withdraw": { "errorRate": 0.05, "errorStatus": 503 },
+//       "GET /images/uploads/:file":   { "drip": { "chunkBytes": 1024, "intervalMs": 20 } },
+//       "GET /accounts/:id/transactions": { "reset": { "rate": 0.02, "afterBytes": 200 } }
+//     }
+//   }
+// A route entry overrides only the fields it names; everything else comes from "default".
+//
+// Latency (added before the response starts, milliseconds):
+//   { "fixed": 50 }  { "uniform": [10, 80] }  { "lognormal": { "median": 20, "sigma": 0.5 } }
+//   lognormal is the usual shape of WAN latency: median * exp(sigma * N(0,1)). "maxMs" caps any of them.
+struct RouteFaults
+{
+    enum class Latency { None, Fixed, Uniform, LogNormal };
+
+    Latency latency = Latency::None;
+    double latencyA = 0;     // fixed: ms, uniform: min, lognormal: median
+    double latencyB = 0;     // uniform: max, lognormal: sigma
+    double latencyMaxMs = 60 * 1000;
+
+    double errorRate = 0;    // share of requests answered with errorStatus instead
+    int errorStatus = 503;
+
+    double resetRate = 0;    // share of connections reset (RST) instead of answered
+    int resetAfterBytes = 0; // response bytes written before the reset (0 = before headers)
+
+    int dripChunkBytes = 0;  // > 0: write the response in chunks of this size...
+    int dripIntervalMs = 0;  // ...one every intervalMs
+
+    int sampleLatencyMs(QRandomGenerator& rng) const;
+};
+
+class FaultPlan
+{
+public:
+    // On error: a plan without faults, and error says which field
+    static FaultPlan fromJson(const QJsonObject& json, QString* error = nullptr);
+
+    // route = "METHOD /template", e.g. "GET /accounts/:id/balance"
+    const RouteFaults& forRoute(const QString& route) const;
+
+    quint32 seed() const { return m_seed; }
+    QJsonObject toJson() const { return m_json; }
+
+private:
+    quint32 m_seed = 1;
+    RouteFaults m_default;
+    QHash<QString, RouteFaults> m_routes;
+    QJsonObject m_json;
+
+    static bool parseRoute(const QJsonObject& json, RouteFaults* out, QString* error);
+};
@@ -0,0 +1,536 @@
+#include "StandinBank.h"
+
+#include "DispensePlanner.h"
+
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSet>
+#include <QUrlQuery>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// Clock at startup: history ends here, withdrawals move it on by a second each
+static const qint64 CLOCK_START_MS = 1748779200000; // 2025-06-01 12:00:00 UTC
+static const qint64 ACCOUNTS_CREATED_MS = 1704067200000; // 2024-01-01 00:00:00 UTC
+
+static bool txLess(qint64 ms, qint64 id, qint64 otherMs, qint64 otherId)
+{
+    return ms < otherMs || (ms == otherMs && id < otherId);
+}
+
+// Same plan as computeBills() in backend/routes/accounts.js: fewest 20€ and 50€ notes
+static bool computeBills(qint64 amount, qint64 *fifties, qint64 *twenties)
+{
+    if (amount <= 0 || amount > std::numeric_limits<int>::max()) return false;
+    static constexpr DispensePlanner::Cassettes KIOSK =
+        DispensePlanner::unlimited(DispensePlanner::KIOSK_DENOMINATIONS);
+    const DispensePlanner::Plan plan = DispensePlanner::plan(int(amount), KIOSK);
+    if (!plan.ok) return false;
+    *fifties = DispensePlanner::notesOf(plan, KIOSK, 50);
+    *twenties = DispensePlanner::notesOf(plan, KIOSK, 20);
+    return true;
+}
+
+void StandinBank::reset(quint32 seed, int historyPerAccount)
+{
+    m_customers.clear();
+    m_accounts.clear();
+    m_cards.clear();
+    m_links.clear();
+    m_history.clear();
+    m_withdrawKeys.clear();
+    m_nextTxId = 1;
+    m_clockMs = CLOCK_START_MS;
+
+    // database/02_seed.sql
+    m_customers.insert(3001, { 3001, "Debit", "Only", "Debit Street 1", "debit.jpg" });
+    m_customers.insert(3002, { 3002, "Credit", "Only", "Credit Street 1", QString() });
+    m_customers.insert(3003, { 3003, "Dual", "User", "Dual Street 1", "dual.jpg" });
+
+    m_accounts.insert(2001, { 2001, 3001, "debit", 100000, 0 });
+    m_accounts.insert(2002, { 2002, 3002, "credit", 0, 100000 });
+    m_accounts.insert(2003, { 2003, 3003, "debit", 50000, 0 });
+    m_accounts.insert(2004, { 2004, 3003, "credit", 0, 150000 });
+
+    m_cards.insert("11111111", { "11111111", 1001, "1234", false, 0 });
+    m_cards.insert("22222222", { "22222222", 1002, "1234", false, 0 });
+    m_cards.insert("33333333", { "33333333", 1003, "1234", false, 0 });
+
+    m_links = {
+        { 1001, 2001, "debit" },
+        { 1002, 2002, "credit" },
+        { 1003, 2003, "debit" },
+        { 1003, 2004, "credit" },
+    };
+
+    // Generated history, oldest first, 1..72 h apart (whole seconds like a TIMESTAMP column)
+    static const int WITHDRAW_EUROS[] = { 20, 40, 50, 60, 70, 100, 150, 200 };
+    QRandomGenerator rng(seed);
+    QList<int> accountIds = m_accounts.keys();
+    std::sort(accountIds.begin(), accountIds.end());
+
+    for (int accountId : accountIds) {
+        QVector<qint64> times(historyPerAccount);
+        qint64 t = CLOCK_START_MS;
+        for (int i = historyPerAccount - 1; i >= 0; --i) {
+            t -= qint64(rng.bounded(3600, 72 * 3600)) * 1000;
+            times[i] = t;
+        }
+        for (qint64 createdMs : times) {
+            const int roll = rng.bounded(100);
+            if (roll < 5) {
+                addTx(accountId, createdMs, 0, "balance");
+            } else if (roll < 15) {
+                addTx(accountId, createdMs, qint64(rng.bounded(10, 200)) * 1000, "deposit");
+            } else {
+                addTx(accountId, createdMs, qint64(WITHDRAW_EUROS[rng.bounded(8)]) * 100, "withdrawal");
+            }
+        }
+    }
+
+    // The seed file's own demo rows, newest
+    addTx(2001, CLOCK_START_MS, 2000, "withdrawal");
+    addTx(2001, CLOCK_START_MS, 5000, "withdrawal");
+    addTx(2003, CLOCK_START_MS, 2000, "withdrawal");
+    addTx(2004, CLOCK_START_MS, 0, "balance");
+}
+
+void StandinBank::addTx(int accountId, qint64 createdMs, qint64 cents, const QString &type)
+{
+    m_history[accountId].append({ m_nextTxId++, createdMs, cents, type });
+}
+
+// -------- auth --------
+
+StandinBank::Result StandinBank::login(const QJsonObject &body)
+{
+    const QString cardNumber = body.value("cardNumber").toVariant().toString().trimmed();
+    const QString pin = body.value("pin").toVariant().toString();
+    const bool wantBootstrap = body.value("bootstrap").isBool() && body.value("bootstrap").toBool();
+
+    if (cardNumber.isEmpty() || pin.isEmpty()) return error(400, "cardNumber and pin required");
+
+    auto it = m_cards.find(cardNumber);
+    if (it == m_cards.end()) {
+        return { 401, QJsonObject{ { "ok", false }, { "error", "Invalid credentials" } } };
+    }
+
+    Card &card = it.value();
+    if (card.locked) return error(403, "Card locked");
+
+    if (pin != card.pin) {
+        ++card.failedAttempts;
+        if (card.failedAttempts >= MAX_PIN_ATTEMPTS) {
+            card.locked = true;
+            return error(403, "Card locked (too many attempts)");
+        }
+        return { 401, QJsonObject{ { "ok", false }, { "attemptsLeft", MAX_PIN_ATTEMPTS - card.failedAttempts } } };
+    }
+    card.failedAttempts = 0;
+
+    QVector<Link> links;
+    QJsonArray accounts;
+    for (const Link &l : m_links) {
+        if (l.cardId != card.id) continue;
+        links.append(l);
+        accounts.append(QJsonObject{ { "role", l.role }, { "accountId", l.accountId } });
+    }
+    if (links.isEmpty()) return error(409, "Card has no linked accounts");
+
+    QJsonObject reply{ { "ok", true }, { "accounts", accounts } };
+    if (wantBootstrap) reply["bootstrap"] = bootstrapFor(links);
+    return { 200, reply };
+}
+
+// -------- accounts --------
+
+StandinBank::Result StandinBank::balance(int accountId) const
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+    const auto it = m_accounts.constFind(accountId);
+    if (it == m_accounts.constEnd()) return error(404, "Account not found");
+    return { 200, balanceJson(it.value()) };
+}
+
+static bool validIdempotencyKey(const QString &key)
+{
+    static const QRegularExpression re(QStringLiteral("^[A-Za-z0-9_-]{8,64}$"));
+    return re.match(key).hasMatch();
+}
+
+StandinBank::Result StandinBank::withdraw(int accountId, const QJsonObject &body, bool hasKey, const QString &key)
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+    if (hasKey && !validIdempotencyKey(key)) return error(400, "Invalid Idempotency-Key");
+
+    // Number(req.body.amount): numbers and numeric strings
+    bool numeric = false;
+    const double amount = body.value("amount").toVariant().toDouble(&numeric);
+    if (!numeric || amount <= 0 || amount != qint64(amount)) return error(400, "Invalid amount");
+
+    static constexpr int MAX_AMOUNT =
+        DispensePlanner::maxAmount(DispensePlanner::unlimited(DispensePlanner::KIOSK_DENOMINATIONS));
+    if (amount > MAX_AMOUNT) {
+        return error(400, QString("Amount above limit (max %1€ per withdrawal)").arg(MAX_AMOUNT));
+    }
+
+    qint64 fifties = 0;
+    qint64 twenties = 0;
+    if (!computeBills(qint64(amount), &fifties, &twenties)) {
+        return error(400, "Invalid amount (allowed bills: 20€ and 50€)");
+    }
+
+    auto it = m_accounts.find(accountId);
+    if (it == m_accounts.end()) return error(404, "Account not found");
+
+    const qint64 cents = qint64(amount) * 100;
+    if (!hasKey) return debit(it.value(), qint64(amount), fifties, twenties);
+
+    // Same key seen before: the first answer again, nothing changes
+    const QPair<int, QString> id(accountId, key);
+    const auto stored = m_withdrawKeys.constFind(id);
+    if (stored != m_withdrawKeys.constEnd()) {
+        if (stored->amountCents >= 0 && stored->amountCents != cents) {
+            return error(422, "Idempotency-Key already used for another amount");
+        }
+        Result replay = stored->result;
+        replay.replayed = true;
+        return replay;
+    }
+
+    const Result result = debit(it.value(), qint64(amount), fifties, twenties);
+    if (result.status == 200 || result.status == 400) m_withdrawKeys.insert(id, { cents, result });
+    return result;
+}
+
+StandinBank::Result StandinBank::cancelWithdrawal(int accountId, const QString &key)
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+    if (!validIdempotencyKey(key)) return error(400, "Invalid Idempotency-Key");
+    if (!m_accounts.contains(accountId)) return error(404, "Account not found");
+
+    const QPair<int, QString> id(accountId, key);
+    auto stored = m_withdrawKeys.find(id);
+    if (stored == m_withdrawKeys.end()) {
+        // Never processed: a request still on its way with this key is refused from now on
+        stored = m_withdrawKeys.insert(id, { -1, error(410, "Withdrawal cancelled") });
+    }
+
+    return { 200, QJsonObject{
+        { "state", withdrawState(*stored) },
+        { "status", stored->result.status },
+        { "response", stored->result.body },
+    } };
+}
+
+StandinBank::Result StandinBank::reverseWithdrawal(int accountId, const QString &key)
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+    if (!validIdempotencyKey(key)) return error(400, "Invalid Idempotency-Key");
+    auto acc = m_accounts.find(accountId);
+    if (acc == m_accounts.end()) return error(404, "Account not found");
+
+    auto stored = m_withdrawKeys.find(qMakePair(accountId, key));
+    if (stored == m_withdrawKeys.end()) return error(404, "Unknown withdrawal");
+
+    // Credited back once, as a deposit; a repeat only reports it
+    if (stored->result.status == 200 && !stored->reversed) {
+        acc->balanceCents += stored->amountCents;
+        m_clockMs += 1000;
+        addTx(accountId, m_clockMs, stored->amountCents, "deposit");
+        stored->reversed = true;
+    }
+
+    return { 200, QJsonObject{
+        { "state", withdrawState(*stored) },
+        { "status", stored->result.status },
+        { "balance", double(acc->balanceCents) / 100.0 },
+    } };
+}
+
+QString StandinBank::withdrawState(const StoredWithdraw &stored)
+{
+    const int status = stored.result.status;
+    if (status == 200) return stored.reversed ? QStringLiteral("reversed") : QStringLiteral("completed");
+    return status == 410 ? QStringLiteral("cancelled") : QStringLiteral("refused");
+}
+
+StandinBank::Result StandinBank::debit(Account &acc, qint64 amount, qint64 fifties, qint64 twenties)
+{
+    const qint64 cents = amount * 100;
+    const qint64 newBalance = acc.balanceCents - cents;
+    if (acc.type == QLatin1String("debit")) {
+        if (acc.balanceCents < cents) return error(400, "Insufficient funds");
+    } else if (acc.type == QLatin1String("credit")) {
+        if (newBalance < -acc.creditLimitCents) return error(400, "Credit limit exceeded");
+    } else {
+        return error(500, "Invalid account type");
+    }
+
+    acc.balanceCents = newBalance;
+    m_clockMs += 1000;
+    addTx(acc.id, m_clockMs, cents, "withdrawal");
+
+    return { 200, QJsonObject{
+        { "ok", true },
+        { "accountId", acc.id },
+        { "withdrawn", amount },
+        { "balance", double(newBalance) / 100.0 },  // a JS number here, not a DECIMAL string
+        { "bills", QJsonObject{ { "50", fifties }, { "20", twenties } } },
+    } };
+}
+
+StandinBank::Result StandinBank::transactions(int accountId, const QUrlQuery &query) const
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+
+    const QString before = query.queryItemValue("before", QUrl::FullyDecoded);
+    const QString after = query.queryItemValue("after", QUrl::FullyDecoded);
+    const bool stream = query.queryItemValue("stream") == QLatin1String("1");
+
+    bool limitOk = false;
+    const int limit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toInt(&limitOk) : 10;
+    if (!query.hasQueryItem("limit")) limitOk = true;
+
+    if (!before.isEmpty() && !after.isEmpty()) return error(400, "Use only one: before or after");
+
+    qint64 cursorMs = 0;
+    qint64 cursorId = 0;
+    if (!before.isEmpty() && !parseCursor(before, &cursorMs, &cursorId)) return error(400, "Invalid before cursor");
+    if (!after.isEmpty() && !parseCursor(after, &cursorMs, &cursorId)) return error(400, "Invalid after cursor");
+
+    const QVector<Tx> history = m_history.value(accountId);
+
+    if (stream) {
+        if (!after.isEmpty()) return error(400, "Streaming supports only before");
+        const int streamLimit = limitOk ? qBound(1, limit, STREAM_MAX_ROWS) : STREAM_MAX_ROWS;
+
+        int end = history.size();
+        if (!before.isEmpty()) {
+            end = int(std::lower_bound(history.begin(), history.end(), qMakePair(cursorMs, cursorId),
+                                       [](const Tx &tx, const QPair<qint64, qint64> &c) {
+                                           return txLess(tx.createdMs, tx.id, c.first, c.second);
+                                       }) - history.begin());
+        }
+
+        QJsonArray records;
+        int count = 0;
+        for (int i = end - 1; i >= 0 && count < streamLimit; --i, ++count) records.append(txJson(history.at(i)));
+        const bool hasMore = end - count > 0;
+        records.append(QJsonObject{
+            { "end", true },
+            { "count", count },
+            { "nextCursor", hasMore && count > 0 ? QJsonValue(cursorFor(history.at(end - count))) : QJsonValue() },
+            { "prevCursor", QJsonValue() },
+        });
+        Result r{ 200, records };
+        r.ndjson = true;
+        return r;
+    }
+
+    const int pageLimit = limitOk ? qBound(1, limit, PAGE_MAX_ROWS) : 10;
+
+    QVector<const Tx *> rows; // newest -> oldest
+    bool hasMore = false;
+    if (!after.isEmpty()) {
+        // Newer than the cursor: the pageLimit rows closest to it
+        int begin = int(std::upper_bound(history.begin(), history.end(), qMakePair(cursorMs, cursorId),
+                                         [](const QPair<qint64, qint64> &c, const Tx &tx) {
+                                             return txLess(c.first, c.second, tx.createdMs, tx.id);
+                                         }) - history.begin());
+        const int end = qMin(int(history.size()), begin + pageLimit);
+        hasMore = history.size() > end;
+        for (int i = end - 1; i >= begin; --i) rows.append(&history.at(i));
+    } else {
+        int end = history.size();
+        if (!before.isEmpty()) {
+            end = int(std::lower_bound(history.begin(), history.end(), qMakePair(cursorMs, cursorId),
+                                       [](const Tx &tx, const QPair<qint64, qint64> &c) {
+                                           return txLess(tx.createdMs, tx.id, c.first, c.second);
+                                       }) - history.begin());
+        }
+        const int begin = qMax(0, end - pageLimit);
+        hasMore = begin > 0;
+        for (int i = end - 1; i >= begin; --i) rows.append(&history.at(i));
+    }
+
+    QJsonArray items;
+    for (const Tx *tx : rows) items.append(txJson(*tx));
+
+    // Same cursor rules as the backend: next only where "older" makes sense, prev unless first page
+    const bool olderDirection = after.isEmpty();
+    const QJsonValue nextCursor = (!rows.isEmpty() && olderDirection && hasMore)
+        ? QJsonValue(cursorFor(*rows.last())) : QJsonValue();
+    const QJsonValue prevCursor = (!rows.isEmpty() && (!before.isEmpty() || !after.isEmpty()))
+        ? QJsonValue(cursorFor(*rows.first())) : QJsonValue();
+
+    return { 200, QJsonObject{ { "items", items }, { "nextCursor", nextCursor }, { "prevCursor", prevCursor } } };
+}
+
+StandinBank::Result StandinBank::bootstrap(int accountId) const
+{
+    if (accountId <= 0) return error(400, "Invalid account id");
+
+    // Linked accounts through the card(s) of this account
+    QSet<int> cards;
+    for (const Link &l : m_links) {
+        if (l.accountId == accountId) cards.insert(l.cardId);
+    }
+    QVector<Link> links;
+    QSet<int> seen;
+    for (const QString &role : { QStringLiteral("debit"), QStringLiteral("credit") }) {
+        for (const Link &l : m_links) {
+            if (cards.contains(l.cardId) && l.role == role && !seen.contains(l.accountId)) {
+                seen.insert(l.accountId);
+                links.append(l);
+            }
+        }
+    }
+
+    if (links.isEmpty()) {
+        const auto it = m_accounts.constFind(accountId);
+        if (it == m_accounts.constEnd()) return error(404, "Account not found");
+        links.append({ 0, accountId, it->type });
+    }
+    return { 200, bootstrapFor(links) };
+}
+
+QJsonObject StandinBank::bootstrapFor(const QVector<Link> &links) const
+{
+    QJsonArray accounts;
+    for (const Link &l : links) {
+        const auto it = m_accounts.constFind(l.accountId);
+        if (it == m_accounts.constEnd()) continue;
+        accounts.append(QJsonObject{
+            { "role", l.role },
+            { "accountId", l.accountId },
+            { "balance", balanceJson(it.value()) },
+            { "transactions", firstPage(l.accountId, BOOTSTRAP_PAGE_SIZE) },
+        });
+    }
+
+    QJsonValue customer;
+    const auto owner = m_accounts.constFind(links.first().accountId);
+    if (owner != m_accounts.constEnd()) {
+        const Customer c = m_customers.value(owner->customerId);
+        customer = QJsonObject{
+            { "id", c.id },
+            { "image_filename", c.imageFilename.isEmpty() ? QJsonValue() : QJsonValue(c.imageFilename) },
+        };
+    }
+    return QJsonObject{ { "accounts", accounts }, { "customer", customer } };
+}
+
+QJsonObject StandinBank::firstPage(int accountId, int limit) const
+{
+    QUrlQuery query;
+    query.addQueryItem("limit", QString::number(limit));
+    return transactions(accountId, query).body.toObject();
+}
+
+// -------- crud (read side used by the client) --------
+
+StandinBank::Result StandinBank::crudAccounts() const
+{
+    QList<int> ids = m_accounts.keys();
+    std::sort(ids.begin(), ids.end(), std::greater<int>()); // ORDER BY id DESC
+    QJsonArray rows;
+    for (int id : ids) rows.append(accountJson(m_accounts.value(id)));
+    return { 200, rows };
+}
+
+StandinBank::Result StandinBank::crudAccount(int id) const
+{
+    if (id <= 0) return error(400, "Invalid id");
+    const auto it = m_accounts.constFind(id);
+    if (it == m_accounts.constEnd()) return error(404, "Not found");
+    return { 200, accountJson(it.value()) };
+}
+
+StandinBank::Result StandinBank::crudCustomers() const
+{
+    QList<int> ids = m_customers.keys();
+    std::sort(ids.begin(), ids.end());
+    QJsonArray rows;
+    for (int id : ids) rows.append(customerJson(m_customers.value(id)));
+    return { 200, rows };
+}
+
+StandinBank::Result StandinBank::crudCustomer(int id) const
+{
+    if (id <= 0) return error(400, "Invalid id");
+    const auto it = m_customers.constFind(id);
+    if (it == m_customers.constEnd()) return error(404, "Customer not found");
+    return { 200, customerJson(it.value()) };
+}
+
+// -------- JSON shapes (as mysql2 + res.json produce them) --------
+
+QJsonObject StandinBank::balanceJson(const Account &acc) const
+{
+    return QJsonObject{
+        { "id", acc.id },
+        { "account_type", acc.type },
+        { "balance", decimal(acc.balanceCents) },
+        { "credit_limit", decimal(acc.creditLimitCents) },
+    };
+}
+
+QJsonObject StandinBank::accountJson(const Account &acc) const
+{
+    QJsonObject o = balanceJson(acc);
+    o["customer_id"] = acc.customerId;
+    o["is_locked"] = 0;
+    o["created_at"] = QDateTime::fromMSecsSinceEpoch(ACCOUNTS_CREATED_MS, Qt::UTC).toString(Qt::ISODateWithMs);
+    return o;
+}
+
+QJsonObject StandinBank::customerJson(const Customer &c) const
+{
+    return QJsonObject{
+        { "id", c.id },
+        { "first_name", c.firstName },
+        { "last_name", c.lastName },
+        { "address", c.address },
+        { "image_filename", c.imageFilename.isEmpty() ? QJsonValue() : QJsonValue(c.imageFilename) },
+    };
+}
+
+QJsonObject StandinBank::txJson(const Tx &tx)
+{
+    return QJsonObject{
+        { "id", tx.id },
+        { "tx_type", tx.type },
+        { "amount", decimal(tx.cents) },
+        { "created_at", QDateTime::fromMSecsSinceEpoch(tx.createdMs, Qt::UTC).toString(Qt::ISODateWithMs) },
+    };
+}
+
+QString StandinBank::cursorFor(const Tx &tx)
+{
+    return QString("%1|%2").arg(tx.createdMs).arg(tx.id);
+}
+
+bool StandinBank::parseCursor(const QString &text, qint64 *ms, qint64 *id)
+{
+    const QStringList parts = text.split('|');
+    if (parts.size() != 2) return false;
+    bool okMs = false;
+    bool okId = false;
+    *ms = parts.at(0).toLongLong(&okMs);
+    *id = parts.at(1).toLongLong(&okId);
+    return okMs && okId && *ms > 0 && *id > 0;
+}
+
+QString StandinBank::decimal(qint64 cents)
+{
+    const qint64 abs = qAbs(cents);
+    return QString("%1%2.%3").arg(cents < 0 ? QLatin1String("-") : QLatin1String("")).arg(abs / 100).arg(abs % 100, 2, 10, QChar('0'));
+}
+
+StandinBank::Result StandinBank::error(int status, const QString &message)
+{
+    return { status, QJsonObject{ { "error", message } } };
+}
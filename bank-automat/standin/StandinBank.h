@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QUrlQuery;
+
+// In-memory bank behind the stand-in backend. Same data as database/02_seed.sql
+// (cards 11111111 / 22222222 / 33333333, PIN 1234) plus a generated transaction
+// history per account, and the same rules and reply shapes as backend/routes.
+// Fully deterministic: history comes from a seeded generator and the clock only
+// moves when money does (one second per withdrawal).
+class StandinBank
+{
+public:
+    struct Result {
+        int status = 200;
+        QJsonValue body;
+        bool ndjson = false;   // body is an array of records for an NDJSON stream
+        bool replayed = false; // stored answer to an Idempotency-Key seen before
+    };
+
+    void reset(quint32 seed, int historyPerAccount);
+
+    Result login(const QJsonObject& body);
+    Result balance(int accountId) const;
+    Result withdraw(int accountId, const QJsonObject& body, bool hasKey = false, const QString& key = QString());
+    Result cancelWithdrawal(int accountId, const QString& key);
+    Result reverseWithdrawal(int accountId, const QString& key);
+    Result transactions(int accountId, const QUrlQuery& query) const;
+    Result bootstrap(int accountId) const;
+
+    Result crudAccounts() const;
+    Result crudAccount(int id) const;
+    Result crudCustomers() const;
+    Result crudCustomer(int id) const;
+
+    static constexpr int MAX_PIN_ATTEMPTS = 3;
+    static constexpr int PAGE_MAX_ROWS = 100;
+    static constexpr int STREAM_MAX_ROWS = 5000;
+    static constexpr int BOOTSTRAP_PAGE_SIZE = 10;
+
+private:
+    struct Customer {
+        int id;
+        QString firstName;
+        QString lastName;
+        QString address;
+        QString imageFilename; // empty -> null
+    };
+    struct Account {
+        int id;
+        int customerId;
+        QString type;          // debit | credit
+        qint64 balanceCents;
+        qint64 creditLimitCents;
+    };
+    struct Card {
+        QString number;
+        int id;
+        QString pin;
+        bool locked;
+        int failedAttempts;
+    };
+    struct Link {
+        int cardId;
+        int accountId;
+        QString role;
+    };
+    struct Tx {
+        qint64 id;
+        qint64 createdMs;
+        qint64 cents;
+        QString type;
+    };
+
+    QHash<int, Customer> m_customers;
+    QHash<int, Account> m_accounts;
+    QHash<QString, Card> m_cards;       // by card number
+    QVector<Link> m_links;              // debit before credit per card
+    QHash<int, QVector<Tx>> m_history;  // per account, oldest -> newest
+    qint64 m_nextTxId = 1;
+
+    // withdraw_requests: answer per (account, Idempotency-Key); amountCents -1 = cancelled
+    struct StoredWithdraw {
+        qint64 amountCents;
+        Result result;
+        bool reversed = false;
+    };
+    QHash<QPair<int, QString>, StoredWithdraw> m_withdrawKeys;
+    qint64 m_clockMs = 0;
+
+    QJsonObject balanceJson(const Account& acc) const;
+    QJsonObject accountJson(const Account& acc) const;
+    QJsonObject customerJson(const Customer& c) const;
+    QJsonObject firstPage(int accountId, int limit) const;
+    QJsonObject bootstrapFor(const QVector<Link>& links) const;
+    void addTx(int accountId, qint64 createdMs, qint64 cents, const QString& type);
+    Result debit(Account& acc, qint64 amount, qint64 fifties, qint64 twenties);
+
+    static QJsonObject txJson(const Tx& tx);
+    static QString cursorFor(const Tx& tx);
+    static bool parseCursor(const QString& text, qint64* ms, qint64* id);
+    static QString decimal(qint64 cents);
+    static QString withdrawState(const StoredWithdraw& stored);
+    static Result error(int status, const QString& message);
+};
@@ -0,0 +1,544 @@
+#include "StandinServer.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#endif
+
+static const int MAX_HEADER_BYTES = 64 * 1024;
+static const int MAX_BODY_BYTES = 1024 * 1024;
+
+// FNV-1a: stable across runs and platforms (qHash is not meant to be)
+static quint32 stableHash(const QString &text)
+{
+    quint32 h = 2166136261u;
+    for (const QChar c : text) {
+        h ^= c.unicode();
+        h *= 16777619u;
+    }
+    return h;
+}
+
+StandinServer::StandinServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &StandinServer::onNewConnection);
+    resetBank();
+}
+
+bool StandinServer::listen(const QHostAddress &address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+void StandinServer::setFaultPlan(const FaultPlan &plan)
+{
+    m_plan = plan;
+    m_routeSequence.clear();
+    m_stats.clear();
+}
+
+void StandinServer::setHistoryPerAccount(int rows)
+{
+    m_historyPerAccount = qMax(0, rows);
+    resetBank();
+}
+
+void StandinServer::resetBank()
+{
+    m_bank.reset(m_plan.seed(), m_historyPerAccount);
+}
+
+void StandinServer::setImageDir(const QString &dir)
+{
+    m_imageDir = dir;
+}
+
+// -------- connections and HTTP framing --------
+
+void StandinServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it == m_connections.end()) return;
+            it->buffer += socket->readAll();
+            processBuffer(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void StandinServer::processBuffer(QTcpSocket *socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end() || it->busy) return;
+    Connection &conn = it.value();
+
+    const int headerEnd = conn.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (conn.buffer.size() > MAX_HEADER_BYTES) {
+            conn.busy = true;
+            conn.closeAfter = true;
+            Request bad;
+            bad.keepAlive = false;
+            socket->write(serialize(bad, jsonError(431, "Request header too large")));
+            finishExchange(socket);
+        }
+        return;
+    }
+
+    Request request;
+    const QList<QByteArray> lines = conn.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+
+    const auto reject = [&](int status, const char *message) {
+        conn.busy = true;
+        conn.closeAfter = true;
+        request.keepAlive = false;
+        socket->write(serialize(request, jsonError(status, QString::fromLatin1(message))));
+        finishExchange(socket);
+    };
+
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/1.")) {
+        reject(400, "Bad request line");
+        return;
+    }
+    request.method = requestLine.at(0);
+
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+    }
+
+    if (request.headers.contains("transfer-encoding")) {
+        reject(501, "Chunked request bodies are not supported");
+        return;
+    }
+    bool lengthOk = true;
+    const int length = request.headers.contains("content-length")
+        ? request.headers.value("content-length").toInt(&lengthOk) : 0;
+    if (!lengthOk || length < 0 || length > MAX_BODY_BYTES) {
+        reject(413, "Request body too large");
+        return;
+    }
+
+    const int total = headerEnd + 4 + length;
+    if (conn.buffer.size() < total) return; // rest of the body still on the way
+
+    request.body = conn.buffer.mid(headerEnd + 4, length);
+    conn.buffer.remove(0, total);
+
+    const QByteArray target = requestLine.at(1);
+    const int q = target.indexOf('?');
+    request.path = QUrl::fromPercentEncoding(q < 0 ? target : target.left(q));
+    request.query = q < 0 ? QString() : QString::fromUtf8(target.mid(q + 1));
+
+    const QByteArray connection = request.headers.value("connection").toLower();
+    request.keepAlive = requestLine.at(2) == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
+
+    conn.busy = true;
+    conn.closeAfter = !request.keepAlive;
+    handle(socket, request);
+}
+
+void StandinServer::finishExchange(QTcpSocket *socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+
+    it->busy = false;
+    if (it->closeAfter) {
+        socket->disconnectFromHost();
+        return;
+    }
+    // Next pipelined request, if one is already buffered
+    if (!it->buffer.isEmpty()) {
+        QTimer::singleShot(0, socket, [this, socket]() { processBuffer(socket); });
+    }
+}
+
+// -------- faults --------
+
+void StandinServer::handle(QTcpSocket *socket, const Request &request)
+{
+    if (request.path.startsWith(QLatin1String("/_standin/"))) {
+        socket->write(serialize(request, control(request)));
+        finishExchange(socket);
+        return;
+    }
+
+    // Route template: numeric segments -> :id, upload names -> :file, withdrawal keys -> :key
+    // (same labels as RequestMetrics)
+    QStringList segments = request.path.split('/', Qt::SkipEmptyParts);
+    for (int i = 0; i < segments.size(); ++i) {
+        bool numeric = false;
+        segments[i].toLongLong(&numeric);
+        if (numeric) segments[i] = QStringLiteral(":id");
+        else if (i == 2 && segments.at(0) == QLatin1String("images")) segments[i] = QStringLiteral(":file");
+        else if (i == 3 && segments.at(2) == QLatin1String("withdrawals")) segments[i] = QStringLiteral(":key");
+    }
+    const QByteArray method = request.method == "HEAD" ? QByteArray("GET") : request.method;
+    const QString route = QString::fromLatin1(method) + " /" + segments.join('/');
+
+    // One RNG stream per route and request number: the Nth balance request gets the same
+    // faults on every run, however the requests of different routes interleave
+    const quint64 sequence = m_routeSequence[route]++;
+    const quint32 seedData[] = { m_plan.seed(), stableHash(route), quint32(sequence), quint32(sequence >> 32) };
+    QRandomGenerator rng(seedData, seedData + 4);
+
+    const RouteFaults &faults = m_plan.forRoute(route);
+    const double resetRoll = rng.generateDouble();
+    const double errorRoll = rng.generateDouble();
+    const int latencyMs = faults.sampleLatencyMs(rng);
+
+    RouteStats &stats = m_stats[route];
+    ++stats.requests;
+
+    // An injected error replaces the handler (nothing happens, like an overloaded upstream);
+    // a reset comes after it (the work is done but the reply is lost)
+    Response response;
+    if (errorRoll < faults.errorRate) {
+        ++stats.errors;
+        response = jsonError(faults.errorStatus, "Injected fault");
+    } else {
+        response = dispatch(request, route);
+    }
+
+    const QByteArray bytes = serialize(request, response);
+    int resetAt = -1;
+    if (resetRoll < faults.resetRate) {
+        ++stats.resets;
+        resetAt = qMin(faults.resetAfterBytes, int(bytes.size()));
+    }
+    if (faults.dripChunkBytes > 0) ++stats.dripped;
+
+    if (m_verbose) {
+        qInfo().noquote() << request.method << request.path
+                          << response.status << QString("+%1ms").arg(latencyMs)
+                          << (resetAt >= 0 ? QString("reset@%1").arg(resetAt) : QString());
+    }
+
+    QTimer::singleShot(latencyMs, socket, [this, socket, bytes, faults, resetAt]() {
+        if (resetAt == 0) {
+            resetConnection(socket);
+            return;
+        }
+        writeDripped(socket, bytes, 0, faults, resetAt);
+    });
+}
+
+void StandinServer::writeDripped(QTcpSocket *socket, const QByteArray &bytes, int offset,
+                                 const RouteFaults &faults, int resetAt)
+{
+    const int chunk = faults.dripChunkBytes > 0 ? faults.dripChunkBytes : int(bytes.size());
+    int end = qMin(offset + chunk, int(bytes.size()));
+    if (resetAt >= 0) end = qMin(end, resetAt);
+
+    socket->write(bytes.constData() + offset, end - offset);
+
+    if (resetAt >= 0 && end >= resetAt) {
+        resetConnection(socket);
+        return;
+    }
+    if (end >= bytes.size()) {
+        finishExchange(socket);
+        return;
+    }
+    QTimer::singleShot(faults.dripIntervalMs, socket, [this, socket, bytes, end, faults, resetAt]() {
+        writeDripped(socket, bytes, end, faults, resetAt);
+    });
+}
+
+void StandinServer::resetConnection(QTcpSocket *socket)
+{
+    // Push what was written to the kernel, then close with SO_LINGER 0 so the peer gets an
+    // RST (ECONNRESET / QNetworkReply::RemoteHostClosedError) rather than an orderly FIN.
+    // On loopback the flushed bytes reach the peer before the reset.
+    socket->flush();
+#ifdef Q_OS_UNIX
+    const struct linger noLinger = { 1, 0 };
+    ::setsockopt(int(socket->socketDescriptor()), SOL_SOCKET, SO_LINGER, &noLinger, sizeof(noLinger));
+#endif
+    m_connections.remove(socket);
+    socket->abort();
+    socket->deleteLater();
+}
+
+// -------- routes --------
+
+StandinServer::Response StandinServer::dispatch(const Request &request, const QString &route)
+{
+    const QStringList segments = request.path.split('/', Qt::SkipEmptyParts);
+    const QUrlQuery query(request.query);
+    const auto idAt = [&segments](int i) { return i < segments.size() ? segments.at(i).toInt() : 0; };
+
+    const auto bodyObject = [&request](bool *ok) {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(request.body, &parseError);
+        *ok = parseError.error == QJsonParseError::NoError && doc.isObject();
+        return doc.object();
+    };
+
+    if (route == QLatin1String("GET /health/ping")) {
+        Response r;
+        r.status = 204;
+        return r;
+    }
+
+    if (route == QLatin1String("GET /health")) {
+        return json({ 200, QJsonObject{ { "status", "ok" }, { "db", 1 } } });
+    }
+
+    if (route == QLatin1String("POST /auth/login")) {
+        bool ok = false;
+        const QJsonObject body = bodyObject(&ok);
+        if (!ok) return jsonError(400, "Invalid JSON body");
+        return json(m_bank.login(body));
+    }
+
+    if (route == QLatin1String("GET /accounts/:id/balance")) {
+        Response r = json(m_bank.balance(idAt(1)));
+        r.etag = true;
+        r.cacheControl = "private, no-cache";
+        r.varyAccept = true;
+        return r;
+    }
+
+    if (route == QLatin1String("POST /accounts/:id/withdraw")) {
+        bool ok = false;
+        const QJsonObject body = bodyObject(&ok);
+        if (!ok) return jsonError(400, "Invalid JSON body");
+        const StandinBank::Result result =
+            m_bank.withdraw(idAt(1), body, request.headers.contains("idempotency-key"),
+                            QString::fromLatin1(request.headers.value("idempotency-key")));
+        Response r = json(result);
+        r.varyAccept = true;
+        r.replayed = result.replayed;
+        return r;
+    }
+
+    if (route == QLatin1String("POST /accounts/:id/withdrawals/:key/cancel")) {
+        Response r = json(m_bank.cancelWithdrawal(idAt(1), segments.value(3)));
+        r.varyAccept = true;
+        return r;
+    }
+
+    if (route == QLatin1String("POST /accounts/:id/withdrawals/:key/reverse")) {
+        Response r = json(m_bank.reverseWithdrawal(idAt(1), segments.value(3)));
+        r.varyAccept = true;
+        return r;
+    }
+
+    if (route == QLatin1String("GET /accounts/:id/transactions")) {
+        const StandinBank::Result result = m_bank.transactions(idAt(1), query);
+        Response r = json(result);
+        r.varyAccept = true;
+        if (result.ndjson) {
+            r.cacheControl = "no-store";
+        } else if (result.status == 200) {
+            r.etag = true;
+            r.cacheControl = "private, no-cache";
+        }
+        return r;
+    }
+
+    if (route == QLatin1String("GET /accounts/:id/bootstrap")) {
+        Response r = json(m_bank.bootstrap(idAt(1)));
+        r.cacheControl = "no-store";
+        r.varyAccept = true;
+        return r;
+    }
+
+    if (route == QLatin1String("GET /crud/accounts")) return json(m_bank.crudAccounts());
+    if (route == QLatin1String("GET /crud/accounts/:id")) return json(m_bank.crudAccount(idAt(2)));
+    if (route == QLatin1String("GET /crud/customers")) return json(m_bank.crudCustomers());
+    if (route == QLatin1String("GET /crud/customers/:id")) return json(m_bank.crudCustomer(idAt(2)));
+
+    if (route == QLatin1String("GET /images/uploads/:file")) return image(segments.value(2));
+
+    return jsonError(404, QString("Cannot %1 %2").arg(QString::fromLatin1(request.method), request.path));
+}
+
+StandinServer::Response StandinServer::control(const Request &request)
+{
+    if (request.path == QLatin1String("/_standin/faults")) {
+        if (request.method == "GET") return json({ 200, m_plan.toJson() });
+        if (request.method == "PUT") {
+            const QJsonDocument doc = QJsonDocument::fromJson(request.body);
+            QString error;
+            const FaultPlan plan = FaultPlan::fromJson(doc.object(), &error);
+            if (!doc.isObject() || !error.isEmpty()) {
+                return jsonError(400, error.isEmpty() ? QStringLiteral("Invalid JSON body") : error);
+            }
+            setFaultPlan(plan);
+            return json({ 200, m_plan.toJson() });
+        }
+    }
+
+    if (request.path == QLatin1String("/_standin/stats") && request.method == "GET") {
+        QJsonObject routes;
+        for (auto it = m_stats.cbegin(); it != m_stats.cend(); ++it) {
+            routes[it.key()] = QJsonObject{
+                { "requests", qint64(it->requests) },
+                { "errors", qint64(it->errors) },
+                { "resets", qint64(it->resets) },
+                { "dripped", qint64(it->dripped) },
+            };
+        }
+        return json({ 200, routes });
+    }
+
+    if (request.path == QLatin1String("/_standin/reset") && request.method == "POST") {
+        resetBank();
+        return json({ 200, QJsonObject{ { "ok", true } } });
+    }
+
+    return jsonError(404, "Unknown control route");
+}
+
+StandinServer::Response StandinServer::image(const QString &filename)
+{
+    // Server-generated names only: no paths, no dot files
+    if (filename.isEmpty() || filename.contains('/') || filename.contains('\\') || filename.startsWith('.')) {
+        return jsonError(404, "Not found");
+    }
+
+    const QString ext = QFileInfo(filename).suffix().toLower();
+    Response r;
+    r.etag = true;
+    r.cacheControl = "public, max-age=0";
+    if (ext == QLatin1String("jpg") || ext == QLatin1String("jpeg")) r.contentType = "image/jpeg";
+    else if (ext == QLatin1String("png")) r.contentType = "image/png";
+    else return jsonError(404, "Not found");
+
+    if (!m_imageDir.isEmpty()) {
+        QFile f(QDir(m_imageDir).filePath(filename));
+        if (f.open(QIODevice::ReadOnly)) {
+            r.body = f.readAll();
+            return r;
+        }
+    }
+
+    // Placeholder photo: camera-sized so the client's scaled decode has real work,
+    // colours derived from the name so every file is different but stable
+    QByteArray &cached = m_generatedImages[filename];
+    if (cached.isEmpty()) {
+        const quint32 h = stableHash(filename);
+        QImage img(1600, 1200, QImage::Format_RGB32);
+        for (int y = 0; y < img.height(); ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+            for (int x = 0; x < img.width(); ++x) {
+                const int r0 = (x * 255 / img.width() + int(h & 0xff)) & 0xff;
+                const int g0 = (y * 255 / img.height() + int((h >> 8) & 0xff)) & 0xff;
+                const int b0 = ((x ^ y) + int((h >> 16) & 0xff)) & 0xff;
+                line[x] = qRgb(r0, g0, b0);
+            }
+        }
+        QBuffer buffer(&cached);
+        buffer.open(QIODevice::WriteOnly);
+        img.save(&buffer, ext == QLatin1String("png") ? "PNG" : "JPEG", 85);
+    }
+    r.body = cached;
+    return r;
+}
+
+// -------- responses --------
+
+StandinServer::Response StandinServer::json(const StandinBank::Result &result)
+{
+    Response r;
+    r.status = result.status;
+    if (result.ndjson) {
+        r.contentType = "application/x-ndjson";
+        const QJsonArray records = result.body.toArray();
+        for (const QJsonValue &record : records) {
+            r.body += QJsonDocument(record.toObject()).toJson(QJsonDocument::Compact);
+            r.body += '\n';
+        }
+        return r;
+    }
+    r.body = result.body.isArray()
+        ? QJsonDocument(result.body.toArray()).toJson(QJsonDocument::Compact)
+        : QJsonDocument(result.body.toObject()).toJson(QJsonDocument::Compact);
+    return r;
+}
+
+StandinServer::Response StandinServer::jsonError(int status, const QString &message)
+{
+    return json({ status, QJsonObject{ { "error", message } } });
+}
+
+QByteArray StandinServer::serialize(const Request &request, const Response &response) const
+{
+    int status = response.status;
+    QByteArray etag;
+    if (response.etag && status == 200) {
+        // Strong validator like Express ("<length>-<hash>")
+        etag = '"' + QByteArray::number(response.body.size(), 16) + '-'
+               + QCryptographicHash::hash(response.body, QCryptographicHash::Sha1).toBase64(
+                     QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals).left(27)
+               + '"';
+        const QByteArray ifNoneMatch = request.headers.value("if-none-match");
+        if (!ifNoneMatch.isEmpty() && (ifNoneMatch == etag || ifNoneMatch.contains(etag))) status = 304;
+    }
+
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    if (status != 304) {
+        out += "Content-Type: " + response.contentType + "\r\n";
+        out += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    }
+    if (!etag.isEmpty()) out += "ETag: " + etag + "\r\n";
+    if (!response.cacheControl.isEmpty()) out += "Cache-Control: " + response.cacheControl + "\r\n";
+    if (response.varyAccept) out += "Vary: Accept\r\n";
+    if (response.replayed) out += "Idempotent-Replayed: true\r\n";
+    out += request.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    out += "\r\n";
+
+    if (status != 304 && request.method != "HEAD") out += response.body;
+    return out;
+}
+
+QByteArray StandinServer::reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 410: return "Gone";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 422: return "Unprocessable Entity";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default:  return status < 500 ? "Client Error" : "Server Error";
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+#include "FaultPlan.h"
+#include "StandinBank.h"
+
+class QTcpSocket;
+
+// HTTP/1.1 stand-in for the Node backend, for exercising ApiClient on one box without
+// Node or MySQL. Serves the routes the client uses (auth, accounts, bootstrap, crud
+// reads, uploaded images, health) with the backend's reply shapes, ETag revalidation
+// and keep-alive, and injects the faults of a FaultPlan per route.
+//
+// Replies are always JSON (NDJSON for ?stream=1): ApiClient decodes by Content-Type,
+// so its CBOR preference does not matter here.
+//
+// Control routes (never faulted):
+//   GET  /_standin/faults   current plan
+//   PUT  /_standin/faults   replace the plan (FaultPlan JSON), restarts the fault sequences
+//   GET  /_standin/stats    per route: requests, injected errors, resets, dripped replies
+//   POST /_standin/reset    reseed the bank (cards unlocked, balances and history restored)
+class StandinServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StandinServer(QObject *parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    quint16 serverPort() const { return m_server.serverPort(); }
+    QString errorString() const { return m_server.errorString(); }
+
+    void setFaultPlan(const FaultPlan& plan);
+    // History rows generated per account on reset (default 250)
+    void setHistoryPerAccount(int rows);
+    void resetBank();
+
+    // Files served under /images/uploads/; missing files are generated (deterministic placeholder)
+    void setImageDir(const QString& dir);
+    void setVerbose(bool verbose) { m_verbose = verbose; }
+
+private:
+    struct Request {
+        QByteArray method;
+        QString path;
+        QString query;
+        QHash<QByteArray, QByteArray> headers; // lower-case names
+        QByteArray body;
+        bool keepAlive = true;
+    };
+
+    struct Response {
+        int status = 200;
+        QByteArray contentType = "application/json; charset=utf-8";
+        QByteArray body;
+        QByteArray cacheControl;
+        bool etag = false;       // revalidatable: ETag + 304 on If-None-Match
+        bool varyAccept = false;
+        bool replayed = false;   // Idempotent-Replayed: true
+    };
+
+    struct Connection {
+        QByteArray buffer;
+        bool busy = false;       // one request at a time; pipelined ones wait in buffer
+        bool closeAfter = false;
+    };
+
+    struct RouteStats {
+        quint64 requests = 0;
+        quint64 errors = 0;
+        quint64 resets = 0;
+        quint64 dripped = 0;
+    };
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, Connection> m_connections;
+
+    StandinBank m_bank;
+    int m_historyPerAccount = 250;
+    FaultPlan m_plan;
+    QHash<QString, quint64> m_routeSequence; // per route request counter -> fault RNG stream
+    QMap<QString, RouteStats> m_stats;
+
+    QString m_imageDir;
+    QHash<QString, QByteArray> m_generatedImages;
+    bool m_verbose = false;
+
+    void onNewConnection();
+    void processBuffer(QTcpSocket* socket);
+    void handle(QTcpSocket* socket, const Request& request);
+    void finishExchange(QTcpSocket* socket);
+
+    // route = "METHOD /template" (FaultPlan key, HEAD counts as GET)
+    Response dispatch(const Request& request, const QString& route);
+    Response control(const Request& request);
+    Response image(const QString& filename);
+
+    QByteArray serialize(const Request& request, const Response& response) const;
+    void writeDripped(QTcpSocket* socket, const QByteArray& bytes, int offset,
+                      const RouteFaults& faults, int resetAt);
+    void resetConnection(QTcpSocket* socket);
+
+    static Response json(const StandinBank::Result& result);
+    static Response jsonError(int status, const QString& message);
+    static QByteArray reasonPhrase(int status);
+};
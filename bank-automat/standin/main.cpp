@@ -0,0 +1,69 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+
+#include "FaultPlan.h"
+#include "StandinServer.h"
+
+// bank-automat-standin: the backend REST contract on one port, no Node or MySQL.
+//   bank-automat-standin --port 3000 --faults standin/faults.example.json
+// then run the client with BANK_AUTOMAT_API_URL=http://127.0.0.1:3000
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bank-automat-standin");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Deterministic stand-in for the bank-automat backend with fault injection.");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption({ "p", "port" }, "TCP port (0 = any free port, printed on start).", "port", "3000");
+    QCommandLineOption bindOption("bind", "Address to listen on.", "address", "127.0.0.1");
+    QCommandLineOption faultsOption({ "f", "faults" }, "Fault plan (JSON, see faults.example.json).", "file");
+    QCommandLineOption seedOption("seed", "Overrides the fault plan seed (history and fault sequences).", "n");
+    QCommandLineOption historyOption("history", "Generated transactions per account.", "rows", "250");
+    QCommandLineOption imagesOption("images", "Directory served as /images/uploads/ (missing files are generated).", "dir");
+    QCommandLineOption verboseOption({ "v", "verbose" }, "Log every request with its injected faults.");
+    parser.addOptions({ portOption, bindOption, faultsOption, seedOption, historyOption, imagesOption, verboseOption });
+    parser.process(app);
+
+    QJsonObject planJson;
+    if (parser.isSet(faultsOption)) {
+        QFile f(parser.value(faultsOption));
+        if (!f.open(QIODevice::ReadOnly)) {
+            qCritical("Cannot open %s", qPrintable(f.fileName()));
+            return 1;
+        }
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &parseError);
+        if (!doc.isObject()) {
+            qCritical("%s: %s", qPrintable(f.fileName()), qPrintable(parseError.errorString()));
+            return 1;
+        }
+        planJson = doc.object();
+    }
+    if (parser.isSet(seedOption)) planJson["seed"] = parser.value(seedOption).toLongLong();
+
+    QString planError;
+    const FaultPlan plan = FaultPlan::fromJson(planJson, &planError);
+    if (!planError.isEmpty()) {
+        qCritical("Fault plan: %s", qPrintable(planError));
+        return 1;
+    }
+
+    StandinServer server;
+    server.setFaultPlan(plan);
+    server.setHistoryPerAccount(parser.value(historyOption).toInt());
+    server.setImageDir(parser.value(imagesOption));
+    server.setVerbose(parser.isSet(verboseOption));
+
+    if (!server.listen(QHostAddress(parser.value(bindOption)), quint16(parser.value(portOption).toUInt()))) {
+        qCritical("Cannot listen: %s", qPrintable(server.errorString()));
+        return 1;
+    }
+    qInfo("bank-automat-standin listening on http://%s:%u (seed %u)",
+          qPrintable(parser.value(bindOption)), server.serverPort(), plan.seed());
+
+    return app.exec();
+}
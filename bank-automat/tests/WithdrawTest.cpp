@@ -0,0 +1,249 @@
+// Withdrawal idempotency and settlement, against the stand-in backend (no Node or MySQL).
+//
+//   bank-automat-withdraw-test              or: ctest -R withdraw
+//
+// The StandinBank cases pin down the rules the backend's withdraw_requests table
+// implements; the ApiClient cases run the client over HTTP with a FaultPlan that
+// loses the replies.
+
+#include "ApiClient.h"
+#include "WithdrawOutbox.h"
+#include "standin/FaultPlan.h"
+#include "standin/StandinBank.h"
+#include "standin/StandinServer.h"
+
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const int ACCOUNT = 2001; // debit, 1000.00 in the seed
+static const QString KEY = QStringLiteral("test-key-0001");
+
+static double balanceOf(const StandinBank &bank, int accountId)
+{
+    return bank.balance(accountId).body.toObject().value("balance").toVariant().toDouble();
+}
+
+class WithdrawTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    // StandinBank rules
+    void sameKeyReplaysFirstAnswer();
+    void keyReusedForAnotherAmount();
+    void cancelBeforePost();
+    void cancelAfterPost();
+    void reverseCreditsOnce();
+
+    // ApiClient over HTTP
+    void lostRepliesResolvedWhileWaiting();
+    void cancelledWithdrawalCreditedBack();
+    void unansweredCancelLeftForReconcile();
+
+private:
+    StandinBank m_bank;
+
+    QTemporaryDir *m_dir = nullptr;
+    StandinServer *m_server = nullptr;
+    WithdrawOutbox *m_outbox = nullptr;
+    ApiClient *m_api = nullptr;
+
+    void startServer(const QJsonObject &faults);
+    double fetchBalance(int accountId);
+};
+
+void WithdrawTest::init()
+{
+    m_bank.reset(1, 0);
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+}
+
+void WithdrawTest::cleanup()
+{
+    delete m_api;
+    delete m_outbox;
+    delete m_server;
+    delete m_dir;
+    m_api = nullptr;
+    m_outbox = nullptr;
+    m_server = nullptr;
+    m_dir = nullptr;
+}
+
+void WithdrawTest::startServer(const QJsonObject &faults)
+{
+    QString error;
+    const FaultPlan plan = FaultPlan::fromJson(faults, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+
+    m_server = new StandinServer;
+    m_server->setFaultPlan(plan);
+    m_server->setHistoryPerAccount(0);
+    QVERIFY(m_server->listen(QHostAddress::LocalHost, 0));
+
+    m_outbox = new WithdrawOutbox(m_dir->filePath("withdraw-outbox.jsonl"));
+    QVERIFY(m_outbox->open(&error));
+
+    m_api = new ApiClient;
+    m_api->setBaseUrl(QString("http://127.0.0.1:%1").arg(m_server->serverPort()));
+    m_api->setWithdrawOutbox(m_outbox);
+}
+
+double WithdrawTest::fetchBalance(int accountId)
+{
+    double balance = -1;
+    bool done = false;
+    m_api->getBalance(accountId, this, [&](bool ok, Balance data, QString /*error*/) {
+        if (ok) balance = data.balanceCents / 100.0;
+        done = true;
+    });
+    if (!QTest::qWaitFor([&done]() { return done; }, 5000)) return -1;
+    return balance;
+}
+
+void WithdrawTest::sameKeyReplaysFirstAnswer()
+{
+    const QJsonObject body{ { "amount", 50 } };
+    const StandinBank::Result first = m_bank.withdraw(ACCOUNT, body, true, KEY);
+    QCOMPARE(first.status, 200);
+    QVERIFY(!first.replayed);
+
+    const StandinBank::Result again = m_bank.withdraw(ACCOUNT, body, true, KEY);
+    QCOMPARE(again.status, 200);
+    QVERIFY(again.replayed);
+    QCOMPARE(again.body, first.body);
+    QCOMPARE(balanceOf(m_bank, ACCOUNT), 950.0);
+}
+
+void WithdrawTest::keyReusedForAnotherAmount()
+{
+    QCOMPARE(m_bank.withdraw(ACCOUNT, QJsonObject{ { "amount", 50 } }, true, KEY).status, 200);
+    QCOMPARE(m_bank.withdraw(ACCOUNT, QJsonObject{ { "amount", 100 } }, true, KEY).status, 422);
+    QCOMPARE(balanceOf(m_bank, ACCOUNT), 950.0);
+}
+
+void WithdrawTest::cancelBeforePost()
+{
+    const QJsonObject cancelled = m_bank.cancelWithdrawal(ACCOUNT, KEY).body.toObject();
+    QCOMPARE(cancelled.value("state").toString(), QStringLiteral("cancelled"));
+
+    // The POST still on its way is refused and charges nothing
+    const StandinBank::Result late = m_bank.withdraw(ACCOUNT, QJsonObject{ { "amount", 50 } }, true, KEY);
+    QCOMPARE(late.status, 410);
+    QCOMPARE(balanceOf(m_bank, ACCOUNT), 1000.0);
+}
+
+void WithdrawTest::cancelAfterPost()
+{
+    const StandinBank::Result done = m_bank.withdraw(ACCOUNT, QJsonObject{ { "amount", 50 } }, true, KEY);
+    QCOMPARE(done.status, 200);
+
+    const QJsonObject outcome = m_bank.cancelWithdrawal(ACCOUNT, KEY).body.toObject();
+    QCOMPARE(outcome.value("state").toString(), QStringLiteral("completed"));
+    QCOMPARE(outcome.value("status").toInt(), 200);
+    QCOMPARE(outcome.value("response"), done.body);
+    QCOMPARE(balanceOf(m_bank, ACCOUNT), 950.0);
+}
+
+void WithdrawTest::reverseCreditsOnce()
+{
+    QCOMPARE(m_bank.reverseWithdrawal(ACCOUNT, KEY).status, 404);
+
+    QCOMPARE(m_bank.withdraw(ACCOUNT, QJsonObject{ { "amount", 50 } }, true, KEY).status, 200);
+    for (int i = 0; i < 2; ++i) {
+        const QJsonObject reversed = m_bank.reverseWithdrawal(ACCOUNT, KEY).body.toObject();
+        QCOMPARE(reversed.value("state").toString(), QStringLiteral("reversed"));
+        QCOMPARE(balanceOf(m_bank, ACCOUNT), 1000.0);
+    }
+    QCOMPARE(m_bank.cancelWithdrawal(ACCOUNT, KEY).body.toObject().value("state").toString(),
+             QStringLiteral("reversed"));
+}
+
+// Every attempt is processed but its reply lost: the client asks right away and
+// gets the withdrawal after all, charged once
+void WithdrawTest::lostRepliesResolvedWhileWaiting()
+{
+    startServer(QJsonObject{ { "routes", QJsonObject{
+        { "POST /accounts/:id/withdraw", QJsonObject{ { "reset", QJsonObject{ { "rate", 1 } } } } },
+    } } });
+    if (QTest::currentTestFailed()) return;
+
+    bool done = false;
+    bool ok = false;
+    QJsonObject data;
+    m_api->withdraw(ACCOUNT, 50, this, [&](bool replyOk, QJsonObject reply, QString /*error*/) {
+        ok = replyOk;
+        data = reply;
+        done = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(done, 20000);
+
+    QVERIFY(ok);
+    QCOMPARE(data.value("balance").toDouble(), 950.0);
+    QVERIFY(m_outbox->pending().isEmpty());
+    QCOMPARE(fetchBalance(ACCOUNT), 950.0);
+}
+
+// The caller gives up but the bank completes it: nobody pays out, so it is credited back
+void WithdrawTest::cancelledWithdrawalCreditedBack()
+{
+    startServer(QJsonObject{ { "routes", QJsonObject{
+        { "POST /accounts/:id/withdraw", QJsonObject{ { "latency", QJsonObject{ { "fixed", 200 } } } } },
+    } } });
+    if (QTest::currentTestFailed()) return;
+    QSignalSpy reconciled(m_api, &ApiClient::withdrawalReconciled);
+
+    bool called = false;
+    const ApiClient::RequestId id = m_api->withdraw(ACCOUNT, 50, this, [&](bool, QJsonObject, QString) {
+        called = true;
+    });
+    m_api->cancel(id);
+
+    QTRY_COMPARE_WITH_TIMEOUT(reconciled.count(), 1, 10000);
+    QCOMPARE(reconciled.at(0).at(1).toString(), QStringLiteral("reversed"));
+    QVERIFY(!called);
+    QVERIFY(m_outbox->pending().isEmpty());
+    QCOMPARE(fetchBalance(ACCOUNT), 1000.0);
+}
+
+// Neither the attempts nor the cancel are answered: the customer is told, the intent
+// stays in the outbox and is credited back once the bank can be reached
+void WithdrawTest::unansweredCancelLeftForReconcile()
+{
+    startServer(QJsonObject{ { "routes", QJsonObject{
+        { "POST /accounts/:id/withdraw", QJsonObject{ { "reset", QJsonObject{ { "rate", 1 } } } } },
+        { "POST /accounts/:id/withdrawals/:key/cancel", QJsonObject{ { "errorRate", 1 } } },
+    } } });
+    if (QTest::currentTestFailed()) return;
+
+    bool done = false;
+    bool ok = true;
+    m_api->withdraw(ACCOUNT, 50, this, [&](bool replyOk, QJsonObject, QString) {
+        ok = replyOk;
+        done = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(done, 20000);
+    QVERIFY(!ok);
+    QCOMPARE(m_outbox->pending().size(), 1);
+
+    // Bank reachable again (same state, no faults)
+    m_server->setFaultPlan(FaultPlan());
+    QSignalSpy reconciled(m_api, &ApiClient::withdrawalReconciled);
+    m_api->reconcileWithdrawals();
+
+    QTRY_COMPARE_WITH_TIMEOUT(reconciled.count(), 1, 10000);
+    QCOMPARE(reconciled.at(0).at(1).toString(), QStringLiteral("reversed"));
+    QVERIFY(m_outbox->pending().isEmpty());
+    QCOMPARE(fetchBalance(ACCOUNT), 1000.0);
+}
+
+QTEST_GUILESS_MAIN(WithdrawTest)
+
+#include "WithdrawTest.moc"
@@ -103,6 +103,33 @@ CREATE TABLE IF NOT EXISTS transactions (
   INDEX idx_tx_created_id (created_at, id)
 ) ENGINE=InnoDB;
 
+-- -------------------------
+-- withdraw_requests (idempotency keys)
+-- One row per Idempotency-Key of a withdrawal, written in the same transaction as the
+-- withdrawal (or refusal), so a retried request gets the first answer back.
+-- amount NULL = key cancelled by reconciliation before any withdrawal used it.
+-- reversed_at = completed withdrawal credited back because the kiosk never paid it out.
+-- Rows are only needed while a kiosk may still retry or reconcile; the backend deletes
+-- them after WITHDRAW_KEY_RETENTION_DAYS (backend/prune.js).
+-- -------------------------
+CREATE TABLE IF NOT EXISTS withdraw_requests (
+  account_id       INT NOT NULL,
+  idempotency_key  VARCHAR(64) NOT NULL,
+  amount           DECIMAL(12,2) NULL,
+  status_code      SMALLINT NOT NULL,
+  response_body    TEXT NOT NULL,
+  created_at       TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  reversed_at      TIMESTAMP NULL,
+
+  PRIMARY KEY (account_id, idempotency_key),
+
+  CONSTRAINT fk_withdraw_requests_account
+    FOREIGN KEY (account_id) REFERENCES accounts(id)
+    ON DELETE RESTRICT ON UPDATE CASCADE,
+
+  INDEX idx_wr_created (created_at)
+) ENGINE=InnoDB;
+
 -- ============================================
 -- "Migrations": add missing columns/indexes
 -- (safe to re-run on existing DB)
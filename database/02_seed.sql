@@ -20,6 +20,7 @@ SET FOREIGN_KEY_CHECKS = 0;
 
 -- Remove dependent rows first (transactions -> card_accounts -> cards -> accounts -> customers)
 DELETE FROM transactions WHERE account_id IN (2001, 2002, 2003, 2004);
+DELETE FROM withdraw_requests WHERE account_id IN (2001, 2002, 2003, 2004);
 DELETE FROM card_accounts WHERE card_id IN (1001, 1002, 1003);
 DELETE FROM cards WHERE id IN (1001, 1002, 1003);
 DELETE FROM accounts WHERE id IN (2001, 2002, 2003, 2004);